@@ -41,6 +41,7 @@
 #include "engine.h"
 #include "fen.h"
 #include "game.h"
+#include "gameindex.h"
 #include "io.h"
 #include "line.h"
 #include "main.h"
@@ -49,6 +50,7 @@
 #include "move_legal.h"
 #include "option.h"
 #include "parse.h"
+#include "posix.h"
 #include "san.h"
 #include "uci.h"
 #include "util.h"
@@ -75,6 +77,8 @@ struct state_t {
    int exp_move;
    int resign_nb;
    my_timer_t timer[1];
+   bool pv_pending; // a PV is held back by "PVDelay"
+   double pv_time; // when the last PV was sent
 };
 
 struct xb_t {
@@ -167,11 +171,13 @@ void adapter_loop() {
    State->exp_move = MoveNone;
    State->resign_nb = 0;
    my_timer_reset(State->timer);
+   State->pv_pending = false;
+   State->pv_time = 0.0;
 
    // xboard
 
-   XBoard->io->in_fd = pipefd_f2a[0];
-   XBoard->io->out_fd = pipefd_a2f[1];
+   XBoard->io->in_queue = queue_f2a;
+   XBoard->io->out_queue = queue_a2f;
    XBoard->io->name = "XBOARD";
 
    io_init(XBoard->io);
@@ -230,17 +236,17 @@ static void adapter_step() {
 
    // add xboard input
 
-   ASSERT(XBoard->io->in_fd>=0);
+   ASSERT(XBoard->io->in_queue!=NULL);
 
-   FD_SET(XBoard->io->in_fd,set);
-   if (XBoard->io->in_fd > fd_max) fd_max = XBoard->io->in_fd;
+   FD_SET(queue_fd(XBoard->io->in_queue),set);
+   if (queue_fd(XBoard->io->in_queue) > fd_max) fd_max = queue_fd(XBoard->io->in_queue);
 
    // add engine input
 
-   ASSERT(Engine->io->in_fd>=0);
+   ASSERT(Engine->io->in_queue!=NULL);
 
-   FD_SET(Engine->io->in_fd,set);
-   if (Engine->io->in_fd > fd_max) fd_max = Engine->io->in_fd;
+   FD_SET(queue_fd(Engine->io->in_queue),set);
+   if (queue_fd(Engine->io->in_queue) > fd_max) fd_max = queue_fd(Engine->io->in_queue);
 
    // wait for something to read (no timeout)
 
@@ -250,8 +256,9 @@ static void adapter_step() {
    if (val == -1 && errno != EINTR) my_fatal("adapter_step(): select(): %s\n",strerror(errno));
 
    if (val > 0) {
-      if (FD_ISSET(XBoard->io->in_fd,set)) io_get_update(XBoard->io); // read some xboard input
-      if (FD_ISSET(Engine->io->in_fd,set)) io_get_update(Engine->io); // read some engine input
+      // the descriptors may be readable with nothing queued, check before reading
+      if (FD_ISSET(queue_fd(XBoard->io->in_queue),set) && queue_ready(XBoard->io->in_queue)) io_get_update(XBoard->io); // read some xboard input
+      if (FD_ISSET(queue_fd(Engine->io->in_queue),set) && queue_ready(Engine->io->in_queue)) io_get_update(Engine->io); // read some engine input
    }
 }
 
@@ -736,6 +743,16 @@ static void xboard_step() {
 
       }
 
+   } else if (match(string,"games")) { // position index lookup (GNU Chess frontend)
+
+      game_get_board(Game,board);
+      gameindex_disp(board,NULL);
+
+   } else if (match(string,"games *")) {
+
+      game_get_board(Game,board);
+      gameindex_disp(board,Star[0]);
+
    } else if (match(string,"hashon")) { // hash on command (from GNU Chess v5)
 
       engine_send(Engine,"hashon");
@@ -797,12 +814,12 @@ static void xboard_step() {
 
 static void engine_step() {
 
-   char string[StringSize];
+   const char * string;
    int event;
 
    // parse UCI line
 
-   engine_get(Engine,string,StringSize);
+   engine_get_view(Engine,&string);
    event = uci_parse(Uci,string);
 
    // react to events
@@ -843,9 +860,19 @@ static void engine_step() {
 
    if ((event & EVENT_PV) != 0) {
 
-      // the engine has sent a new PV
+      // the engine has sent a new PV, it can be coalesced with the next ones
 
-      send_pv();
+      State->pv_pending = true;
+   }
+
+   if (State->pv_pending && State->state != WAIT) {
+
+      // the final PV is always sent with the move
+
+      if ((event & EVENT_MOVE) != 0
+       || now_real() - State->pv_time >= double(option_get_int("PVDelay")) / 1000.0) {
+         send_pv();
+      }
    }
 }
 
@@ -1233,6 +1260,8 @@ static void search_clear() {
 
    uci_clear(Uci);
 
+   State->pv_pending = false;
+
    // TODO: MOVE ME
 
    my_timer_reset(State->timer);
@@ -1423,6 +1452,9 @@ static void send_pv() {
 
    ASSERT(State->state!=WAIT);
 
+   State->pv_pending = false;
+   State->pv_time = now_real();
+
    if (Uci->best_depth == 0) return;
 
    // xboard search information
@@ -1513,6 +1545,7 @@ static void learn(int result) {
    int pos;
    board_t board[1];
    int move;
+   int i;
 
    ASSERT(result>=-1&&result<=+1);
 
@@ -1542,14 +1575,17 @@ static void learn(int result) {
       my_log("POLYGLOT *LEARN DRAW*\n");
    }
 
-   // loop
+   // loop, replaying the game once
 
-   for (; pos < Game->size; pos += 2) {
+   game_get_board(Game,board,0);
 
-      game_get_board(Game,board,pos);
-      move = game_move(Game,pos);
+   for (i = 0; i < Game->size; i++) {
+
+      move = game_move(Game,i);
 
-      book_learn_move(board,move,result);
+      if (i % 2 == pos) book_learn_move(board,move,result);
+
+      move_do(board,move);
    }
 
    book_flush();
@@ -27,6 +27,10 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "board.h"
 #include "book.h"
@@ -34,33 +38,56 @@
 #include "move_legal.h"
 #include "san.h"
 #include "util.h"
+#include "polybook.h"
 
 namespace adapter {
 
+// constants
+
+// learning journal, "<book>.learn": 16-byte records appended under an
+// exclusive flock(), merged into the book when it is opened for learning
+
+static const int JournalRecordSize = 16;
+static const int JournalBufferSize = 1024; // records
+
+static const int JournalLearn  = 'L'; // n and sum are increments
+static const int JournalSet    = 'S'; // n and sum are the new values
+static const int JournalCommit = 'C'; // key = number of preceding S records
+
 // types
 
-struct entry_t {
+struct record_t {
+   int type;
    uint64 key;
-   uint16 move;
-   uint16 count;
-   uint16 n;
-   uint16 sum;
+   int move;
+   int n;
+   int sum;
 };
 
 // variables
 
-static FILE * BookFile;
-static int BookSize;
+static polybook_t Book[1];
+
+static int JournalFd;
+static char JournalName[256];
+static uint8 JournalBuffer[JournalBufferSize*JournalRecordSize];
+static int JournalNb;
 
 // prototypes
 
-static int    find_pos      (uint64 key);
+static void   journal_open    (const char book_name[]);
+static void   journal_close   ();
+static void   journal_add     (const record_t * record);
+static void   journal_write   ();
+static void   journal_compact (const char book_name[]);
 
-static void   read_entry    (entry_t * entry, int n);
-static void   write_entry   (const entry_t * entry, int n);
+static void   journal_lock  (int operation);
+static size_t journal_find  (const polybook_t * book, uint64 key, int move);
+static void   journal_apply (polybook_t * book, const record_t * record);
 
-static uint64 read_integer  (FILE * file, int size);
-static void   write_integer (FILE * file, int size, uint64 n);
+static void   record_encode   (uint8 string[], const record_t * record);
+static bool   record_decode   (const uint8 string[], record_t * record);
+static int    record_compare  (const void * record_1, const void * record_2);
 
 // functions
 
@@ -68,8 +95,10 @@ static void   write_integer (FILE * file, int size, uint64 n);
 
 void book_clear() {
 
-   BookFile = NULL;
-   BookSize = 0;
+   polybook_clear(Book);
+
+   JournalFd = -1;
+   JournalNb = 0;
 }
 
 // book_open()
@@ -79,9 +108,7 @@ void book_open(const char file_name[], int mode) {
    ASSERT(file_name!=NULL);
    ASSERT(mode==BookReadOnly || mode==BookReadWrite);
 
-   const int MaxModeLength = 4;
    char full_file_name[MaxFileNameSize+1];
-   char file_open_mode[MaxModeLength]="";
    FILE *bf;
    if ( ( bf = fopen(file_name, "r") ) != NULL ) {
       fclose(bf);
@@ -92,49 +119,41 @@ void book_open(const char file_name[], int mode) {
    }
    strcat(full_file_name,file_name);
 
+   book_close();
+
+   // learning goes to the journal, merge what previous games left there
+
    if (mode == BookReadWrite) {
-      strcpy(file_open_mode,"rb+");
-   } else {
-      strcpy(file_open_mode,"rb");
-   }
-   BookFile = fopen(full_file_name,file_open_mode);
-   if (BookFile == NULL) {
-      if (fopen(full_file_name,"rb") != NULL) {
-         fclose(bf);
-         my_fatal("book_open(): file \"%s\" is read only\n",full_file_name);
-      } else {
-         my_fatal("book_open(): can't open file \"%s\": %s\n",full_file_name,strerror(errno));
-      }
+      journal_open(full_file_name);
+      journal_compact(full_file_name);
    }
 
-   if (fseek(BookFile,0,SEEK_END) == -1) {
-      my_fatal("book_open(): fseek(): %s\n",strerror(errno));
+   if (polybook_open(Book,full_file_name,POLYBOOK_INDEX) == -1) {
+      my_fatal("book_open(): can't open file \"%s\": %s\n",full_file_name,strerror(errno));
    }
 
-   BookSize = ftell(BookFile) / 16;
-   if (BookSize == 0) my_fatal("book_open(): empty file\n");
+   if (Book->size == 0) my_fatal("book_open(): empty file\n");
 }
 
 // book_close()
 
 void book_close() {
 
-   if (fclose(BookFile) == EOF) {
-      my_fatal("book_close(): fclose(): %s\n",strerror(errno));
-   }
+   polybook_close(Book);
+   journal_close();
 }
 
 // is_in_book()
 
 bool is_in_book(const board_t * board) {
 
-   int pos;
-   entry_t entry[1];
+   size_t pos;
+   polybook_entry_t entry[1];
 
    ASSERT(board!=NULL);
 
-   for (pos = find_pos(board->key); pos < BookSize; pos++) {
-      read_entry(entry,pos);
+   for (pos = polybook_find(Book,board->key); pos < Book->size; pos++) {
+      polybook_read(Book,pos,entry);
       if (entry->key == board->key) return true;
    }
 
@@ -147,8 +166,8 @@ int book_move(const board_t * board, bool random) {
 
    int best_move;
    int best_score;
-   int pos;
-   entry_t entry[1];
+   size_t pos;
+   polybook_entry_t entry[1];
    int move;
    int score;
 
@@ -158,9 +177,9 @@ int book_move(const board_t * board, bool random) {
    best_move = MoveNone;
    best_score = 0;
 
-   for (pos = find_pos(board->key); pos < BookSize; pos++) {
+   for (pos = polybook_find(Book,board->key); pos < Book->size; pos++) {
 
-      read_entry(entry,pos);
+      polybook_read(Book,pos,entry);
       if (entry->key != board->key) break;
 
       move = entry->move;
@@ -199,8 +218,8 @@ int book_move(const board_t * board, bool random, bool worst) {
    int worst_score;
    int best_move;
    int best_score;
-   int pos;
-   entry_t entry[1];
+   size_t pos;
+   polybook_entry_t entry[1];
    int move;
    int score;
 
@@ -213,9 +232,9 @@ int book_move(const board_t * board, bool random, bool worst) {
    best_move = MoveNone;
    best_score = 0;
 
-   for (pos = find_pos(board->key); pos < BookSize; pos++) {
+   for (pos = polybook_find(Book,board->key); pos < Book->size; pos++) {
 
-      read_entry(entry,pos);
+      polybook_read(Book,pos,entry);
       if (entry->key != board->key) break;
 
       move = entry->move;
@@ -259,25 +278,25 @@ int book_move(const board_t * board, bool random, bool worst) {
 
 void book_disp(const board_t * board) {
 
-   int first_pos;
+   size_t first_pos;
    int sum;
-   int pos;
-   entry_t entry[1];
+   size_t pos;
+   polybook_entry_t entry[1];
    int move;
    int score;
    char move_string[256];
 
    ASSERT(board!=NULL);
 
-   first_pos = find_pos(board->key);
+   first_pos = polybook_find(Book,board->key);
 
    // sum
 
    sum = 0;
 
-   for (pos = first_pos; pos < BookSize; pos++) {
+   for (pos = first_pos; pos < Book->size; pos++) {
 
-      read_entry(entry,pos);
+      polybook_read(Book,pos,entry);
       if (entry->key != board->key) break;
 
       sum += entry->count;
@@ -285,9 +304,9 @@ void book_disp(const board_t * board) {
 
    // disp
 
-   for (pos = first_pos; pos < BookSize; pos++) {
+   for (pos = first_pos; pos < Book->size; pos++) {
 
-      read_entry(entry,pos);
+      polybook_read(Book,pos,entry);
       if (entry->key != board->key) break;
 
       move = entry->move;
@@ -300,14 +319,16 @@ void book_disp(const board_t * board) {
    }
 
    printf("\n");
+   fflush(stdout);
 }
 
 // book_learn_move()
 
 void book_learn_move(const board_t * board, int move, int result) {
 
-   int pos;
-   entry_t entry[1];
+   size_t pos;
+   polybook_entry_t entry[1];
+   record_t record[1];
 
    ASSERT(board!=NULL);
    ASSERT(move_is_ok(move));
@@ -315,17 +336,20 @@ void book_learn_move(const board_t * board, int move, int result) {
 
    ASSERT(move_is_legal(move,board));
 
-   for (pos = find_pos(board->key); pos < BookSize; pos++) {
+   for (pos = polybook_find(Book,board->key); pos < Book->size; pos++) {
 
-      read_entry(entry,pos);
+      polybook_read(Book,pos,entry);
       if (entry->key != board->key) break;
 
       if (entry->move == move) {
 
-         entry->n++;
-         entry->sum += result+1;
+         record->type = JournalLearn;
+         record->key = entry->key;
+         record->move = entry->move;
+         record->n = 1;
+         record->sum = result + 1;
 
-         write_entry(entry,pos);
+         journal_add(record);
 
          break;
       }
@@ -336,134 +360,378 @@ void book_learn_move(const board_t * board, int move, int result) {
 
 void book_flush() {
 
-   if (fflush(BookFile) == EOF) {
-      my_fatal("book_flush(): fflush(): %s\n",strerror(errno));
+   if (JournalFd != -1) journal_write();
+}
+
+// journal_open()
+
+static void journal_open(const char book_name[]) {
+
+   ASSERT(book_name!=NULL);
+
+   // the book itself must be writable for the journal to be merged
+
+   if (access(book_name,W_OK) == -1) {
+      if (errno == EACCES || errno == EROFS) {
+         my_fatal("book_open(): file \"%s\" is read only\n",book_name);
+      } else {
+         my_fatal("book_open(): can't open file \"%s\": %s\n",book_name,strerror(errno));
+      }
    }
+
+   if (strlen(book_name) + 7 > sizeof(JournalName)) {
+      my_fatal("journal_open(): file name too long: \"%s\"\n",book_name);
+   }
+
+   sprintf(JournalName,"%s.learn",book_name);
+
+   JournalFd = open(JournalName,O_RDWR|O_CREAT|O_APPEND,0666);
+   if (JournalFd == -1) my_fatal("journal_open(): can't open file \"%s\": %s\n",JournalName,strerror(errno));
+
+   JournalNb = 0;
 }
 
-// find_pos()
+// journal_close()
 
-static int find_pos(uint64 key) {
+static void journal_close() {
 
-   int left, right, mid;
-   entry_t entry[1];
+   if (JournalFd == -1) return;
 
-   // binary search (finds the leftmost entry)
+   journal_write();
 
-   left = 0;
-   right = BookSize-1;
+   close(JournalFd);
+   JournalFd = -1;
+}
 
-   ASSERT(left<=right);
+// journal_add()
 
-   while (left < right) {
+static void journal_add(const record_t * record) {
 
-      mid = (left + right) / 2;
-      ASSERT(mid>=left&&mid<right);
+   ASSERT(record!=NULL);
 
-      read_entry(entry,mid);
+   if (JournalFd == -1) return; // book opened read only
 
-      if (key <= entry->key) {
-         right = mid;
-      } else {
-         left = mid+1;
+   if (JournalNb == JournalBufferSize) journal_write();
+   ASSERT(JournalNb<JournalBufferSize);
+
+   record_encode(&JournalBuffer[JournalNb*JournalRecordSize],record);
+   JournalNb++;
+}
+
+// journal_write()
+
+static void journal_write() {
+
+   struct stat st;
+   int size;
+
+   ASSERT(JournalFd!=-1);
+
+   if (JournalNb == 0) return;
+
+   journal_lock(LOCK_EX);
+
+   // cut a record torn by a crash, the lock makes us the only writer
+
+   if (fstat(JournalFd,&st) == -1) my_fatal("journal_write(): fstat(): %s\n",strerror(errno));
+
+   if (st.st_size % JournalRecordSize != 0) {
+      if (ftruncate(JournalFd,st.st_size-st.st_size%JournalRecordSize) == -1) {
+         my_fatal("journal_write(): ftruncate(): %s\n",strerror(errno));
       }
    }
 
-   ASSERT(left==right);
+   // one write() per game, appended as a whole
+
+   size = JournalNb * JournalRecordSize;
+
+   if (write(JournalFd,JournalBuffer,size) != size) {
+      my_fatal("journal_write(): write(): %s\n",strerror(errno));
+   }
 
-   read_entry(entry,left);
+   journal_lock(LOCK_UN);
 
-   return (entry->key == key) ? left : BookSize;
+   JournalNb = 0;
 }
 
-// read_entry()
+// journal_compact()
+
+static void journal_compact(const char book_name[]) {
+
+   struct stat st;
+   uint8 * buffer;
+   record_t * learn;
+   record_t record[1];
+   polybook_t book[1];
+   polybook_entry_t entry[1];
+   size_t entry_pos;
+   int size, pos, start;
+   int learn_nb, set_nb;
+   int i, j, k;
+   uint8 * set;
+
+   ASSERT(book_name!=NULL);
+   ASSERT(JournalFd!=-1);
 
-static void read_entry(entry_t * entry, int n) {
+   // the merge writes S records with the new values of the entries and a
+   // C record, syncs the journal, then the book, and only then empties
+   // the journal; a committed block found on open is simply applied
+   // again, so a crash at any point loses or doubles nothing
 
-   ASSERT(entry!=NULL);
-   ASSERT(n>=0&&n<BookSize);
+   journal_lock(LOCK_EX);
 
-   if (fseek(BookFile,n*16,SEEK_SET) == -1) {
-      my_fatal("read_entry(): fseek(): %s\n",strerror(errno));
+   if (fstat(JournalFd,&st) == -1) my_fatal("journal_compact(): fstat(): %s\n",strerror(errno));
+
+   size = int(st.st_size - st.st_size % JournalRecordSize);
+
+   if (size == 0) {
+      journal_lock(LOCK_UN);
+      return;
    }
 
-   entry->key   = read_integer(BookFile,8);
-   entry->move  = read_integer(BookFile,2);
-   entry->count = read_integer(BookFile,2);
-   entry->n     = read_integer(BookFile,2);
-   entry->sum   = read_integer(BookFile,2);
-}
+   buffer = (uint8 *) my_malloc(size);
+
+   if (pread(JournalFd,buffer,size,0) != size) my_fatal("journal_compact(): pread(): %s\n",strerror(errno));
+
+   polybook_clear(book);
+
+   if (polybook_open(book,book_name,POLYBOOK_WRITE) == -1) {
+      my_fatal("journal_compact(): can't open file \"%s\": %s\n",book_name,strerror(errno));
+   }
+
+   // redo committed blocks, collect the records learnt since the last one
 
-// write_entry()
+   learn = (record_t *) my_malloc((size/JournalRecordSize)*sizeof(record_t));
+   learn_nb = 0;
 
-static void write_entry(const entry_t * entry, int n) {
+   start = 0; // first S record of the current block
 
-   ASSERT(entry!=NULL);
-   ASSERT(n>=0&&n<BookSize);
+   for (pos = 0; pos < size; pos += JournalRecordSize) {
 
-   if (fseek(BookFile,n*16,SEEK_SET) == -1) {
-      my_fatal("write_entry(): fseek(): %s\n",strerror(errno));
+      if (!record_decode(&buffer[pos],record)) { // torn
+         start = pos + JournalRecordSize;
+         continue;
+      }
+
+      if (false) {
+      } else if (record->type == JournalLearn) {
+         learn[learn_nb++] = *record;
+         start = pos + JournalRecordSize;
+      } else if (record->type == JournalSet) {
+         // part of a block, checked by its C record
+      } else if (record->type == JournalCommit) {
+         if (record->key == uint64((pos - start) / JournalRecordSize)) {
+            for (i = start; i < pos; i += JournalRecordSize) {
+               record_decode(&buffer[i],record);
+               journal_apply(book,record);
+            }
+            learn_nb = 0;
+         }
+         start = pos + JournalRecordSize;
+      }
    }
 
-   write_integer(BookFile,8,entry->key);
-   write_integer(BookFile,2,entry->move);
-   write_integer(BookFile,2,entry->count);
-   write_integer(BookFile,2,entry->n);
-   write_integer(BookFile,2,entry->sum);
-}
+   my_free(buffer);
 
-// read_integer()
+   // fold the new records into one S record per entry, the book is not
+   // touched before the block is committed
 
-static uint64 read_integer(FILE * file, int size) {
+   qsort(learn,learn_nb,sizeof(record_t),&record_compare);
 
-   uint64 n;
-   int i;
-   int b;
+   set = (uint8 *) my_malloc((learn_nb+1)*JournalRecordSize);
+   set_nb = 0;
 
-   ASSERT(file!=NULL);
-   ASSERT(size>0&&size<=8);
+   for (i = 0; i < learn_nb; i = j) {
 
-   n = 0;
+      for (j = i; j < learn_nb && learn[j].key == learn[i].key && learn[j].move == learn[i].move; j++)
+         ;
 
-   for (i = 0; i < size; i++) {
+      entry_pos = journal_find(book,learn[i].key,learn[i].move);
+      if (entry_pos == book->size) continue; // not in this book
 
-      b = fgetc(file);
+      polybook_read(book,entry_pos,entry);
 
-      if (b == EOF) {
-         if (feof(file)) {
-            my_fatal("read_integer(): fgetc(): EOF reached\n");
-         } else { // error
-            my_fatal("read_integer(): fgetc(): %s\n",strerror(errno));
+      record->type = JournalSet;
+      record->key = entry->key;
+      record->move = entry->move;
+      record->n = entry->n;
+      record->sum = entry->sum;
+
+      for (k = i; k < j; k++) {
+         if (record->n + learn[k].n > 0xFFFF || record->sum + learn[k].sum > 0xFFFF) {
+            record->n /= 2; // keep the ratio
+            record->sum /= 2;
          }
+         record->n += learn[k].n;
+         record->sum += learn[k].sum;
+      }
+
+      record_encode(&set[(set_nb++)*JournalRecordSize],record);
+   }
+
+   my_free(learn);
+
+   if (set_nb != 0) {
+
+      record->type = JournalCommit;
+      record->key = set_nb;
+      record->move = 0;
+      record->n = 0;
+      record->sum = 0;
+
+      record_encode(&set[set_nb*JournalRecordSize],record);
+
+      if (write(JournalFd,set,(set_nb+1)*JournalRecordSize) != (set_nb+1)*JournalRecordSize) {
+         my_fatal("journal_compact(): write(): %s\n",strerror(errno));
       }
 
-      ASSERT(b>=0&&b<256);
-      n = (n << 8) | b;
+      if (fsync(JournalFd) == -1) my_fatal("journal_compact(): fsync(): %s\n",strerror(errno));
+
+      for (i = 0; i < set_nb; i++) {
+         record_decode(&set[i*JournalRecordSize],record);
+         journal_apply(book,record);
+      }
    }
 
-   return n;
+   my_free(set);
+
+   if (polybook_sync(book) == -1) my_fatal("journal_compact(): msync(): %s\n",strerror(errno));
+   polybook_close(book);
+
+   if (ftruncate(JournalFd,0) == -1) my_fatal("journal_compact(): ftruncate(): %s\n",strerror(errno));
+   if (fsync(JournalFd) == -1) my_fatal("journal_compact(): fsync(): %s\n",strerror(errno));
+
+   journal_lock(LOCK_UN);
+}
+
+// journal_lock()
+
+static void journal_lock(int operation) {
+
+   ASSERT(JournalFd!=-1);
+
+   while (flock(JournalFd,operation) == -1) {
+      if (errno != EINTR) my_fatal("journal_lock(): flock(): %s\n",strerror(errno));
+   }
+}
+
+// journal_find()
+
+static size_t journal_find(const polybook_t * book, uint64 key, int move) {
+
+   size_t pos;
+   polybook_entry_t entry[1];
+
+   ASSERT(book!=NULL);
+
+   for (pos = polybook_find(book,key); pos < book->size; pos++) {
+
+      polybook_read(book,pos,entry);
+      if (entry->key != key) break;
+
+      if (entry->move == move) return pos;
+   }
+
+   return book->size;
+}
+
+// journal_apply()
+
+static void journal_apply(polybook_t * book, const record_t * record) {
+
+   size_t pos;
+   polybook_entry_t entry[1];
+
+   ASSERT(book!=NULL);
+   ASSERT(record!=NULL);
+   ASSERT(record->type==JournalSet);
+
+   pos = journal_find(book,record->key,record->move);
+   if (pos == book->size) return; // the book was rebuilt
+
+   polybook_read(book,pos,entry);
+
+   entry->n = record->n;
+   entry->sum = record->sum;
+
+   polybook_write(book,pos,entry);
 }
 
-// write_integer()
+// record_encode()
 
-static void write_integer(FILE * file, int size, uint64 n) {
+static void record_encode(uint8 string[], const record_t * record) {
 
    int i;
-   int b;
+   int check;
+   uint64 key;
 
-   ASSERT(file!=NULL);
-   ASSERT(size>0&&size<=8);
-   ASSERT(size==8||n>>(size*8)==0);
+   ASSERT(string!=NULL);
+   ASSERT(record!=NULL);
+   ASSERT(record->n>=0&&record->n<=0xFFFF);
+   ASSERT(record->sum>=0&&record->sum<=0xFFFF);
 
-   for (i = size-1; i >= 0; i--) {
+   string[0] = record->type;
+   string[2] = record->move >> 8;
+   string[3] = record->move & 0xFF;
+   string[4] = record->n >> 8;
+   string[5] = record->n & 0xFF;
+   string[6] = record->sum >> 8;
+   string[7] = record->sum & 0xFF;
 
-      b = (n >> (i*8)) & 0xFF;
-      ASSERT(b>=0&&b<256);
+   key = record->key;
 
-      if (fputc(b,file) == EOF) {
-         my_fatal("write_integer(): fputc(): %s\n",strerror(errno));
-      }
+   for (i = 15; i >= 8; i--) {
+      string[i] = key & 0xFF;
+      key >>= 8;
+   }
+
+   check = 0x5A;
+   for (i = 0; i < JournalRecordSize; i++) {
+      if (i != 1) check += string[i];
    }
+
+   string[1] = check & 0xFF;
+}
+
+// record_decode()
+
+static bool record_decode(const uint8 string[], record_t * record) {
+
+   int i;
+   int check;
+
+   ASSERT(string!=NULL);
+   ASSERT(record!=NULL);
+
+   check = 0x5A;
+   for (i = 0; i < JournalRecordSize; i++) {
+      if (i != 1) check += string[i];
+   }
+
+   if ((check & 0xFF) != string[1]) return false;
+
+   record->type = string[0];
+   record->move = (string[2] << 8) | string[3];
+   record->n    = (string[4] << 8) | string[5];
+   record->sum  = (string[6] << 8) | string[7];
+
+   record->key = 0;
+   for (i = 8; i < 16; i++) record->key = (record->key << 8) | string[i];
+
+   return record->type == JournalLearn || record->type == JournalSet || record->type == JournalCommit;
+}
+
+// record_compare()
+
+static int record_compare(const void * record_1, const void * record_2) {
+
+   const record_t * r1 = (const record_t *) record_1;
+   const record_t * r2 = (const record_t *) record_2;
+
+   if (r1->key < r2->key) return -1;
+   if (r1->key > r2->key) return +1;
+
+   return r1->move - r2->move;
 }
 
 }  // namespace adapter
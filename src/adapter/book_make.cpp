@@ -28,9 +28,15 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "board.h"
 #include "book_make.h"
+#include "colour.h"
+#include "fen.h"
+#include "gamedb.h"
+#include "gameindex.h"
 #include "move.h"
 #include "move_do.h"
 #include "move_legal.h"
@@ -47,6 +53,11 @@ static const int COUNT_MAX = 16384;
 
 static const int NIL = -1;
 
+static const int JobMax = 64;
+
+static const sint64 RoundSize = 16 * 1048576; // bytes of PGN per job and round
+static const sint64 RoundSizeMin = 65536;
+
 // types
 
 struct entry_t {
@@ -65,6 +76,44 @@ struct book_t {
    sint32 * hash;
 };
 
+struct total_t {
+   uint64 key;
+   uint16 move;
+   uint16 colour;
+   uint32 n;
+   uint32 sum;
+};
+
+struct run_t {
+   FILE * file;
+   entry_t entry; // next entry, in (key,move) order
+};
+
+struct record_t {
+   uint64 key;
+   uint16 move;
+   sint8 colour;
+   sint8 result;
+   sint32 game; // in the job, for the position index
+};
+
+struct part_t {
+   int size;
+   int alloc;
+   record_t * record;
+};
+
+struct job_t {
+   pthread_t thread;
+   sint64 start;
+   sint64 end;
+   int game_nb;
+   part_t part[JobMax]; // moves parsed by this job, one part per shard
+   book_t book[1]; // shard merged by this job
+   FILE * index_run; // positions of the games, sorted
+   int index_size;
+};
+
 // variables
 
 static int MaxPly;
@@ -73,26 +122,67 @@ static double MinScore;
 static bool RemoveWhite, RemoveBlack;
 static bool Uniform;
 
+static int JobNb;
+static sint64 MemoryMax;
+
+static const char * BinFile;
+static const char * IndexFile; // NULL if there is no position index
+
 static book_t Book[1];
+static bool UseDb; // the input is a game database
+static pgn_t Pgn[1]; // input file, shared by the jobs
+static gamedb_t Db[1];
+static job_t Job[JobMax];
+
+static int RunNb; // sorted runs spilled to temporary files
+static run_t * Run;
+static int * Heap; // runs ordered by their next entry
+static int HeapSize;
+
+static int IndexRunNb;
+static gameindex_run_t * IndexRun;
+static sint64 IndexSize; // number of items in the runs
 
 // prototypes
 
-static void   book_clear    ();
+static void   book_clear    (book_t * book);
 static void   book_insert   (const char file_name[]);
+static void   book_gather   ();
+static sint64 book_memory   ();
+static void   book_spill    ();
+static void   run_merge     (const char file_name[]);
 static void   book_filter   ();
 static void   book_sort     ();
 static void   book_save     (const char file_name[]);
 
-static int    find_entry    (const board_t * board, int move);
-static void   resize        ();
-static void   halve_stats   (uint64 key);
+static void   run_jobs      (void * (*func)(void *));
+static void * job_parse     (void * arg);
+static void * job_read      (void * arg);
+static void * job_merge     (void * arg);
+static void   job_index     (job_t * job);
+
+static void   part_add      (part_t * part, const board_t * board, int move, int result, int game);
+
+static sint64 find_game     (sint64 pos, sint64 end);
+
+static int    find_entry    (book_t * book, uint64 key, int move, int colour);
+static void   resize        (book_t * book);
+static void   halve_stats   (book_t * book, uint64 key);
+
+static void   run_next      (int run);
+static void   heap_down     (int pos);
 
-static bool   keep_entry    (int pos);
+static int    total_add     (total_t * total, int size, const entry_t * entry);
+static int    total_save    (FILE * file, total_t * total, entry_t * entry, int size);
+
+static bool   keep_entry    (const entry_t * entry);
 
 static int    entry_score    (const entry_t * entry);
 
 static int    key_compare   (const void * p1, const void * p2);
+static int    move_compare  (const void * p1, const void * p2);
 
+static void   write_entry   (FILE * file, const entry_t * entry);
 static void   write_integer (FILE * file, int size, uint64 n);
 
 // functions
@@ -117,6 +207,9 @@ void book_make(int argc, char * argv[]) {
    RemoveWhite = false;
    RemoveBlack = false;
    Uniform = false;
+   JobNb = 1;
+   MemoryMax = 0;
+   IndexFile = NULL;
 
    for (i = 1; i < argc; i++) {
 
@@ -178,44 +271,90 @@ void book_make(int argc, char * argv[]) {
 
          Uniform = true;
 
+      } else if (my_string_equal(argv[i],"-j")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("book_make(): missing argument\n");
+
+         JobNb = atoi(argv[i]);
+         if (JobNb < 1 || JobNb > JobMax) my_fatal("book_make(): -j must be between 1 and %d\n",JobMax);
+
+      } else if (my_string_equal(argv[i],"-memory")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("book_make(): missing argument\n");
+
+         MemoryMax = sint64(atoi(argv[i])) * 1048576;
+         if (MemoryMax <= 0) my_fatal("book_make(): -memory must be positive\n");
+
+      } else if (my_string_equal(argv[i],"-index")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("book_make(): missing argument\n");
+
+         my_string_set(&IndexFile,argv[i]);
+
       } else {
 
          my_fatal("book_make(): unknown option \"%s\"\n",argv[i]);
       }
    }
 
-   book_clear();
+   BinFile = bin_file;
+   RunNb = 0;
+   Run = NULL;
+   IndexRunNb = 0;
+   IndexRun = NULL;
+   IndexSize = 0;
 
    printf("inserting games ...\n");
    book_insert(pgn_file);
 
-   printf("filtering entries ...\n");
-   book_filter();
+   if (RunNb == 0) {
+
+      printf("filtering entries ...\n");
+      book_filter();
+
+      printf("sorting entries ...\n");
+      book_sort();
+
+      printf("saving entries ...\n");
+      book_save(bin_file);
+
+   } else {
+
+      printf("merging %d runs ...\n",RunNb);
+      run_merge(bin_file);
+   }
+
+   if (IndexFile != NULL) {
 
-   printf("sorting entries ...\n");
-   book_sort();
+      printf("indexing positions ...\n");
+      gameindex_build(IndexFile,IndexRun,IndexRunNb,IndexSize);
 
-   printf("saving entries ...\n");
-   book_save(bin_file);
+      my_free(IndexRun);
+   }
 
    printf("all done!\n");
 }
 
 // book_clear()
 
-static void book_clear() {
+static void book_clear(book_t * book) {
 
    int index;
 
-   Book->alloc = 1;
-   Book->mask = (Book->alloc * 2) - 1;
+   ASSERT(book!=NULL);
 
-   Book->entry = (entry_t *) my_malloc(Book->alloc*sizeof(entry_t));
-   Book->size = 0;
+   book->alloc = 1;
+   book->mask = (book->alloc * 2) - 1;
+
+   book->entry = (entry_t *) my_malloc(book->alloc*sizeof(entry_t));
+   book->size = 0;
 
-   Book->hash = (sint32 *) my_malloc((Book->alloc*2)*sizeof(sint32));
-   for (index = 0; index < Book->alloc*2; index++) {
-      Book->hash[index] = NIL;
+   book->hash = (sint32 *) my_malloc((book->alloc*2)*sizeof(sint32));
+   for (index = 0; index < book->alloc*2; index++) {
+      book->hash[index] = NIL;
    }
 }
 
@@ -223,75 +362,310 @@ static void book_clear() {
 
 static void book_insert(const char file_name[]) {
 
-   int game_nb;
-   pgn_t pgn[1];
-   board_t board[1];
-   int ply;
-   int result;
-   char string[256];
-   int move;
-   int pos;
+   sint64 first, size;
+   sint64 round_size;
+   sint64 start, end;
+   sint64 pos;
+   int game_nb, old_nb;
+   int job, shard;
+   int divisor;
 
    ASSERT(file_name!=NULL);
 
    // init
 
+   UseDb = gamedb_is(file_name);
+
+   if (UseDb) {
+      gamedb_open(Db,file_name);
+      first = gamedb_offset(Db,0);
+      size = gamedb_offset(Db,Db->game_nb);
+   } else {
+      pgn_open(Pgn,file_name);
+      first = 0;
+      size = Pgn->size;
+   }
+
+   for (job = 0; job < JobNb; job++) {
+
+      for (shard = 0; shard < JobNb; shard++) {
+         Job[job].part[shard].size = 0;
+         Job[job].part[shard].alloc = 0;
+         Job[job].part[shard].record = NULL;
+      }
+
+      book_clear(Job[job].book);
+
+      Job[job].index_run = NULL;
+      Job[job].index_size = 0;
+   }
+
+   // the moves of a round take about twice the size of the PGN text,
+   // or 16 times the size of a game database (one byte per move),
+   // keep them within a quarter of the memory limit
+   // the position index needs as much again while its runs are sorted
+
+   round_size = ((UseDb) ? RoundSize / 8 : RoundSize) * JobNb;
+
+   divisor = (UseDb) ? 64 : 8;
+   if (IndexFile != NULL) divisor *= 2;
+
+   // with a memory limit, the rounds and therefore the spills do not
+   // depend on the number of jobs, so that neither does the book
+
+   if (MemoryMax > 0) {
+      round_size = MemoryMax / divisor;
+      if (round_size < RoundSizeMin) round_size = RoundSizeMin;
+   }
+
    game_nb = 0;
 
-   // scan loop
+   // round loop, each round parses a slice of the file and merges it
+   // the jobs parse consecutive parts of the slice and the moves are
+   // merged shard by shard in file order, so that every entry sees the
+   // same sequence of updates as with a single job
 
-   pgn_open(pgn,file_name);
+   for (start = first; start < size; start = end) {
 
-   while (pgn_next_game(pgn)) {
+      end = find_game(start+round_size,size);
 
-      board_start(board);
-      ply = 0;
-      result = 0;
+      // split the slice at game boundaries
 
-      if (false) {
-      } else if (my_string_equal(pgn->result,"1-0")) {
-         result = +1;
-      } else if (my_string_equal(pgn->result,"0-1")) {
-         result = -1;
+      Job[0].start = start;
+
+      for (job = 1; job < JobNb; job++) {
+         pos = find_game(start+(end-start)*job/JobNb,end);
+         if (pos < Job[job-1].start) pos = Job[job-1].start;
+         Job[job-1].end = Job[job].start = pos;
       }
 
-      while (pgn_next_move(pgn,string,256)) {
+      Job[JobNb-1].end = end;
 
-         if (ply < MaxPly) {
+      run_jobs(UseDb ? &job_read : &job_parse);
+      run_jobs(&job_merge);
 
-            move = move_from_san(string,board);
+      if (!UseDb) pgn_discard(Pgn,end);
 
-            if (move == MoveNone || !move_is_legal(move,board)) {
-               my_fatal("book_insert(): illegal move \"%s\" at line %d, column %d\n",string,pgn->move_line,pgn->move_column);
-            }
+      if (MemoryMax > 0 && book_memory() > MemoryMax) book_spill();
 
-            pos = find_entry(board,move);
+      old_nb = game_nb;
 
-            Book->entry[pos].n++;
-            Book->entry[pos].sum += result+1;
+      for (job = 0; job < JobNb; job++) {
 
-            if (Book->entry[pos].n >= COUNT_MAX) {
-               halve_stats(board->key);
-            }
+         if (Job[job].index_run != NULL) {
 
-            move_do(board,move);
-            ply++;
-            result = -result;
+            IndexRun = (gameindex_run_t *) my_realloc(IndexRun,(IndexRunNb+1)*sizeof(gameindex_run_t));
+
+            IndexRun[IndexRunNb].file = Job[job].index_run;
+            IndexRun[IndexRunNb].base = game_nb; // games of the previous jobs
+            IndexRunNb++;
+
+            IndexSize += Job[job].index_size;
+            Job[job].index_run = NULL;
          }
+
+         game_nb += Job[job].game_nb;
       }
 
-      game_nb++;
-      if (game_nb % 10000 == 0) printf("%d games ...\n",game_nb);
+      if (game_nb / 10000 > old_nb / 10000) printf("%d games ...\n",game_nb);
    }
 
-   pgn_close(pgn);
+   if (UseDb) {
+      gamedb_close(Db);
+   } else {
+      pgn_close(Pgn);
+   }
 
    printf("%d game%s.\n",game_nb,(game_nb>1)?"s":"");
-   printf("%d entries.\n",Book->size);
+
+   if (RunNb == 0) {
+      book_gather();
+      printf("%d entries.\n",Book->size);
+   } else {
+      book_spill();
+      book_gather(); // frees the parts
+   }
 
    return;
 }
 
+// book_gather()
+
+static void book_gather() {
+
+   int job, shard;
+   int size;
+
+   // concatenate the shards, the order is restored by book_sort()
+
+   size = 0;
+   for (job = 0; job < JobNb; job++) size += Job[job].book->size;
+
+   Book->size = 0;
+   Book->alloc = (size > 0) ? size : 1;
+   Book->mask = 0;
+   Book->entry = (entry_t *) my_malloc(Book->alloc*sizeof(entry_t));
+   Book->hash = NULL; // not needed any more
+
+   for (job = 0; job < JobNb; job++) {
+
+      memcpy(&Book->entry[Book->size],Job[job].book->entry,Job[job].book->size*sizeof(entry_t));
+      Book->size += Job[job].book->size;
+
+      my_free(Job[job].book->entry);
+      my_free(Job[job].book->hash);
+
+      for (shard = 0; shard < JobNb; shard++) {
+         if (Job[job].part[shard].record != NULL) my_free(Job[job].part[shard].record);
+      }
+   }
+
+   ASSERT(Book->size==size);
+}
+
+// book_memory()
+
+static sint64 book_memory() {
+
+   int job;
+   sint64 size;
+
+   // memory used by the shard tables, counted from the entries rather
+   // than the allocations so that it does not depend on the number of
+   // shards; a table holds at most twice its entries
+
+   size = 0;
+
+   for (job = 0; job < JobNb; job++) size += Job[job].book->size;
+
+   return size * 2 * (sizeof(entry_t) + 2 * sizeof(sint32));
+}
+
+// book_spill()
+
+static void book_spill() {
+
+   int job;
+   book_t * book;
+   run_t * run;
+   char file_name[4096];
+   int fd;
+
+   // write each shard as a run sorted by key and move, and empty it
+
+   for (job = 0; job < JobNb; job++) {
+
+      book = Job[job].book;
+
+      if (book->size > 0) {
+
+         qsort(book->entry,book->size,sizeof(entry_t),&move_compare);
+
+         Run = (run_t *) my_realloc(Run,(RunNb+1)*sizeof(run_t));
+         run = &Run[RunNb++];
+
+         // temporary file next to the book, removed as soon as it is open
+
+         snprintf(file_name,sizeof(file_name),"%s.run.XXXXXX",BinFile);
+
+         fd = mkstemp(file_name);
+         if (fd == -1) my_fatal("book_spill(): can't create file \"%s\": %s\n",file_name,strerror(errno));
+         unlink(file_name);
+
+         run->file = fdopen(fd,"w+b");
+         if (run->file == NULL) my_fatal("book_spill(): fdopen(): %s\n",strerror(errno));
+
+         if (fwrite(book->entry,sizeof(entry_t),book->size,run->file) != size_t(book->size)) {
+            my_fatal("book_spill(): fwrite(): %s\n",strerror(errno));
+         }
+      }
+
+      my_free(book->entry);
+      my_free(book->hash);
+      book_clear(book);
+   }
+
+   printf("%d runs ...\n",RunNb);
+}
+
+// run_merge()
+
+static void run_merge(const char file_name[]) {
+
+   FILE * file;
+   total_t * total;
+   entry_t * entry;
+   int alloc;
+   int size;
+   int run;
+   int pos;
+   uint64 key;
+   int entry_nb;
+
+   ASSERT(file_name!=NULL);
+
+   file = fopen(file_name,"wb");
+   if (file == NULL) my_fatal("run_merge(): can't open file \"%s\" for writing: %s\n",file_name,strerror(errno));
+
+   // init
+
+   Heap = (int *) my_malloc(RunNb*sizeof(int));
+
+   for (run = 0; run < RunNb; run++) {
+      if (fseeko(Run[run].file,0,SEEK_SET) != 0) my_fatal("run_merge(): fseeko(): %s\n",strerror(errno));
+      run_next(run);
+      ASSERT(Run[run].file!=NULL);
+      Heap[run] = run;
+   }
+
+   HeapSize = RunNb;
+   for (pos = HeapSize / 2 - 1; pos >= 0; pos--) heap_down(pos);
+
+   alloc = 256;
+   total = (total_t *) my_malloc(alloc*sizeof(total_t));
+   entry = (entry_t *) my_malloc(alloc*sizeof(entry_t));
+
+   entry_nb = 0;
+
+   // position loop
+
+   while (HeapSize > 0) {
+
+      // the entries of a position come in move order from all the runs
+
+      key = Run[Heap[0]].entry.key;
+      size = 0;
+
+      while (HeapSize > 0 && Run[Heap[0]].entry.key == key) {
+
+         run = Heap[0];
+
+         if (size == alloc) {
+            alloc *= 2;
+            total = (total_t *) my_realloc(total,alloc*sizeof(total_t));
+            entry = (entry_t *) my_realloc(entry,alloc*sizeof(entry_t));
+         }
+
+         size = total_add(total,size,&Run[run].entry);
+
+         run_next(run);
+         if (Run[run].file == NULL) Heap[0] = Heap[--HeapSize];
+         heap_down(0);
+      }
+
+      entry_nb += total_save(file,total,entry,size);
+   }
+
+   fclose(file);
+
+   my_free(total);
+   my_free(entry);
+   my_free(Heap);
+   my_free(Run);
+
+   printf("%d entries.\n",entry_nb);
+}
+
 // book_filter()
 
 static void book_filter() {
@@ -303,7 +677,7 @@ static void book_filter() {
    dst = 0;
 
    for (src = 0; src < Book->size; src++) {
-      if (keep_entry(src)) Book->entry[dst++] = Book->entry[src];
+      if (keep_entry(&Book->entry[src])) Book->entry[dst++] = Book->entry[src];
    }
 
    ASSERT(dst>=0&&dst<=Book->size);
@@ -337,153 +711,587 @@ static void book_save(const char file_name[]) {
 
    for (pos = 0; pos < Book->size; pos++) {
 
-      ASSERT(keep_entry(pos));
+      ASSERT(keep_entry(&Book->entry[pos]));
 
-      write_integer(file,8,Book->entry[pos].key);
-      write_integer(file,2,Book->entry[pos].move);
-      write_integer(file,2,entry_score(&Book->entry[pos]));
-      write_integer(file,2,0);
-      write_integer(file,2,0);
+      write_entry(file,&Book->entry[pos]);
    }
 
    fclose(file);
 }
 
-// find_entry()
+// run_jobs()
 
-static int find_entry(const board_t * board, int move) {
+static void run_jobs(void * (*func)(void *)) {
 
-   uint64 key;
+   int job;
+   int err;
+
+   ASSERT(func!=NULL);
+
+   if (JobNb == 1) {
+      (*func)(&Job[0]);
+      return;
+   }
+
+   for (job = 0; job < JobNb; job++) {
+      err = pthread_create(&Job[job].thread,NULL,func,&Job[job]);
+      if (err != 0) my_fatal("run_jobs(): pthread_create(): %s\n",strerror(err));
+   }
+
+   for (job = 0; job < JobNb; job++) {
+      pthread_join(Job[job].thread,NULL);
+   }
+}
+
+// job_parse()
+
+static void * job_parse(void * arg) {
+
+   job_t * job;
+   pgn_t pgn[1];
+   board_t board[1];
+   int ply;
+   int result;
+   char string[256];
+   int move;
+   int line, column;
+   int shard;
+
+   job = (job_t *) arg;
+   ASSERT(job!=NULL);
+
+   // init
+
+   for (shard = 0; shard < JobNb; shard++) job->part[shard].size = 0;
+   job->game_nb = 0;
+
+   if (job->start == job->end) return NULL;
+
+   // scan loop
+
+   pgn_open_range(pgn,Pgn,job->start,job->end);
+
+   while (pgn_next_game(pgn)) {
+
+      if (pgn->fen[0] == '\0') {
+         board_start(board);
+      } else if (!board_from_fen(board,pgn->fen)) {
+         my_fatal("book_insert(): bad FEN \"%s\"\n",pgn->fen);
+      }
+
+      ply = 0;
+      result = 0;
+
+      if (false) {
+      } else if (my_string_equal(pgn->result,"1-0")) {
+         result = +1;
+      } else if (my_string_equal(pgn->result,"0-1")) {
+         result = -1;
+      }
+
+      if (colour_is_black(board->turn)) result = -result; // for the side to move
+
+      while (pgn_next_move(pgn,string,256)) {
+
+         if (ply < MaxPly) {
+
+            move = move_from_san(string,board);
+
+            if (move == MoveNone || !move_is_legal(move,board)) {
+               pgn_line_column(pgn,pgn->move_pos,&line,&column);
+               my_fatal("book_insert(): illegal move \"%s\" at line %d, column %d\n",string,line,column);
+            }
+
+            shard = int((board->key >> 32) % uint64(JobNb));
+            part_add(&job->part[shard],board,move,result,job->game_nb);
+
+            move_do(board,move);
+            ply++;
+            result = -result;
+         }
+      }
+
+      job->game_nb++;
+   }
+
+   pgn_close(pgn);
+
+   if (IndexFile != NULL) job_index(job);
+
+   return NULL;
+}
+
+// job_read()
+
+static void * job_read(void * arg) {
+
+   job_t * job;
+   gamedb_game_t game[1];
+   board_t board[1];
    int index;
+   int ply;
+   int result;
+   int move;
+   int shard;
+
+   job = (job_t *) arg;
+   ASSERT(job!=NULL);
+
+   // same as job_parse(), from a game database
+
+   for (shard = 0; shard < JobNb; shard++) job->part[shard].size = 0;
+   job->game_nb = 0;
+
+   for (index = gamedb_find(Db,job->start); index < Db->game_nb && gamedb_offset(Db,index) < job->end; index++) {
+
+      gamedb_read(Db,index,game);
+      gamedb_start(game,board);
+
+      ply = 0;
+      result = 0;
+
+      if (false) {
+      } else if (game->result == GameDbWhiteWins) {
+         result = +1;
+      } else if (game->result == GameDbBlackWins) {
+         result = -1;
+      }
+
+      if (colour_is_black(board->turn)) result = -result; // for the side to move
+
+      while (ply < MaxPly && gamedb_next_move(game,board,&move)) {
+
+         shard = int((board->key >> 32) % uint64(JobNb));
+         part_add(&job->part[shard],board,move,result,job->game_nb);
+
+         move_do(board,move);
+         ply++;
+         result = -result;
+      }
+
+      job->game_nb++;
+   }
+
+   if (IndexFile != NULL) job_index(job);
+
+   return NULL;
+}
+
+// job_merge()
+
+static void * job_merge(void * arg) {
+
+   job_t * job;
+   book_t * book;
+   const part_t * part;
+   const record_t * record;
+   int shard;
+   int src;
+   int i;
    int pos;
 
+   job = (job_t *) arg;
+   ASSERT(job!=NULL);
+
+   shard = int(job - Job);
+   ASSERT(shard>=0&&shard<JobNb);
+
+   book = job->book;
+
+   // apply the moves of the shard in file order
+
+   for (src = 0; src < JobNb; src++) {
+
+      part = &Job[src].part[shard];
+
+      for (i = 0; i < part->size; i++) {
+
+         record = &part->record[i];
+
+         pos = find_entry(book,record->key,record->move,record->colour);
+
+         book->entry[pos].n++;
+         book->entry[pos].sum += record->result+1;
+
+         if (book->entry[pos].n >= COUNT_MAX) {
+            halve_stats(book,record->key);
+         }
+      }
+   }
+
+   return NULL;
+}
+
+// job_index()
+
+static void job_index(job_t * job) {
+
+   gameindex_item_t * item;
+   const part_t * part;
+   int size;
+   int shard;
+   int i;
+
+   ASSERT(job!=NULL);
+
+   // the positions of the job's games, as a sorted run
+
+   size = 0;
+   for (shard = 0; shard < JobNb; shard++) size += job->part[shard].size;
+
+   item = (gameindex_item_t *) my_malloc((size>0)?size*sizeof(gameindex_item_t):1);
+   size = 0;
+
+   for (shard = 0; shard < JobNb; shard++) {
+
+      part = &job->part[shard];
+
+      for (i = 0; i < part->size; i++) {
+         item[size].key = part->record[i].key;
+         item[size].game = part->record[i].game;
+         size++;
+      }
+   }
+
+   job->index_run = gameindex_run(IndexFile,item,size);
+   job->index_size = size;
+
+   my_free(item);
+}
+
+// part_add()
+
+static void part_add(part_t * part, const board_t * board, int move, int result, int game) {
+
+   record_t * record;
+
+   ASSERT(part!=NULL);
    ASSERT(board!=NULL);
    ASSERT(move_is_ok(move));
+   ASSERT(result>=-1&&result<=+1);
+
+   if (part->size == part->alloc) {
+      part->alloc = (part->alloc == 0) ? 1024 : part->alloc * 2;
+      part->record = (record_t *) my_realloc(part->record,part->alloc*sizeof(record_t));
+   }
 
-   ASSERT(move_is_legal(move,board));
+   record = &part->record[part->size++];
 
-   // init
+   record->key = board->key;
+   record->move = move;
+   record->colour = board->turn;
+   record->result = result;
+   record->game = game;
+}
+
+// find_game()
+
+static sint64 find_game(sint64 pos, sint64 end) {
+
+   const char * data;
+   sint64 line;
+   bool blank;
+
+   ASSERT(pos>=0);
+
+   // returns the first game that starts at or after "pos", or "end" if
+   // there is none before it
+
+   if (pos >= end) return end;
+
+   if (UseDb) {
+      pos = gamedb_offset(Db,gamedb_find(Db,pos));
+      return (pos < end) ? pos : end;
+   }
+
+   // in a PGN file, a tag line that follows an empty line
 
-   key = board->key;
+   ASSERT(end<=Pgn->size);
+
+   data = Pgn->data;
+
+   // skip the current line, it may not be read from its start
+
+   while (pos < end && data[pos++] != '\n')
+      ;
+
+   // line loop
+
+   blank = false;
+
+   while (pos < end) {
+
+      line = pos;
+
+      if (data[pos] == '[' && blank) return line;
+
+      blank = true;
+
+      for (; pos < end && data[pos] != '\n'; pos++) {
+         if (data[pos] != ' ' && data[pos] != '\t' && data[pos] != '\r') blank = false;
+      }
+
+      pos++; // '\n'
+   }
+
+   return end;
+}
+
+// find_entry()
+
+static int find_entry(book_t * book, uint64 key, int move, int colour) {
+
+   int index;
+   int pos;
+
+   ASSERT(book!=NULL);
+   ASSERT(move_is_ok(move));
+   ASSERT(colour_is_ok(colour));
 
    // search
 
-   for (index = key & Book->mask; (pos=Book->hash[index]) != NIL; index = (index+1) & Book->mask) {
+   for (index = key & book->mask; (pos=book->hash[index]) != NIL; index = (index+1) & book->mask) {
 
-      ASSERT(pos>=0&&pos<Book->size);
+      ASSERT(pos>=0&&pos<book->size);
 
-      if (Book->entry[pos].key == key && Book->entry[pos].move == move) {
+      if (book->entry[pos].key == key && book->entry[pos].move == move) {
          return pos; // found
       }
    }
 
    // not found
 
-   ASSERT(Book->size<=Book->alloc);
+   ASSERT(book->size<=book->alloc);
 
-   if (Book->size == Book->alloc) {
+   if (book->size == book->alloc) {
 
       // allocate more memory
 
-      resize();
+      resize(book);
 
-      for (index = key & Book->mask; Book->hash[index] != NIL; index = (index+1) & Book->mask)
+      for (index = key & book->mask; book->hash[index] != NIL; index = (index+1) & book->mask)
          ;
    }
 
    // create a new entry
 
-   ASSERT(Book->size<Book->alloc);
-   pos = Book->size++;
+   ASSERT(book->size<book->alloc);
+   pos = book->size++;
 
-   Book->entry[pos].key = key;
-   Book->entry[pos].move = move;
-   Book->entry[pos].n = 0;
-   Book->entry[pos].sum = 0;
-   Book->entry[pos].colour = board->turn;
+   book->entry[pos].key = key;
+   book->entry[pos].move = move;
+   book->entry[pos].n = 0;
+   book->entry[pos].sum = 0;
+   book->entry[pos].colour = colour;
 
    // insert into the hash table
 
-   ASSERT(index>=0&&index<Book->alloc*2);
-   ASSERT(Book->hash[index]==NIL);
-   Book->hash[index] = pos;
+   ASSERT(index>=0&&index<book->alloc*2);
+   ASSERT(book->hash[index]==NIL);
+   book->hash[index] = pos;
 
-   ASSERT(pos>=0&&pos<Book->size);
+   ASSERT(pos>=0&&pos<book->size);
 
    return pos;
 }
 
 // resize()
 
-static void resize() {
+static void resize(book_t * book) {
 
    int size;
    int pos;
    int index;
 
-   ASSERT(Book->size==Book->alloc);
+   ASSERT(book!=NULL);
+   ASSERT(book->size==book->alloc);
 
-   Book->alloc *= 2;
-   Book->mask = (Book->alloc * 2) - 1;
+   book->alloc *= 2;
+   book->mask = (book->alloc * 2) - 1;
 
    size = 0;
-   size += Book->alloc * sizeof(entry_t);
-   size += (Book->alloc*2) * sizeof(sint32);
+   size += book->alloc * sizeof(entry_t);
+   size += (book->alloc*2) * sizeof(sint32);
 
    if (size >= 1048576) printf("allocating %gMB ...\n",double(size)/1048576.0);
 
    // resize arrays
 
-   Book->entry = (entry_t *) my_realloc(Book->entry,Book->alloc*sizeof(entry_t));
-   Book->hash = (sint32 *) my_realloc(Book->hash,(Book->alloc*2)*sizeof(sint32));
+   book->entry = (entry_t *) my_realloc(book->entry,book->alloc*sizeof(entry_t));
+   book->hash = (sint32 *) my_realloc(book->hash,(book->alloc*2)*sizeof(sint32));
 
    // rebuild hash table
 
-   for (index = 0; index < Book->alloc*2; index++) {
-      Book->hash[index] = NIL;
+   for (index = 0; index < book->alloc*2; index++) {
+      book->hash[index] = NIL;
    }
 
-   for (pos = 0; pos < Book->size; pos++) {
+   for (pos = 0; pos < book->size; pos++) {
 
-      for (index = Book->entry[pos].key & Book->mask; Book->hash[index] != NIL; index = (index+1) & Book->mask)
+      for (index = book->entry[pos].key & book->mask; book->hash[index] != NIL; index = (index+1) & book->mask)
          ;
 
-      ASSERT(index>=0&&index<Book->alloc*2);
-      Book->hash[index] = pos;
+      ASSERT(index>=0&&index<book->alloc*2);
+      book->hash[index] = pos;
    }
 }
 
 // halve_stats()
 
-static void halve_stats(uint64 key) {
+static void halve_stats(book_t * book, uint64 key) {
 
    int index;
    int pos;
 
+   ASSERT(book!=NULL);
+
    // search
 
-   for (index = key & Book->mask; (pos=Book->hash[index]) != NIL; index = (index+1) & Book->mask) {
+   for (index = key & book->mask; (pos=book->hash[index]) != NIL; index = (index+1) & book->mask) {
+
+      ASSERT(pos>=0&&pos<book->size);
+
+      if (book->entry[pos].key == key) {
+         book->entry[pos].n = (book->entry[pos].n + 1) / 2;
+         book->entry[pos].sum = (book->entry[pos].sum + 1) / 2;
+      }
+   }
+}
+
+// run_next()
+
+static void run_next(int run) {
+
+   ASSERT(run>=0&&run<RunNb);
+   ASSERT(Run[run].file!=NULL);
+
+   if (fread(&Run[run].entry,sizeof(entry_t),1,Run[run].file) != 1) {
+
+      if (ferror(Run[run].file)) my_fatal("run_next(): fread(): %s\n",strerror(errno));
+
+      fclose(Run[run].file);
+      Run[run].file = NULL;
+   }
+}
+
+// heap_down()
+
+static void heap_down(int pos) {
+
+   int child;
+   int run;
+
+   ASSERT(pos>=0);
+
+   if (pos >= HeapSize) return;
+
+   run = Heap[pos];
 
-      ASSERT(pos>=0&&pos<Book->size);
+   while ((child = pos * 2 + 1) < HeapSize) {
 
-      if (Book->entry[pos].key == key) {
-         Book->entry[pos].n = (Book->entry[pos].n + 1) / 2;
-         Book->entry[pos].sum = (Book->entry[pos].sum + 1) / 2;
+      if (child + 1 < HeapSize
+       && move_compare(&Run[Heap[child+1]].entry,&Run[Heap[child]].entry) < 0) {
+         child++;
       }
+
+      if (move_compare(&Run[Heap[child]].entry,&Run[run].entry) >= 0) break;
+
+      Heap[pos] = Heap[child];
+      pos = child;
    }
+
+   Heap[pos] = run;
+}
+
+// total_add()
+
+static int total_add(total_t * total, int size, const entry_t * entry) {
+
+   ASSERT(total!=NULL);
+   ASSERT(size>=0);
+   ASSERT(entry!=NULL);
+
+   if (size > 0 && total[size-1].move == entry->move) {
+
+      ASSERT(total[size-1].key==entry->key);
+
+      total[size-1].n += entry->n;
+      total[size-1].sum += entry->sum;
+
+   } else {
+
+      total[size].key = entry->key;
+      total[size].move = entry->move;
+      total[size].colour = entry->colour;
+      total[size].n = entry->n;
+      total[size].sum = entry->sum;
+
+      size++;
+   }
+
+   return size;
+}
+
+// total_save()
+
+static int total_save(FILE * file, total_t * total, entry_t * entry, int size) {
+
+   uint32 n_max;
+   int i;
+   int entry_nb;
+
+   ASSERT(file!=NULL);
+   ASSERT(total!=NULL);
+   ASSERT(entry!=NULL);
+   ASSERT(size>0);
+
+   // halve the statistics of the position as in halve_stats()
+
+   while (true) {
+
+      n_max = 0;
+      for (i = 0; i < size; i++) {
+         if (total[i].n > n_max) n_max = total[i].n;
+      }
+
+      if (n_max < uint32(COUNT_MAX)) break;
+
+      for (i = 0; i < size; i++) {
+         total[i].n = (total[i].n + 1) / 2;
+         total[i].sum = (total[i].sum + 1) / 2;
+      }
+   }
+
+   // filter, sort and save the entries of the position
+
+   entry_nb = 0;
+
+   for (i = 0; i < size; i++) {
+
+      entry[entry_nb].key = total[i].key;
+      entry[entry_nb].move = total[i].move;
+      entry[entry_nb].n = total[i].n;
+      entry[entry_nb].sum = total[i].sum;
+      entry[entry_nb].colour = total[i].colour;
+
+      if (keep_entry(&entry[entry_nb])) entry_nb++;
+   }
+
+   qsort(entry,entry_nb,sizeof(entry_t),&key_compare);
+
+   for (i = 0; i < entry_nb; i++) write_entry(file,&entry[i]);
+
+   return entry_nb;
 }
 
 // keep_entry()
 
-static bool keep_entry(int pos) {
+static bool keep_entry(const entry_t * entry) {
 
-   const entry_t * entry;
    int colour;
    double score;
 
-   ASSERT(pos>=0&&pos<Book->size);
-
-   entry = &Book->entry[pos];
+   ASSERT(entry!=NULL);
 
    // if (entry->n == 0) return false;
    if (entry->n < MinGame) return false;
@@ -542,10 +1350,49 @@ static int key_compare(const void * p1, const void * p2) {
    } else if (entry_1->key < entry_2->key) {
       return -1;
    } else {
-      return entry_score(entry_2) - entry_score(entry_1); // highest score first
+      if (entry_score(entry_1) != entry_score(entry_2)) {
+         return entry_score(entry_2) - entry_score(entry_1); // highest score first
+      } else {
+         return int(entry_1->move) - int(entry_2->move); // make the order total
+      }
+   }
+}
+
+// move_compare()
+
+static int move_compare(const void * p1, const void * p2) {
+
+   const entry_t * entry_1, * entry_2;
+
+   ASSERT(p1!=NULL);
+   ASSERT(p2!=NULL);
+
+   entry_1 = (const entry_t *) p1;
+   entry_2 = (const entry_t *) p2;
+
+   if (entry_1->key > entry_2->key) {
+      return +1;
+   } else if (entry_1->key < entry_2->key) {
+      return -1;
+   } else {
+      return int(entry_1->move) - int(entry_2->move);
    }
 }
 
+// write_entry()
+
+static void write_entry(FILE * file, const entry_t * entry) {
+
+   ASSERT(file!=NULL);
+   ASSERT(entry!=NULL);
+
+   write_integer(file,8,entry->key);
+   write_integer(file,2,entry->move);
+   write_integer(file,2,entry_score(entry));
+   write_integer(file,2,0);
+   write_integer(file,2,0);
+}
+
 // write_integer()
 
 static void write_integer(FILE * file, int size, uint64 n) {
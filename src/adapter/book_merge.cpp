@@ -18,7 +18,6 @@
    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-
 // book_merge.cpp
 
 // includes
@@ -28,44 +27,68 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <sys/stat.h>
+
 #include "book_merge.h"
 #include "util.h"
+#include "polybook.h"
 
 namespace adapter {
 
+// constants
+
+static const int InMax = 256;
+
+static const int BufferSize = 1048576; // output buffer
+
+static const uint32 WeightMax = 65535;
+
 // types
 
-struct book_t {
-   FILE * file;
-   int size;
+enum rule_t {
+   RuleFirst, // a position is taken from the first book that has it
+   RuleSum    // the weights and learning counts of a move are added
 };
 
-struct entry_t {
-   uint64 key;
+struct in_t {
+   polybook_t book[1];
+   size_t pos; // next entry
+};
+
+struct total_t {
    uint16 move;
-   uint16 count;
-   uint16 n;
-   uint16 sum;
+   uint32 count;
+   uint32 n;
+   uint32 sum;
 };
 
 // variables
 
-static book_t In1[1];
-static book_t In2[1];
-static book_t Out[1];
+static int InNb;
+static in_t In[InMax];
+
+static int Heap[InMax]; // books ordered by next key, then command-line order
+static int HeapSize;
+
+static int Rule;
+
+static FILE * Out;
+static int OutNb;
 
 // prototypes
 
-static void   book_clear    (book_t * book);
+static void   in_add        (const char file_name[]);
+
+static uint64 in_key        (int in);
+static bool   in_less       (int in_1, int in_2);
+static void   heap_down     (int pos);
 
-static void   book_open     (book_t * book, const char file_name[], const char mode[]);
-static void   book_close    (book_t * book);
+static int    total_add     (total_t * total, int size, const polybook_entry_t * entry);
+static void   total_save    (uint64 key, total_t * total, int size);
 
-static bool   read_entry    (book_t * book, entry_t * entry, int n);
-static void   write_entry   (book_t * book, const entry_t * entry);
+static int    total_compare (const void * p1, const void * p2);
 
-static uint64 read_integer  (FILE * file, int size);
-static void   write_integer (FILE * file, int size, uint64 n);
+static void   write_entry   (const polybook_entry_t * entry);
 
 // functions
 
@@ -74,23 +97,23 @@ static void   write_integer (FILE * file, int size, uint64 n);
 void book_merge(int argc, char * argv[]) {
 
    int i;
-   const char * in_file_1;
-   const char * in_file_2;
    const char * out_file;
-   int i1, i2;
-   bool b1, b2;
-   entry_t e1[1], e2[1];
+   polybook_t * book;
+   polybook_entry_t entry[1];
+   total_t * total;
+   int alloc;
+   int size;
+   int in;
+   uint64 key;
+   bool first;
    int skip;
 
-   in_file_1 = NULL;
-   my_string_clear(&in_file_1);
-
-   in_file_2 = NULL;
-   my_string_clear(&in_file_2);
-
    out_file = NULL;
    my_string_set(&out_file,"out.bin");
 
+   InNb = 0;
+   Rule = RuleFirst;
+
    for (i = 1; i < argc; i++) {
 
       if (false) {
@@ -99,26 +122,35 @@ void book_merge(int argc, char * argv[]) {
 
          // skip
 
-      } else if (my_string_equal(argv[i],"-in1")) {
+      } else if (my_string_equal(argv[i],"-in")
+              || my_string_equal(argv[i],"-in1")
+              || my_string_equal(argv[i],"-in2")) {
 
          i++;
          if (argv[i] == NULL) my_fatal("book_merge(): missing argument\n");
 
-         my_string_set(&in_file_1,argv[i]);
+         in_add(argv[i]);
 
-      } else if (my_string_equal(argv[i],"-in2")) {
+      } else if (my_string_equal(argv[i],"-out")) {
 
          i++;
          if (argv[i] == NULL) my_fatal("book_merge(): missing argument\n");
 
-         my_string_set(&in_file_2,argv[i]);
+         my_string_set(&out_file,argv[i]);
 
-      } else if (my_string_equal(argv[i],"-out")) {
+      } else if (my_string_equal(argv[i],"-rule")) {
 
          i++;
          if (argv[i] == NULL) my_fatal("book_merge(): missing argument\n");
 
-         my_string_set(&out_file,argv[i]);
+         if (false) {
+         } else if (my_string_equal(argv[i],"first")) {
+            Rule = RuleFirst;
+         } else if (my_string_equal(argv[i],"sum")) {
+            Rule = RuleSum;
+         } else {
+            my_fatal("book_merge(): unknown rule \"%s\"\n",argv[i]);
+         }
 
       } else {
 
@@ -126,63 +158,83 @@ void book_merge(int argc, char * argv[]) {
       }
    }
 
-   book_clear(In1);
-   book_clear(In2);
-   book_clear(Out);
+   if (InNb == 0) my_fatal("book_merge(): no input book\n");
+
+   Out = fopen(out_file,"wb");
+   if (Out == NULL) my_fatal("book_merge(): can't open file \"%s\": %s\n",out_file,strerror(errno));
+   setvbuf(Out,NULL,_IOFBF,BufferSize);
+
+   OutNb = 0;
+
+   // init
+
+   HeapSize = 0;
+
+   for (in = 0; in < InNb; in++) {
+      if (In[in].book->size != 0) Heap[HeapSize++] = in;
+   }
+
+   for (i = HeapSize / 2 - 1; i >= 0; i--) heap_down(i);
 
-   book_open(In1,in_file_1,"rb");
-   book_open(In2,in_file_2,"rb");
-   book_open(Out,out_file,"wb");
+   alloc = 256;
+   total = (total_t *) my_malloc(alloc*sizeof(total_t));
 
    skip = 0;
 
-   i1 = 0;
-   i2 = 0;
+   // position loop, every book is read once in order
 
-   while (true) {
+   while (HeapSize > 0) {
 
-      b1 = read_entry(In1,e1,i1);
-      b2 = read_entry(In2,e2,i2);
+      key = in_key(Heap[0]);
+      first = true;
+      size = 0;
 
-      if (false) {
+      while (HeapSize > 0 && in_key(Heap[0]) == key) {
 
-      } else if (!b1 && !b2) {
+         in = Heap[0];
+         book = In[in].book;
 
-         break;
+         for (; In[in].pos < book->size && polybook_key(book,In[in].pos) == key; In[in].pos++) {
 
-      } else if (b1 && !b2) {
+            polybook_read(book,In[in].pos,entry);
 
-         write_entry(Out,e1);
-         i1++;
+            if (false) {
 
-      } else if (b2 && !b1) {
+            } else if (Rule == RuleFirst) {
 
-         write_entry(Out,e2);
-         i2++;
+               if (first) {
+                  write_entry(entry);
+               } else {
+                  skip++;
+               }
 
-      } else {
+            } else if (Rule == RuleSum) {
 
-         ASSERT(b1);
-         ASSERT(b2);
+               if (size == alloc) {
+                  alloc *= 2;
+                  total = (total_t *) my_realloc(total,alloc*sizeof(total_t));
+               }
 
-         if (false) {
-         } else if (e1->key < e2->key) {
-            write_entry(Out,e1);
-            i1++;
-         } else if (e1->key > e2->key) {
-            write_entry(Out,e2);
-            i2++;
-         } else {
-            ASSERT(e1->key==e2->key);
-            skip++;
-            i2++;
+               size = total_add(total,size,entry);
+            }
          }
+
+         first = false;
+
+         if (In[in].pos == book->size) Heap[0] = Heap[--HeapSize];
+         heap_down(0);
       }
+
+      if (Rule == RuleSum) total_save(key,total,size);
    }
 
-   book_close(In1);
-   book_close(In2);
-   book_close(Out);
+   my_free(total);
+
+   for (in = 0; in < InNb; in++) polybook_close(In[in].book);
+
+   if (fclose(Out) == EOF) my_fatal("book_merge(): fclose(): %s\n",strerror(errno));
+
+   printf("%d entr%s.\n",OutNb,(OutNb>1)?"ies":"y");
 
    if (skip != 0) {
       printf("skipped %d entr%s.\n",skip,(skip>1)?"ies":"y");
@@ -191,138 +243,227 @@ void book_merge(int argc, char * argv[]) {
    printf("done!\n");
 }
 
-// book_clear()
+// in_add()
 
-static void book_clear(book_t * book) {
+static void in_add(const char file_name[]) {
 
-   ASSERT(book!=NULL);
+   in_t * in;
+   struct stat st;
+   size_t pos;
 
-   book->file = NULL;
-   book->size = 0;
-}
+   ASSERT(file_name!=NULL);
 
-// book_open()
+   if (InNb >= InMax) my_fatal("book_merge(): too many books, at most %d\n",InMax);
 
-static void book_open(book_t * book, const char file_name[], const char mode[]) {
+   in = &In[InNb++];
 
-   ASSERT(book!=NULL);
-   ASSERT(file_name!=NULL);
-   ASSERT(mode!=NULL);
+   polybook_clear(in->book);
 
-   book->file = fopen(file_name,mode);
-   if (book->file == NULL) my_fatal("book_open(): can't open file \"%s\": %s\n",file_name,strerror(errno));
+   if (polybook_open(in->book,file_name,POLYBOOK_SEQUENTIAL) == -1) {
+      my_fatal("book_merge(): can't open file \"%s\": %s\n",file_name,strerror(errno));
+   }
 
-   if (fseek(book->file,0,SEEK_END) == -1) {
-      my_fatal("book_open(): fseek(): %s\n",strerror(errno));
+   // the merge relies on whole entries in key order, check before any output is written
+
+   if (stat(file_name,&st) == -1) my_fatal("book_merge(): can't stat file \"%s\": %s\n",file_name,strerror(errno));
+
+   if (st.st_size % POLYBOOK_ENTRY_SIZE != 0) {
+      my_fatal("book_merge(): \"%s\" is not a book, size %lld is not a multiple of %d\n",file_name,(long long)st.st_size,POLYBOOK_ENTRY_SIZE);
+   }
+
+   for (pos = 1; pos < in->book->size; pos++) {
+      if (polybook_key(in->book,pos) < polybook_key(in->book,pos-1)) {
+         my_fatal("book_merge(): \"%s\" is not a book, entry %lu is out of order\n",file_name,(unsigned long)pos);
+      }
    }
 
-   book->size = ftell(book->file) / 16;
+   in->pos = 0;
 }
 
-// book_close()
+// in_key()
 
-static void book_close(book_t * book) {
+static uint64 in_key(int in) {
 
-   ASSERT(book!=NULL);
+   ASSERT(in>=0&&in<InNb);
+   ASSERT(In[in].pos<In[in].book->size);
 
-   if (fclose(book->file) == EOF) {
-      my_fatal("book_close(): fclose(): %s\n",strerror(errno));
-   }
+   return polybook_key(In[in].book,In[in].pos);
 }
 
-// read_entry()
+// in_less()
 
-static bool read_entry(book_t * book, entry_t * entry, int n) {
+static bool in_less(int in_1, int in_2) {
 
-   ASSERT(book!=NULL);
-   ASSERT(entry!=NULL);
+   uint64 key_1, key_2;
 
-   if (n < 0 || n >= book->size) return false;
+   key_1 = in_key(in_1);
+   key_2 = in_key(in_2);
 
-   ASSERT(n>=0&&n<book->size);
+   if (key_1 != key_2) return key_1 < key_2;
 
-   if (fseek(book->file,n*16,SEEK_SET) == -1) {
-      my_fatal("read_entry(): fseek(): %s\n",strerror(errno));
-   }
+   return in_1 < in_2; // earlier books first
+}
+
+// heap_down()
+
+static void heap_down(int pos) {
+
+   int child;
+   int in;
+
+   ASSERT(pos>=0);
 
-   entry->key   = read_integer(book->file,8);
-   entry->move  = read_integer(book->file,2);
-   entry->count = read_integer(book->file,2);
-   entry->n     = read_integer(book->file,2);
-   entry->sum   = read_integer(book->file,2);
+   if (pos >= HeapSize) return;
 
-   return true;
+   in = Heap[pos];
+
+   while ((child = pos * 2 + 1) < HeapSize) {
+
+      if (child + 1 < HeapSize && in_less(Heap[child+1],Heap[child])) child++;
+
+      if (!in_less(Heap[child],in)) break;
+
+      Heap[pos] = Heap[child];
+      pos = child;
+   }
+
+   Heap[pos] = in;
 }
 
-// write_entry()
+// total_add()
 
-static void write_entry(book_t * book, const entry_t * entry) {
+static int total_add(total_t * total, int size, const polybook_entry_t * entry) {
 
-   ASSERT(book!=NULL);
+   int i;
+
+   ASSERT(total!=NULL);
+   ASSERT(size>=0);
    ASSERT(entry!=NULL);
 
-   write_integer(book->file,8,entry->key);
-   write_integer(book->file,2,entry->move);
-   write_integer(book->file,2,entry->count);
-   write_integer(book->file,2,entry->n);
-   write_integer(book->file,2,entry->sum);
+   for (i = 0; i < size; i++) {
+      if (total[i].move == entry->move) break;
+   }
+
+   if (i == size) {
+      total[i].move = entry->move;
+      total[i].count = 0;
+      total[i].n = 0;
+      total[i].sum = 0;
+      size++;
+   }
+
+   total[i].count += entry->count;
+   total[i].n += entry->n;
+   total[i].sum += entry->sum;
+
+   return size;
 }
 
-// read_integer()
+// total_save()
 
-static uint64 read_integer(FILE * file, int size) {
+static void total_save(uint64 key, total_t * total, int size) {
 
-   uint64 n;
+   polybook_entry_t entry[1];
+   uint32 max;
    int i;
-   int b;
 
-   ASSERT(file!=NULL);
-   ASSERT(size>0&&size<=8);
+   ASSERT(total!=NULL);
+   ASSERT(size>0);
 
-   n = 0;
+   // scale the weights of the position down if one does not fit
 
-   for (i = 0; i < size; i++) {
+   while (true) {
 
-      b = fgetc(file);
+      max = 0;
+      for (i = 0; i < size; i++) {
+         if (total[i].count > max) max = total[i].count;
+      }
 
-      if (b == EOF) {
-         if (feof(file)) {
-            my_fatal("read_integer(): fgetc(): EOF reached\n");
-         } else { // error
-            my_fatal("read_integer(): fgetc(): %s\n",strerror(errno));
-         }
+      if (max <= WeightMax) break;
+
+      for (i = 0; i < size; i++) total[i].count = (total[i].count + 1) / 2;
+   }
+
+   // same for the learning counts, keeping each n and sum together
+
+   while (true) {
+
+      max = 0;
+      for (i = 0; i < size; i++) {
+         if (total[i].n > max) max = total[i].n;
+         if (total[i].sum > max) max = total[i].sum;
       }
 
-      ASSERT(b>=0&&b<256);
-      n = (n << 8) | b;
+      if (max <= WeightMax) break;
+
+      for (i = 0; i < size; i++) {
+         total[i].n = (total[i].n + 1) / 2;
+         total[i].sum = (total[i].sum + 1) / 2;
+      }
+   }
+
+   // highest weight first, as make-book does
+
+   qsort(total,size,sizeof(total_t),&total_compare);
+
+   for (i = 0; i < size; i++) {
+
+      entry->key = key;
+      entry->move = total[i].move;
+      entry->count = total[i].count;
+      entry->n = total[i].n;
+      entry->sum = total[i].sum;
+
+      write_entry(entry);
    }
+}
+
+// total_compare()
+
+static int total_compare(const void * p1, const void * p2) {
+
+   const total_t * total_1, * total_2;
+
+   ASSERT(p1!=NULL);
+   ASSERT(p2!=NULL);
+
+   total_1 = (const total_t *) p1;
+   total_2 = (const total_t *) p2;
 
-   return n;
+   if (total_1->count != total_2->count) {
+      return (total_1->count > total_2->count) ? -1 : +1;
+   } else {
+      return int(total_1->move) - int(total_2->move);
+   }
 }
 
-// write_integer()
+// write_entry()
 
-static void write_integer(FILE * file, int size, uint64 n) {
+static void write_entry(const polybook_entry_t * entry) {
 
+   unsigned char buffer[POLYBOOK_ENTRY_SIZE];
    int i;
-   int b;
 
-   ASSERT(file!=NULL);
-   ASSERT(size>0&&size<=8);
-   ASSERT(size==8||n>>(size*8)==0);
+   ASSERT(entry!=NULL);
 
-   for (i = size-1; i >= 0; i--) {
+   for (i = 0; i < 8; i++) buffer[i] = (entry->key >> ((7-i)*8)) & 0xFF;
 
-      b = (n >> (i*8)) & 0xFF;
-      ASSERT(b>=0&&b<256);
+   buffer[8]  = entry->move >> 8;
+   buffer[9]  = entry->move & 0xFF;
+   buffer[10] = entry->count >> 8;
+   buffer[11] = entry->count & 0xFF;
+   buffer[12] = entry->n >> 8;
+   buffer[13] = entry->n & 0xFF;
+   buffer[14] = entry->sum >> 8;
+   buffer[15] = entry->sum & 0xFF;
 
-      if (fputc(b,file) == EOF) {
-         my_fatal("write_integer(): fputc(): %s\n",strerror(errno));
-      }
+   if (fwrite(buffer,POLYBOOK_ENTRY_SIZE,1,Out) != 1) {
+      my_fatal("write_entry(): fwrite(): %s\n",strerror(errno));
    }
+
+   OutNb++;
 }
 
 }  // namespace adapter
 
 // end of book_merge.cpp
-
@@ -69,8 +69,8 @@ bool engine_is_ok(const engine_t * engine) {
 
 void engine_open(engine_t * engine) {
 
-   engine->io->in_fd = pipefd_e2a[0];
-   engine->io->out_fd = pipefd_a2e[1];
+   engine->io->in_queue = queue_e2a;
+   engine->io->out_queue = queue_a2e;
    engine->io->name = "ENGINE";
 
    io_init(engine->io);
@@ -102,6 +102,24 @@ void engine_get(engine_t * engine, char string[], int size) {
    }
 }
 
+// engine_get_view()
+
+void engine_get_view(engine_t * engine, const char ** string) {
+
+   ASSERT(engine_is_ok(engine));
+   ASSERT(string!=NULL);
+
+   // same as engine_get(), but the line is not copied
+
+   while (!io_line_ready(engine->io)) {
+      io_get_update(engine->io);
+   }
+
+   if (!io_get_view(engine->io,string)) { // EOF
+      exit(EXIT_SUCCESS);
+   }
+}
+
 // engine_send()
 
 void engine_send(engine_t * engine, const char format[], ...) {
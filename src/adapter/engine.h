@@ -49,6 +49,7 @@ extern void engine_open       (engine_t * engine);
 extern void engine_close      (engine_t * engine);
 
 extern void engine_get        (engine_t * engine, char string[], int size);
+extern void engine_get_view   (engine_t * engine, const char ** string);
 
 extern void engine_send       (engine_t * engine, const char format[], ...);
 extern void engine_send_queue (engine_t * engine, const char format[], ...);
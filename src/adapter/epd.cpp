@@ -28,6 +28,11 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include "board.h"
 #include "engine.h"
 #include "epd.h"
@@ -50,6 +55,42 @@ static const bool UseTrace = false;
 
 static const int StringSize = 4096;
 
+static const int JobMax = 256;
+
+// types
+
+struct epd_result_t {
+   char id[256];
+   bool solved;
+   int depth;
+   double time;
+   sint64 node_nb;
+};
+
+struct epd_results_t {
+   int size;
+   int alloc;
+   epd_result_t * result;
+};
+
+struct epd_report_t { // everything printed for one position
+   char id[StringSize];
+   bool correct;
+   int depth;
+   double time;
+   sint64 node_nb;
+   int score;
+   char move[256];
+   char pv[StringSize];
+};
+
+struct epd_worker_t {
+   pid_t pid;
+   int fd;
+   int size;
+   char buffer[StringSize*4];
+};
+
 // variables
 
 static int MinDepth;
@@ -60,6 +101,23 @@ static double MinTime;
 
 static int DepthDelta;
 
+static const char * ResultFile;
+static const char * BaselineFile;
+static double MaxNodeGrowth;
+
+static epd_results_t Results[1];
+
+static int JobNb;
+static int WorkerId;
+static int WorkerNb;
+
+static FILE * ResultStream;
+static int Hit;
+static int Tot;
+static double DepthTot;
+static double TimeTot;
+static double NodeTot;
+
 static int FirstMove;
 static int FirstDepth;
 static int FirstSelDepth;
@@ -79,6 +137,24 @@ static move_t LastPV[LineSize];
 // prototypes
 
 static void epd_test_file  (const char file_name[]);
+static void epd_test_jobs  (const char file_name[], int argc, char * argv[]);
+
+static void report_begin   ();
+static void report_disp    (const epd_report_t * report);
+static void report_end     ();
+static void report_send    (int index, const epd_report_t * report);
+static bool report_parse   (char line[], int * index, epd_report_t * report);
+
+static void results_init   (epd_results_t * results);
+static void results_add    (epd_results_t * results, const epd_result_t * result);
+static void results_load   (epd_results_t * results, const char file_name[]);
+static const epd_result_t * results_find (const epd_results_t * results, const char id[]);
+
+static void result_write   (FILE * file, const epd_result_t * result, int score, const char move_string[]);
+static bool result_read    (const char line[], epd_result_t * result);
+static void epd_strip_id   (char dst[], const char id[], int size);
+
+static bool compare_baseline (const epd_results_t * results, const char file_name[]);
 
 static bool is_solution    (int move, const board_t * board, const char bm[], const char am[]);
 static bool string_contain (const char string[], const char substring[]);
@@ -89,7 +165,7 @@ static bool engine_step    ();
 
 // epd_test()
 
-void epd_test(int argc, char * argv[]) {
+bool epd_test(int argc, char * argv[]) {
 
    int i;
    const char * epd_file;
@@ -105,6 +181,14 @@ void epd_test(int argc, char * argv[]) {
 
    DepthDelta = 3;
 
+   ResultFile = NULL;
+   BaselineFile = NULL;
+   MaxNodeGrowth = 10.0;
+
+   JobNb = 1;
+   WorkerId = 0;
+   WorkerNb = 0;
+
    for (i = 1; i < argc; i++) {
 
       if (false) {
@@ -155,13 +239,64 @@ void epd_test(int argc, char * argv[]) {
 
          DepthDelta = atoi(argv[i]);
 
+      } else if (my_string_equal(argv[i],"-results")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("epd_test(): missing argument\n");
+
+         my_string_set(&ResultFile,argv[i]);
+
+      } else if (my_string_equal(argv[i],"-baseline")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("epd_test(): missing argument\n");
+
+         my_string_set(&BaselineFile,argv[i]);
+
+      } else if (my_string_equal(argv[i],"-max-node-growth")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("epd_test(): missing argument\n");
+
+         MaxNodeGrowth = atof(argv[i]);
+
+      } else if (my_string_equal(argv[i],"-j")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("epd_test(): missing argument\n");
+
+         JobNb = atoi(argv[i]);
+         if (JobNb < 1 || JobNb > JobMax) my_fatal("epd_test(): -j must be between 1 and %d\n",JobMax);
+
+      } else if (my_string_equal(argv[i],"-worker")) { // internal, see epd_test_jobs()
+
+         if (argv[i+1] == NULL || argv[i+2] == NULL) my_fatal("epd_test(): missing argument\n");
+
+         WorkerId = atoi(argv[++i]);
+         WorkerNb = atoi(argv[++i]);
+
       } else {
 
          my_fatal("epd_test(): unknown option \"%s\"\n",argv[i]);
       }
    }
 
-   epd_test_file(epd_file);
+   results_init(Results);
+
+   if (WorkerNb != 0) { // child of epd_test_jobs()
+      epd_test_file(epd_file);
+      return true;
+   }
+
+   if (JobNb > 1) {
+      epd_test_jobs(epd_file,argc,argv);
+   } else {
+      epd_test_file(epd_file);
+   }
+
+   if (BaselineFile != NULL) return compare_baseline(Results,BaselineFile);
+
+   return true;
 }
 
 // epd_test_file()
@@ -169,15 +304,13 @@ void epd_test(int argc, char * argv[]) {
 static void epd_test_file(const char file_name[]) {
 
    FILE * file;
-   int hit, tot;
+   int index;
    char epd[StringSize];
    char am[StringSize], bm[StringSize], id[StringSize];
    board_t board[1];
    char string[StringSize];
    int move;
-   char pv_string[StringSize];
-   bool correct;
-   double depth_tot, time_tot, node_tot;
+   epd_report_t report[1];
 
    ASSERT(file_name!=NULL);
 
@@ -186,16 +319,15 @@ static void epd_test_file(const char file_name[]) {
    file = fopen(file_name,"r");
    if (file == NULL) my_fatal("epd_test_file(): can't open file \"%s\": %s\n",file_name,strerror(errno));
 
-   hit = 0;
-   tot = 0;
-
-   depth_tot = 0.0;
-   time_tot = 0.0;
-   node_tot = 0.0;
+   if (WorkerNb == 0) report_begin();
 
    // loop
 
-   while (my_file_read_line(file,epd,StringSize)) {
+   for (index = 0; my_file_read_line(file,epd,StringSize); index++) {
+
+      // in a worker, only every WorkerNb-th position is ours
+
+      if (WorkerNb != 0 && index % WorkerNb != WorkerId) continue;
 
       if (UseTrace) printf("%s\n",epd);
 
@@ -267,39 +399,531 @@ static void epd_test_file(const char file_name[]) {
       }
 
       move = FirstMove;
-      correct = is_solution(move,board,bm,am);
 
-      if (correct) hit++;
-      tot++;
+      strcpy(report->id,id);
+      report->correct = is_solution(move,board,bm,am);
+      report->depth = FirstDepth;
+      report->time = FirstTime;
+      report->node_nb = FirstNodeNb;
+      report->score = LastScore;
 
-      if (correct) {
-         depth_tot += double(FirstDepth);
-         time_tot += FirstTime;
-         node_tot += double(FirstNodeNb);
+      if (move == MoveNone || !move_to_san(move,board,report->move,256)) strcpy(report->move,"-");
+      if (!line_to_san(LastPV,Uci->board,report->pv,StringSize)) ASSERT(false);
+
+      if (WorkerNb != 0) {
+         report_send(index,report);
+      } else {
+         report_disp(report);
       }
+   }
+
+   if (WorkerNb == 0) report_end();
+
+   fclose(file);
+}
+
+// epd_test_jobs()
+
+static void epd_test_jobs(const char file_name[], int argc, char * argv[]) {
+
+   epd_worker_t * worker;
+   struct pollfd fd[JobMax];
+   char ** args;
+   char id_string[16], nb_string[16];
+   int pipefd[2];
+   int i, j, n, len, open_nb, status;
+   epd_report_t ** pending, * report;
+   int pending_alloc, next, index;
+   char * line, * end;
+
+   ASSERT(file_name!=NULL);
+   ASSERT(JobNb>1&&JobNb<=JobMax);
+
+   // each worker re-runs this command with "-worker <id> <nb>" appended,
+   // takes every JobNb-th position and prints one record per position
+
+   worker = (epd_worker_t *) my_malloc(JobNb*sizeof(epd_worker_t));
+
+   args = (char **) my_malloc((argc+4)*sizeof(char *));
+   for (i = 0; i < argc; i++) args[i] = argv[i];
+   args[argc+0] = (char *) "-worker";
+   args[argc+1] = id_string;
+   args[argc+2] = nb_string;
+   args[argc+3] = NULL;
+
+   sprintf(nb_string,"%d",JobNb);
+
+   fflush(stdout);
+
+   for (j = 0; j < JobNb; j++) {
+
+      sprintf(id_string,"%d",j);
+
+      if (pipe(pipefd) == -1) my_fatal("epd_test_jobs(): pipe(): %s\n",strerror(errno));
+
+      worker[j].pid = fork();
+      if (worker[j].pid == -1) my_fatal("epd_test_jobs(): fork(): %s\n",strerror(errno));
+
+      if (worker[j].pid == 0) { // child
+
+         dup2(pipefd[1],STDOUT_FILENO);
+         close(pipefd[0]);
+         close(pipefd[1]);
+
+         execv("/proc/self/exe",args);
+         execvp(args[0],args);
+         _exit(127);
+      }
+
+      close(pipefd[1]);
+
+      worker[j].fd = pipefd[0];
+      worker[j].size = 0;
+   }
+
+   // collect the records and print them in input order
+
+   pending_alloc = 256;
+   pending = (epd_report_t **) my_malloc(pending_alloc*sizeof(epd_report_t *));
+   for (i = 0; i < pending_alloc; i++) pending[i] = NULL;
+
+   next = 0;
+
+   report_begin();
+
+   open_nb = JobNb;
+
+   while (open_nb > 0) {
+
+      n = 0;
+
+      for (j = 0; j < JobNb; j++) {
+         if (worker[j].fd < 0) continue;
+         fd[n].fd = worker[j].fd;
+         fd[n].events = POLLIN;
+         fd[n].revents = 0;
+         n++;
+      }
+
+      if (poll(fd,n,-1) == -1) {
+         if (errno == EINTR) continue;
+         my_fatal("epd_test_jobs(): poll(): %s\n",strerror(errno));
+      }
+
+      for (j = 0; j < JobNb; j++) {
+
+         if (worker[j].fd < 0) continue;
+
+         for (i = 0; i < n; i++) {
+            if (fd[i].fd == worker[j].fd) break;
+         }
+
+         if (i == n || fd[i].revents == 0) continue;
+
+         len = read(worker[j].fd,&worker[j].buffer[worker[j].size],sizeof(worker[j].buffer)-1-worker[j].size);
+
+         if (len == -1 && errno == EINTR) continue;
+
+         if (len <= 0) { // EOF
+            close(worker[j].fd);
+            worker[j].fd = -1;
+            open_nb--;
+            continue;
+         }
+
+         worker[j].size += len;
+         worker[j].buffer[worker[j].size] = '\0';
+
+         // complete records
+
+         line = worker[j].buffer;
+
+         while ((end = strchr(line,'\n')) != NULL) {
+
+            *end = '\0';
+
+            report = (epd_report_t *) my_malloc(sizeof(epd_report_t));
+            index = -1;
+
+            if (!report_parse(line,&index,report)) my_fatal("epd_test_jobs(): bad record \"%s\"\n",line);
+
+            while (index >= pending_alloc) {
+               pending = (epd_report_t **) my_realloc(pending,pending_alloc*2*sizeof(epd_report_t *));
+               for (i = pending_alloc; i < pending_alloc*2; i++) pending[i] = NULL;
+               pending_alloc *= 2;
+            }
+
+            pending[index] = report;
+
+            while (next < pending_alloc && pending[next] != NULL) {
+               report_disp(pending[next]);
+               my_free(pending[next]);
+               pending[next] = NULL;
+               next++;
+            }
+
+            line = end + 1;
+         }
+
+         worker[j].size -= line - worker[j].buffer;
+         memmove(worker[j].buffer,line,worker[j].size);
+
+         if (worker[j].size >= int(sizeof(worker[j].buffer)) - 1) my_fatal("epd_test_jobs(): record too long\n");
+      }
+   }
+
+   // wait for the workers
+
+   for (j = 0; j < JobNb; j++) {
+      if (waitpid(worker[j].pid,&status,0) == -1) my_fatal("epd_test_jobs(): waitpid(): %s\n",strerror(errno));
+      if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) my_fatal("epd_test_jobs(): worker %d failed\n",j);
+   }
+
+   for (i = next; i < pending_alloc; i++) {
+      if (pending[i] != NULL) my_fatal("epd_test_jobs(): record %d missing\n",next);
+   }
+
+   report_end();
+
+   my_free(pending);
+   my_free(args);
+   my_free(worker);
+}
+
+// report_begin()
+
+static void report_begin() {
+
+   ResultStream = NULL;
+
+   if (ResultFile != NULL) {
+      ResultStream = fopen(ResultFile,"w");
+      if (ResultStream == NULL) my_fatal("report_begin(): can't open file \"%s\": %s\n",ResultFile,strerror(errno));
+      fprintf(ResultStream,"id,solved,depth,time,nodes,score,move\n");
+   }
+
+   Hit = 0;
+   Tot = 0;
+
+   DepthTot = 0.0;
+   TimeTot = 0.0;
+   NodeTot = 0.0;
+}
+
+// report_disp()
+
+static void report_disp(const epd_report_t * report) {
+
+   epd_result_t result[1];
+
+   ASSERT(report!=NULL);
 
-      printf("%s %d %4d %4d",id,correct,hit,tot);
+   if (report->correct) Hit++;
+   Tot++;
 
-      if (!line_to_san(LastPV,Uci->board,pv_string,StringSize)) ASSERT(false);
-      printf(" - %2d %6.2f %9lld %+6.2f %s\n",FirstDepth,FirstTime,FirstNodeNb,double(LastScore)/100.0,pv_string);
+   if (report->correct) {
+      DepthTot += double(report->depth);
+      TimeTot += report->time;
+      NodeTot += double(report->node_nb);
    }
 
-   printf("%d/%d",hit,tot);
+   printf("%s %d %4d %4d",report->id,report->correct,Hit,Tot);
+   printf(" - %2d %6.2f %9lld %+6.2f %s\n",report->depth,report->time,report->node_nb,double(report->score)/100.0,report->pv);
 
-   if (hit != 0) {
+   // machine-readable result
 
-      depth_tot /= double(hit);
-      time_tot /= double(hit);
-      node_tot /= double(hit);
+   epd_strip_id(result->id,report->id,sizeof(result->id));
+   result->solved = report->correct;
+   result->depth = report->depth;
+   result->time = report->time;
+   result->node_nb = report->node_nb;
 
-      printf(" - %.1f %.2f %.0f",depth_tot,time_tot,node_tot);
+   results_add(Results,result);
+
+   if (ResultStream != NULL) {
+      result_write(ResultStream,result,report->score,report->move);
+      fflush(ResultStream);
+   }
+}
+
+// report_end()
+
+static void report_end() {
+
+   printf("%d/%d",Hit,Tot);
+
+   if (Hit != 0) {
+      printf(" - %.1f %.2f %.0f",DepthTot/double(Hit),TimeTot/double(Hit),NodeTot/double(Hit));
    }
 
    printf("\n");
 
+   if (ResultStream != NULL) fclose(ResultStream);
+   ResultStream = NULL;
+}
+
+// report_send()
+
+static void report_send(int index, const epd_report_t * report) {
+
+   ASSERT(index>=0);
+   ASSERT(report!=NULL);
+
+   // tab-separated, the time is printed exactly so that the totals match
+
+   printf("%d\t%s\t%d\t%d\t%a\t" S64_FORMAT "\t%d\t%s\t%s\n",
+          index,report->id,report->correct,report->depth,report->time,report->node_nb,
+          report->score,report->move,report->pv);
+   fflush(stdout);
+}
+
+// report_parse()
+
+static bool report_parse(char line[], int * index, epd_report_t * report) {
+
+   char * field[9];
+   int i;
+   sint64 node_nb;
+
+   ASSERT(line!=NULL);
+   ASSERT(index!=NULL);
+   ASSERT(report!=NULL);
+
+   field[0] = line;
+
+   for (i = 1; i < 9; i++) {
+      field[i] = strchr(field[i-1],'\t');
+      if (field[i] == NULL) return false;
+      *field[i]++ = '\0';
+   }
+
+   if (strlen(field[1]) >= sizeof(report->id)) return false;
+   if (strlen(field[7]) >= sizeof(report->move)) return false;
+   if (strlen(field[8]) >= sizeof(report->pv)) return false;
+
+   *index = atoi(field[0]);
+   if (*index < 0) return false;
+
+   strcpy(report->id,field[1]);
+   report->correct = atoi(field[2]) != 0;
+   report->depth = atoi(field[3]);
+   report->time = strtod(field[4],NULL);
+   if (sscanf(field[5],S64_FORMAT,&node_nb) != 1) return false;
+   report->node_nb = node_nb;
+   report->score = atoi(field[6]);
+   strcpy(report->move,field[7]);
+   strcpy(report->pv,field[8]);
+
+   return true;
+}
+
+// results_init()
+
+static void results_init(epd_results_t * results) {
+
+   ASSERT(results!=NULL);
+
+   results->size = 0;
+   results->alloc = 256;
+   results->result = (epd_result_t *) my_malloc(results->alloc*sizeof(epd_result_t));
+}
+
+// results_add()
+
+static void results_add(epd_results_t * results, const epd_result_t * result) {
+
+   ASSERT(results!=NULL);
+   ASSERT(result!=NULL);
+
+   if (results->size >= results->alloc) {
+      results->alloc *= 2;
+      results->result = (epd_result_t *) my_realloc(results->result,results->alloc*sizeof(epd_result_t));
+   }
+
+   results->result[results->size++] = *result;
+}
+
+// results_load()
+
+static void results_load(epd_results_t * results, const char file_name[]) {
+
+   FILE * file;
+   char line[StringSize];
+   epd_result_t result[1];
+
+   ASSERT(results!=NULL);
+   ASSERT(file_name!=NULL);
+
+   file = fopen(file_name,"r");
+   if (file == NULL) my_fatal("results_load(): can't open file \"%s\": %s\n",file_name,strerror(errno));
+
+   while (my_file_read_line(file,line,StringSize)) {
+      if (result_read(line,result)) results_add(results,result);
+   }
+
    fclose(file);
 }
 
+// results_find()
+
+static const epd_result_t * results_find(const epd_results_t * results, const char id[]) {
+
+   int i;
+
+   ASSERT(results!=NULL);
+   ASSERT(id!=NULL);
+
+   for (i = 0; i < results->size; i++) {
+      if (my_string_equal(results->result[i].id,id)) return &results->result[i];
+   }
+
+   return NULL;
+}
+
+// result_write()
+
+static void result_write(FILE * file, const epd_result_t * result, int score, const char move_string[]) {
+
+   ASSERT(file!=NULL);
+   ASSERT(result!=NULL);
+   ASSERT(move_string!=NULL);
+
+   // ids may contain spaces but never double quotes
+
+   fprintf(file,"\"%s\",%d,%d,%.3f," S64_FORMAT ",%d,%s\n",
+           result->id,result->solved,result->depth,result->time,result->node_nb,score,move_string);
+}
+
+// result_read()
+
+static bool result_read(const char line[], epd_result_t * result) {
+
+   const char * end;
+   int len, solved;
+   sint64 node_nb;
+
+   ASSERT(line!=NULL);
+   ASSERT(result!=NULL);
+
+   // header or garbage
+
+   if (line[0] != '"') return false;
+
+   end = strchr(line+1,'"');
+   if (end == NULL) return false;
+
+   len = end - (line + 1);
+   if (len >= int(sizeof(result->id))) return false;
+
+   strncpy(result->id,line+1,len);
+   result->id[len] = '\0';
+
+   if (sscanf(end+1,",%d,%d,%lf," S64_FORMAT,&solved,&result->depth,&result->time,&node_nb) != 4) {
+      return false;
+   }
+
+   result->solved = solved != 0;
+   result->node_nb = node_nb;
+
+   return true;
+}
+
+// epd_strip_id()
+
+static void epd_strip_id(char dst[], const char id[], int size) {
+
+   int len;
+
+   ASSERT(dst!=NULL);
+   ASSERT(id!=NULL);
+   ASSERT(size>0);
+
+   // id "BT2630-01" -> BT2630-01
+
+   len = strlen(id);
+
+   if (len >= 2 && id[0] == '"' && id[len-1] == '"') {
+      id++;
+      len -= 2;
+   }
+
+   if (len >= size) len = size - 1;
+
+   memcpy(dst,id,len);
+   dst[len] = '\0';
+}
+
+// compare_baseline()
+
+static bool compare_baseline(const epd_results_t * results, const char file_name[]) {
+
+   epd_results_t baseline[1];
+   const epd_result_t * base, * curr;
+   int i;
+   int common, base_hit, curr_hit;
+   double base_nodes, curr_nodes, growth;
+   bool ok;
+
+   ASSERT(results!=NULL);
+   ASSERT(file_name!=NULL);
+
+   results_init(baseline);
+   results_load(baseline,file_name);
+
+   // only positions present in both runs are compared
+
+   common = 0;
+   base_hit = 0;
+   curr_hit = 0;
+
+   base_nodes = 0.0;
+   curr_nodes = 0.0;
+
+   for (i = 0; i < results->size; i++) {
+
+      curr = &results->result[i];
+      base = results_find(baseline,curr->id);
+      if (base == NULL) continue;
+
+      common++;
+
+      if (base->solved) base_hit++;
+      if (curr->solved) curr_hit++;
+
+      if (base->solved && !curr->solved) {
+         printf("regression: %s no longer solved\n",curr->id);
+      } else if (!base->solved && curr->solved) {
+         printf("progression: %s now solved\n",curr->id);
+      }
+
+      if (base->solved && curr->solved) {
+         base_nodes += double(base->node_nb);
+         curr_nodes += double(curr->node_nb);
+      }
+   }
+
+   growth = (base_nodes > 0.0) ? (curr_nodes / base_nodes - 1.0) * 100.0 : 0.0;
+
+   printf("baseline %d/%d, current %d/%d, nodes to solution %+.1f%% (max %+.1f%%)\n",
+          base_hit,common,curr_hit,common,growth,MaxNodeGrowth);
+
+   ok = true;
+
+   if (curr_hit < base_hit) {
+      printf("FAILED: solve rate dropped\n");
+      ok = false;
+   }
+
+   if (growth > MaxNodeGrowth) {
+      printf("FAILED: nodes to solution grew past the threshold\n");
+      ok = false;
+   }
+
+   my_free(baseline->result);
+
+   return ok;
+}
+
 // is_solution()
 
 static bool is_solution(int move, const board_t * board, const char bm[], const char am[]) {
@@ -346,11 +970,14 @@ bool epd_get_op(const char record[], const char opcode[], char string[], int siz
    ASSERT(string!=NULL);
    ASSERT(size>0);
 
-   // find the opcode
+   // find the opcode, after a space or after the ';' of the previous operation
 
-   sprintf(op," %s ",opcode);
+   sprintf(op,"%s ",opcode);
+
+   for (p_start = strstr(record,op); p_start != NULL; p_start = strstr(p_start+1,op)) {
+      if (p_start > record && (p_start[-1] == ' ' || p_start[-1] == ';')) break;
+   }
 
-   p_start = strstr(record,op);
    if (p_start == NULL) return false;
 
    // skip the opcode
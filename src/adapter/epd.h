@@ -32,7 +32,7 @@ namespace adapter {
 
 // functions
 
-extern void epd_test   (int argc, char * argv[]);
+extern bool epd_test   (int argc, char * argv[]);
 
 extern bool epd_get_op (const char record[], const char opcode[], char string[], int size);
 
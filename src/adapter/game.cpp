@@ -116,6 +116,8 @@ bool game_init(game_t * game, const char fen[]) {
    board_copy(game->board,game->start_board);
    game->pos = 0;
 
+   board_copy(&game->checkpoint[0],game->start_board);
+
    game_update(game);
 
    return true;
@@ -171,12 +173,13 @@ void game_get_board(const game_t * game, board_t * board, int pos) {
 
    if (pos < 0) pos = game->pos;
 
-   if (pos >= game->pos) { // forward from current position
+   start = pos - pos % GameCheckpointSize;
+
+   if (game->pos <= pos && game->pos >= start) { // forward from current position
       start = game->pos;
       board_copy(board,game->board);
-   } else { // backward => replay the whole game
-      start = 0;
-      board_copy(board,game->start_board);
+   } else { // replay from the last snapshot
+      board_copy(board,&game->checkpoint[start/GameCheckpointSize]);
    }
 
    for (i = start; i < pos; i++) move_do(board,game->move[i]);
@@ -217,6 +220,10 @@ void game_add_move(game_t * game, int move) {
    move_do(game->board,move);
    game->pos++;
 
+   if (game->pos % GameCheckpointSize == 0) {
+      board_copy(&game->checkpoint[game->pos/GameCheckpointSize],game->board);
+   }
+
    game->size = game->pos; // truncate game, HACK: before calling game_is_ok() in game_update()
 
    game_update(game);
@@ -237,14 +244,17 @@ void game_rem_move(game_t * game) {
 
 void game_goto(game_t * game, int pos) {
 
+   int start;
    int i;
 
    ASSERT(game!=NULL);
    ASSERT(pos>=0&&pos<=game->size);
 
-   if (pos < game->pos) { // going backward => replay the whole game
-      board_copy(game->board,game->start_board);
-      game->pos = 0;
+   start = pos - pos % GameCheckpointSize;
+
+   if (pos < game->pos || game->pos < start) { // replay from the last snapshot
+      board_copy(game->board,&game->checkpoint[start/GameCheckpointSize]);
+      game->pos = start;
    }
 
    for (i = game->pos; i < pos; i++) move_do(game->board,game->move[i]);
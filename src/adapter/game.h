@@ -36,6 +36,8 @@ namespace adapter {
 
 const int GameSize = 4096;
 
+const int GameCheckpointSize = 16; // plies between board snapshots
+
 enum status_t {
    PLAYING,
    WHITE_MATES,
@@ -56,6 +58,7 @@ struct game_t {
    sint8 status;
    move_t move[GameSize];
    uint64 key[GameSize];
+   board_t checkpoint[GameSize/GameCheckpointSize+1]; // board before move i*GameCheckpointSize
 };
 
 // variables
@@ -0,0 +1,390 @@
+/* gamedb.cpp
+
+   GNU Chess protocol adapter
+
+   Copyright (C) 2001-2011 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// gamedb.cpp
+
+// binary game database, "make-gamedb" converts PGN files to it
+//
+// all integers are big-endian
+//
+// header (32 bytes): magic "GCHESSDB", version (4), number of games (4),
+//                    offset of the index (8), reserved (8)
+// game:  result (1), white Elo (2), black Elo (2),
+//        white, black and FEN (an empty FEN is the starting position),
+//        each as a length (1) and the characters,
+//        number of plies (2), one byte per ply: the index of the move
+//        among the pseudo-legal moves of the position, sorted by move code
+// index: offset of each game (8)
+
+// includes
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "fen.h"
+#include "gamedb.h"
+#include "list.h"
+#include "move.h"
+#include "move_gen.h"
+#include "move_legal.h"
+#include "util.h"
+
+namespace adapter {
+
+// constants
+
+static const int MagicSize = 8;
+
+// prototypes
+
+static int    gen_codes    (const board_t * board, int move[]);
+static int    select_move  (int move[], int size, int rank);
+
+static uint64 read_integer (const uint8 * p, int size);
+static void   read_string  (const gamedb_t * db, sint64 * pos, char string[]);
+
+// functions
+
+// gamedb_is()
+
+bool gamedb_is(const char file_name[]) {
+
+   FILE * file;
+   char magic[MagicSize];
+   bool is_db;
+
+   ASSERT(file_name!=NULL);
+
+   file = fopen(file_name,"rb");
+   if (file == NULL) return false;
+
+   is_db = fread(magic,1,MagicSize,file) == size_t(MagicSize) && memcmp(magic,GameDbMagic,MagicSize) == 0;
+
+   fclose(file);
+
+   return is_db;
+}
+
+// gamedb_open()
+
+void gamedb_open(gamedb_t * db, const char file_name[]) {
+
+   int fd;
+   struct stat st;
+   void * map;
+
+   ASSERT(db!=NULL);
+   ASSERT(file_name!=NULL);
+
+   fd = open(file_name,O_RDONLY);
+   if (fd == -1) my_fatal("gamedb_open(): can't open file \"%s\": %s\n",file_name,strerror(errno));
+
+   if (fstat(fd,&st) == -1) my_fatal("gamedb_open(): fstat(): %s\n",strerror(errno));
+
+   if (st.st_size < GameDbHeaderSize) my_fatal("gamedb_open(): \"%s\" is not a game database\n",file_name);
+
+   map = mmap(NULL,size_t(st.st_size),PROT_READ,MAP_PRIVATE,fd,0);
+   if (map == MAP_FAILED) my_fatal("gamedb_open(): mmap(): %s\n",strerror(errno));
+
+   close(fd);
+
+   db->data = (const uint8 *) map;
+   db->size = sint64(st.st_size);
+
+   // header
+
+   if (memcmp(db->data,GameDbMagic,MagicSize) != 0) my_fatal("gamedb_open(): \"%s\" is not a game database\n",file_name);
+   if (read_integer(&db->data[8],4) != uint64(GameDbVersion)) my_fatal("gamedb_open(): \"%s\": unknown version\n",file_name);
+
+   db->game_nb = int(read_integer(&db->data[12],4));
+   db->index = sint64(read_integer(&db->data[16],8));
+
+   if (db->index < GameDbHeaderSize || db->index + sint64(db->game_nb) * 8 > db->size) {
+      my_fatal("gamedb_open(): \"%s\" is truncated\n",file_name);
+   }
+}
+
+// gamedb_close()
+
+void gamedb_close(gamedb_t * db) {
+
+   ASSERT(db!=NULL);
+
+   munmap((void *) db->data,size_t(db->size));
+
+   db->data = NULL;
+   db->size = 0;
+   db->game_nb = 0;
+}
+
+// gamedb_offset()
+
+sint64 gamedb_offset(const gamedb_t * db, int game) {
+
+   ASSERT(db!=NULL);
+   ASSERT(game>=0&&game<=db->game_nb);
+
+   if (game == db->game_nb) return db->index; // end of the games
+
+   return sint64(read_integer(&db->data[db->index+sint64(game)*8],8));
+}
+
+// gamedb_find()
+
+int gamedb_find(const gamedb_t * db, sint64 pos) {
+
+   int left, right, mid;
+
+   ASSERT(db!=NULL);
+
+   // first game that starts at or after "pos"
+
+   left = 0;
+   right = db->game_nb;
+
+   while (left < right) {
+      mid = left + (right - left) / 2;
+      if (gamedb_offset(db,mid) < pos) {
+         left = mid + 1;
+      } else {
+         right = mid;
+      }
+   }
+
+   return left;
+}
+
+// gamedb_read()
+
+void gamedb_read(const gamedb_t * db, int game, gamedb_game_t * info) {
+
+   sint64 pos;
+
+   ASSERT(db!=NULL);
+   ASSERT(game>=0&&game<db->game_nb);
+   ASSERT(info!=NULL);
+
+   pos = gamedb_offset(db,game);
+   if (pos < GameDbHeaderSize || pos + 5 > db->index) my_fatal("gamedb_read(): game %d is corrupt\n",game+1);
+
+   info->result = db->data[pos];
+   info->white_elo = int(read_integer(&db->data[pos+1],2));
+   info->black_elo = int(read_integer(&db->data[pos+3],2));
+   pos += 5;
+
+   read_string(db,&pos,info->white);
+   read_string(db,&pos,info->black);
+   read_string(db,&pos,info->fen);
+
+   if (pos + 2 > db->index) my_fatal("gamedb_read(): game %d is corrupt\n",game+1);
+
+   info->ply_nb = int(read_integer(&db->data[pos],2));
+   pos += 2;
+
+   if (pos + info->ply_nb > db->index) my_fatal("gamedb_read(): game %d is corrupt\n",game+1);
+
+   info->move = &db->data[pos];
+   info->ply = 0;
+}
+
+// gamedb_start()
+
+void gamedb_start(const gamedb_game_t * info, board_t * board) {
+
+   ASSERT(info!=NULL);
+   ASSERT(board!=NULL);
+
+   if (info->fen[0] == '\0') {
+      board_start(board);
+   } else if (!board_from_fen(board,info->fen)) {
+      my_fatal("gamedb_start(): bad FEN \"%s\"\n",info->fen);
+   }
+}
+
+// gamedb_next_move()
+
+bool gamedb_next_move(gamedb_game_t * info, const board_t * board, int * move) {
+
+   int list[ListSize];
+   int size;
+   int code;
+
+   ASSERT(info!=NULL);
+   ASSERT(board!=NULL);
+   ASSERT(move!=NULL);
+
+   if (info->ply >= info->ply_nb) return false;
+
+   code = info->move[info->ply++];
+
+   size = gen_codes(board,list);
+   if (code >= size) my_fatal("gamedb_next_move(): corrupt move at ply %d\n",info->ply);
+
+   *move = select_move(list,size,code);
+
+   return true;
+}
+
+// gamedb_move_code()
+
+int gamedb_move_code(const board_t * board, int move) {
+
+   int list[ListSize];
+   int size;
+   int i;
+   int rank;
+
+   ASSERT(board!=NULL);
+
+   // rank of the move in the list sorted by move code, -1 if it is not legal
+
+   if (!move_is_legal(move,board)) return -1;
+
+   size = gen_codes(board,list);
+
+   rank = 0;
+   for (i = 0; i < size; i++) {
+      if (list[i] < move) rank++;
+   }
+
+   return rank;
+}
+
+// gen_codes()
+
+static int gen_codes(const board_t * board, int move[]) {
+
+   list_t list[1];
+   int size;
+   int i;
+
+   ASSERT(board!=NULL);
+   ASSERT(move!=NULL);
+
+   // the generation order depends on the piece lists, moves are numbered
+   // by their rank in move-code order so that the encoding only depends
+   // on the position
+   // pseudo-legal moves are enough to number the moves, and much faster
+   // to generate than legal ones
+
+   gen_moves(list,board);
+   size = list_size(list);
+
+   for (i = 0; i < size; i++) move[i] = list_move(list,i);
+
+   return size;
+}
+
+// select_move()
+
+static int select_move(int move[], int size, int rank) {
+
+   int left, right;
+   int i, j;
+   int pivot, tmp;
+
+   ASSERT(move!=NULL);
+   ASSERT(rank>=0&&rank<size);
+
+   // quickselect, the list is not sorted as a whole
+
+   left = 0;
+   right = size - 1;
+
+   while (left < right) {
+
+      pivot = move[(left+right)/2];
+      i = left;
+      j = right;
+
+      while (i <= j) {
+         while (move[i] < pivot) i++;
+         while (move[j] > pivot) j--;
+         if (i <= j) {
+            tmp = move[i];
+            move[i] = move[j];
+            move[j] = tmp;
+            i++;
+            j--;
+         }
+      }
+
+      if (rank <= j) {
+         right = j;
+      } else if (rank >= i) {
+         left = i;
+      } else {
+         break;
+      }
+   }
+
+   return move[rank];
+}
+
+// read_integer()
+
+static uint64 read_integer(const uint8 * p, int size) {
+
+   uint64 n;
+   int i;
+
+   ASSERT(p!=NULL);
+   ASSERT(size>0&&size<=8);
+
+   n = 0;
+   for (i = 0; i < size; i++) n = (n << 8) | p[i];
+
+   return n;
+}
+
+// read_string()
+
+static void read_string(const gamedb_t * db, sint64 * pos, char string[]) {
+
+   int size;
+
+   ASSERT(db!=NULL);
+   ASSERT(pos!=NULL);
+   ASSERT(string!=NULL);
+
+   if (*pos + 1 > db->index) my_fatal("read_string(): corrupt database\n");
+
+   size = db->data[*pos];
+   (*pos)++;
+
+   if (*pos + size > db->index) my_fatal("read_string(): corrupt database\n");
+
+   memcpy(string,&db->data[*pos],size);
+   string[size] = '\0';
+
+   *pos += size;
+}
+
+}  // namespace adapter
+
+// end of gamedb.cpp
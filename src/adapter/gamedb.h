@@ -0,0 +1,92 @@
+/* gamedb.h
+
+   GNU Chess protocol adapter
+
+   Copyright (C) 2001-2011 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// gamedb.h
+
+#ifndef GAMEDB_H
+#define GAMEDB_H
+
+// includes
+
+#include "board.h"
+#include "util.h"
+
+namespace adapter {
+
+// constants
+
+const int GAMEDB_STRING_SIZE = 256;
+
+const char GameDbMagic[] = "GCHESSDB"; // 8 characters
+const int GameDbVersion = 1;
+const int GameDbHeaderSize = 32;
+
+// result of a game
+
+const int GameDbUnknown = 0;
+const int GameDbWhiteWins = 1;
+const int GameDbBlackWins = 2;
+const int GameDbDraw = 3;
+
+// types
+
+struct gamedb_t {
+   const uint8 * data; // the whole file, mapped in memory
+   sint64 size;
+   int game_nb;
+   sint64 index; // offset of the game offsets
+};
+
+struct gamedb_game_t {
+   int result;
+   int white_elo; // 0 if unknown
+   int black_elo;
+   char white[GAMEDB_STRING_SIZE];
+   char black[GAMEDB_STRING_SIZE];
+   char fen[GAMEDB_STRING_SIZE]; // empty for the starting position
+   int ply_nb;
+   const uint8 * move;
+   int ply; // next move
+};
+
+// functions
+
+extern bool   gamedb_is        (const char file_name[]);
+
+extern void   gamedb_open      (gamedb_t * db, const char file_name[]);
+extern void   gamedb_close     (gamedb_t * db);
+
+extern sint64 gamedb_offset    (const gamedb_t * db, int game);
+extern int    gamedb_find      (const gamedb_t * db, sint64 pos);
+
+extern void   gamedb_read      (const gamedb_t * db, int game, gamedb_game_t * info);
+extern void   gamedb_start     (const gamedb_game_t * info, board_t * board);
+extern bool   gamedb_next_move (gamedb_game_t * info, const board_t * board, int * move);
+
+extern int    gamedb_move_code (const board_t * board, int move);
+
+extern void   gamedb_make      (int argc, char * argv[]);
+
+}  // namespace adapter
+
+#endif // !defined GAMEDB_H
+
+// end of gamedb.h
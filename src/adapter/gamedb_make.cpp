@@ -0,0 +1,284 @@
+/* gamedb_make.cpp
+
+   GNU Chess protocol adapter
+
+   Copyright (C) 2001-2011 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// gamedb_make.cpp
+
+// includes
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "board.h"
+#include "fen.h"
+#include "gamedb.h"
+#include "move.h"
+#include "move_do.h"
+#include "move_legal.h"
+#include "pgn.h"
+#include "san.h"
+#include "util.h"
+
+namespace adapter {
+
+// constants
+
+static const int PlyMax = 65535;
+
+static const int BufferSize = 1048576; // output buffer
+
+// variables
+
+static FILE * Out;
+static sint64 OutPos;
+
+static uint8 Move[PlyMax];
+
+// prototypes
+
+static void write_game    (const pgn_t * pgn, int ply_nb);
+static void write_string  (const char string[]);
+static void write_integer (int size, uint64 n);
+
+// functions
+
+// gamedb_make()
+
+void gamedb_make(int argc, char * argv[]) {
+
+   int i;
+   const char * pgn_file;
+   const char * db_file;
+   pgn_t pgn[1];
+   board_t board[1];
+   char string[256];
+   int move;
+   int code;
+   int ply_nb;
+   int line, column;
+   sint64 * offset;
+   int alloc;
+   int game_nb;
+   sint64 index;
+
+   pgn_file = NULL;
+   my_string_set(&pgn_file,"games.pgn");
+
+   db_file = NULL;
+   my_string_set(&db_file,"games.db");
+
+   for (i = 1; i < argc; i++) {
+
+      if (false) {
+
+      } else if (my_string_equal(argv[i],"make-gamedb")) {
+
+         // skip
+
+      } else if (my_string_equal(argv[i],"-pgn")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("gamedb_make(): missing argument\n");
+
+         my_string_set(&pgn_file,argv[i]);
+
+      } else if (my_string_equal(argv[i],"-db")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("gamedb_make(): missing argument\n");
+
+         my_string_set(&db_file,argv[i]);
+
+      } else {
+
+         my_fatal("gamedb_make(): unknown option \"%s\"\n",argv[i]);
+      }
+   }
+
+   // init
+
+   pgn_open(pgn,pgn_file);
+
+   Out = fopen(db_file,"wb");
+   if (Out == NULL) my_fatal("gamedb_make(): can't open file \"%s\" for writing: %s\n",db_file,strerror(errno));
+   setvbuf(Out,NULL,_IOFBF,BufferSize);
+
+   OutPos = 0;
+
+   for (i = 0; i < GameDbHeaderSize; i++) write_integer(1,0); // written at the end
+
+   alloc = 65536;
+   offset = (sint64 *) my_malloc(alloc*sizeof(sint64));
+
+   game_nb = 0;
+
+   // game loop
+
+   while (pgn_next_game(pgn)) {
+
+      if (pgn->fen[0] == '\0') {
+         board_start(board);
+      } else if (!board_from_fen(board,pgn->fen)) {
+         my_fatal("gamedb_make(): bad FEN \"%s\"\n",pgn->fen);
+      }
+
+      ply_nb = 0;
+
+      while (pgn_next_move(pgn,string,256)) {
+
+         move = move_from_san(string,board);
+
+         if (move == MoveNone || !move_is_legal(move,board)) {
+            pgn_line_column(pgn,pgn->move_pos,&line,&column);
+            my_fatal("gamedb_make(): illegal move \"%s\" at line %d, column %d\n",string,line,column);
+         }
+
+         if (ply_nb >= PlyMax) {
+            pgn_line_column(pgn,pgn->move_pos,&line,&column);
+            my_fatal("gamedb_make(): game too long at line %d, column %d\n",line,column);
+         }
+
+         code = gamedb_move_code(board,move);
+         ASSERT(code>=0&&code<256);
+
+         Move[ply_nb++] = code;
+
+         move_do(board,move);
+      }
+
+      if (game_nb == alloc) {
+         alloc *= 2;
+         offset = (sint64 *) my_realloc(offset,alloc*sizeof(sint64));
+      }
+
+      offset[game_nb++] = OutPos;
+
+      write_game(pgn,ply_nb);
+
+      if (game_nb % 10000 == 0) printf("%d games ...\n",game_nb);
+   }
+
+   pgn_close(pgn);
+
+   // index
+
+   index = OutPos;
+
+   for (i = 0; i < game_nb; i++) write_integer(8,offset[i]);
+
+   my_free(offset);
+
+   // header
+
+   if (fflush(Out) == EOF || fseeko(Out,0,SEEK_SET) != 0) {
+      my_fatal("gamedb_make(): can't write file \"%s\": %s\n",db_file,strerror(errno));
+   }
+
+   for (i = 0; i < 8; i++) write_integer(1,GameDbMagic[i]);
+   write_integer(4,GameDbVersion);
+   write_integer(4,game_nb);
+   write_integer(8,index);
+   write_integer(8,0); // reserved
+
+   if (fclose(Out) == EOF) my_fatal("gamedb_make(): fclose(): %s\n",strerror(errno));
+
+   printf("%d game%s.\n",game_nb,(game_nb>1)?"s":"");
+   printf("%lld bytes.\n",index+sint64(game_nb)*8);
+}
+
+// write_game()
+
+static void write_game(const pgn_t * pgn, int ply_nb) {
+
+   int result;
+   int elo;
+   int i;
+
+   ASSERT(pgn!=NULL);
+   ASSERT(ply_nb>=0&&ply_nb<=PlyMax);
+
+   result = GameDbUnknown;
+
+   if (false) {
+   } else if (my_string_equal(pgn->result,"1-0")) {
+      result = GameDbWhiteWins;
+   } else if (my_string_equal(pgn->result,"0-1")) {
+      result = GameDbBlackWins;
+   } else if (my_string_equal(pgn->result,"1/2-1/2")) {
+      result = GameDbDraw;
+   }
+
+   write_integer(1,result);
+
+   elo = atoi(pgn->white_elo);
+   write_integer(2,(elo>0&&elo<65536)?elo:0);
+
+   elo = atoi(pgn->black_elo);
+   write_integer(2,(elo>0&&elo<65536)?elo:0);
+
+   write_string(pgn->white);
+   write_string(pgn->black);
+   write_string(pgn->fen);
+
+   write_integer(2,ply_nb);
+
+   for (i = 0; i < ply_nb; i++) write_integer(1,Move[i]);
+}
+
+// write_string()
+
+static void write_string(const char string[]) {
+
+   int size;
+   int i;
+
+   ASSERT(string!=NULL);
+
+   size = strlen(string);
+   if (size > 255) size = 255; // longer names are cut
+
+   write_integer(1,size);
+
+   for (i = 0; i < size; i++) write_integer(1,uint8(string[i]));
+}
+
+// write_integer()
+
+static void write_integer(int size, uint64 n) {
+
+   int i;
+
+   ASSERT(size>0&&size<=8);
+   ASSERT(size==8||n>>(size*8)==0);
+
+   for (i = size-1; i >= 0; i--) {
+      if (putc((n >> (i*8)) & 0xFF,Out) == EOF) {
+         my_fatal("write_integer(): putc(): %s\n",strerror(errno));
+      }
+   }
+
+   OutPos += size;
+}
+
+}  // namespace adapter
+
+// end of gamedb_make.cpp
@@ -0,0 +1,673 @@
+/* gameindex.cpp
+
+   GNU Chess protocol adapter
+
+   Copyright (C) 2001-2011 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// gameindex.cpp
+
+// position index, the games of a collection that reached each position,
+// built by "make-book -index" and queried by "find-games"
+//
+// all integers are big-endian
+//
+// header (32 bytes): magic "GCHESSIX", version (4), prefix bits (4),
+//                    number of positions (8), number of postings (8)
+// prefix: for each value of the top bits of the key, the first position
+//         with this prefix (4), then an extra item holding the
+//         number of positions
+// positions: Polyglot key (8) and first posting (8), sorted by key,
+//            then an extra item holding the number of postings
+// postings: game numbers (4), counted from 0 in file order, ascending
+//           for each position
+//
+// a lookup reads the prefix item, searches the few positions sharing
+// the prefix (about one page) and reads the postings
+
+// includes
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "fen.h"
+#include "gamedb.h"
+#include "gameindex.h"
+#include "move.h"
+#include "move_do.h"
+#include "move_legal.h"
+#include "san.h"
+#include "util.h"
+
+namespace adapter {
+
+// constants
+
+static const int MagicSize = 8;
+
+static const int BucketSize = 256; // positions per prefix, one page
+static const int BitsMax = 24;
+
+static const int BufferSize = 1048576; // output buffer
+
+static const int DispMax = 100; // game numbers shown by gameindex_disp()
+
+// variables
+
+static gameindex_t Index[1]; // gameindex_disp() only
+static const char * IndexFile;
+
+static gameindex_run_t * Run;
+static int * Heap; // runs ordered by their next item
+static int HeapSize;
+
+static FILE * Out;
+
+// prototypes
+
+static void   disp_games    (const gameindex_t * index, uint64 key, const gamedb_t * db, int max);
+
+static bool   run_next      (gameindex_run_t * run);
+static void   heap_down     (int pos);
+static bool   item_less     (const gameindex_run_t * run1, const gameindex_run_t * run2);
+static int    item_compare  (const void * p1, const void * p2);
+
+static FILE * temp_file     (const char file_name[]);
+
+static uint64 read_integer  (const uint8 * p, int size);
+static void   write_integer (FILE * file, int size, uint64 n);
+
+// functions
+
+// gameindex_open()
+
+void gameindex_open(gameindex_t * index, const char file_name[]) {
+
+   int fd;
+   struct stat st;
+   void * map;
+   sint64 size;
+
+   ASSERT(index!=NULL);
+   ASSERT(file_name!=NULL);
+
+   fd = open(file_name,O_RDONLY);
+   if (fd == -1) my_fatal("gameindex_open(): can't open file \"%s\": %s\n",file_name,strerror(errno));
+
+   if (fstat(fd,&st) == -1) my_fatal("gameindex_open(): fstat(): %s\n",strerror(errno));
+
+   if (st.st_size < GameIndexHeaderSize) my_fatal("gameindex_open(): \"%s\" is not a position index\n",file_name);
+
+   map = mmap(NULL,size_t(st.st_size),PROT_READ,MAP_SHARED,fd,0);
+   if (map == MAP_FAILED) my_fatal("gameindex_open(): mmap(): %s\n",strerror(errno));
+
+   close(fd);
+
+   // lookups touch a few scattered pages
+
+   madvise(map,size_t(st.st_size),MADV_RANDOM);
+
+   index->data = (const uint8 *) map;
+   index->size = sint64(st.st_size);
+
+   // header
+
+   if (memcmp(index->data,GameIndexMagic,MagicSize) != 0) my_fatal("gameindex_open(): \"%s\" is not a position index\n",file_name);
+   if (read_integer(&index->data[8],4) != uint64(GameIndexVersion)) my_fatal("gameindex_open(): \"%s\": unknown version\n",file_name);
+
+   index->bits = int(read_integer(&index->data[12],4));
+   index->key_nb = sint64(read_integer(&index->data[16],8));
+   index->posting_nb = sint64(read_integer(&index->data[24],8));
+
+   if (index->bits > BitsMax) my_fatal("gameindex_open(): \"%s\" is corrupt\n",file_name);
+
+   size = GameIndexHeaderSize + ((sint64(1) << index->bits) + 1) * 4 + (index->key_nb + 1) * 16 + index->posting_nb * 4;
+   if (size != index->size) my_fatal("gameindex_open(): \"%s\" is truncated\n",file_name);
+
+   index->prefix = &index->data[GameIndexHeaderSize];
+   index->key = index->prefix + ((sint64(1) << index->bits) + 1) * 4;
+   index->posting = index->key + (index->key_nb + 1) * 16;
+}
+
+// gameindex_close()
+
+void gameindex_close(gameindex_t * index) {
+
+   ASSERT(index!=NULL);
+
+   munmap((void *) index->data,size_t(index->size));
+
+   index->data = NULL;
+   index->size = 0;
+   index->key_nb = 0;
+   index->posting_nb = 0;
+}
+
+// gameindex_find()
+
+int gameindex_find(const gameindex_t * index, uint64 key, sint64 * first) {
+
+   uint64 prefix;
+   sint64 left, right, mid;
+   sint64 end;
+
+   ASSERT(index!=NULL);
+   ASSERT(first!=NULL);
+
+   // returns the number of games reaching the position
+
+   prefix = (index->bits == 0) ? 0 : key >> (64 - index->bits);
+
+   left = sint64(read_integer(&index->prefix[prefix*4],4));
+   right = sint64(read_integer(&index->prefix[(prefix+1)*4],4));
+
+   if (left > right || right > index->key_nb) my_fatal("gameindex_find(): corrupt index\n");
+
+   while (left < right) {
+      mid = left + (right - left) / 2;
+      if (read_integer(&index->key[mid*16],8) < key) {
+         left = mid + 1;
+      } else {
+         right = mid;
+      }
+   }
+
+   if (left == index->key_nb || read_integer(&index->key[left*16],8) != key) return 0;
+
+   *first = sint64(read_integer(&index->key[left*16+8],8));
+   end = sint64(read_integer(&index->key[(left+1)*16+8],8));
+
+   if (*first > end || end > index->posting_nb) my_fatal("gameindex_find(): corrupt index\n");
+
+   return int(end - *first);
+}
+
+// gameindex_game()
+
+int gameindex_game(const gameindex_t * index, sint64 pos) {
+
+   ASSERT(index!=NULL);
+   ASSERT(pos>=0&&pos<index->posting_nb);
+
+   return int(read_integer(&index->posting[pos*4],4));
+}
+
+// gameindex_run()
+
+FILE * gameindex_run(const char file_name[], gameindex_item_t item[], int size) {
+
+   FILE * file;
+   int src, dst;
+
+   ASSERT(file_name!=NULL);
+   ASSERT(item!=NULL);
+   ASSERT(size>=0);
+
+   // sort the items, drop repeated positions and spill them next to the index
+
+   qsort(item,size,sizeof(gameindex_item_t),&item_compare);
+
+   dst = 0;
+
+   for (src = 0; src < size; src++) {
+      if (dst == 0 || item[src].key != item[dst-1].key || item[src].game != item[dst-1].game) {
+         item[dst++] = item[src];
+      }
+   }
+
+   file = temp_file(file_name);
+
+   if (fwrite(item,sizeof(gameindex_item_t),dst,file) != size_t(dst)) {
+      my_fatal("gameindex_run(): fwrite(): %s\n",strerror(errno));
+   }
+
+   return file;
+}
+
+// gameindex_build()
+
+void gameindex_build(const char file_name[], gameindex_run_t run[], int run_nb, sint64 item_nb) {
+
+   FILE * posting;
+   uint32 * prefix;
+   int bits;
+   sint64 prefix_nb;
+   sint64 next;
+   sint64 key_nb, posting_nb;
+   uint64 key;
+   uint32 game;
+   int r;
+   int pos;
+   int c;
+
+   ASSERT(file_name!=NULL);
+   ASSERT(run!=NULL||run_nb==0);
+
+   Out = fopen(file_name,"w+b");
+   if (Out == NULL) my_fatal("gameindex_build(): can't open file \"%s\" for writing: %s\n",file_name,strerror(errno));
+   setvbuf(Out,NULL,_IOFBF,BufferSize);
+
+   // the positions are written in place, the postings go to a temporary
+   // file appended at the end
+
+   posting = temp_file(file_name);
+   setvbuf(posting,NULL,_IOFBF,BufferSize);
+
+   // there are at most "item_nb" positions, about one bucket per prefix
+
+   bits = 0;
+   while (bits < BitsMax && (item_nb >> bits) > BucketSize) bits++;
+
+   prefix_nb = sint64(1) << bits;
+   prefix = (uint32 *) my_malloc(int((prefix_nb+1)*sizeof(uint32)));
+
+   for (pos = 0; pos < GameIndexHeaderSize; pos++) write_integer(Out,1,0); // written at the end
+   for (next = 0; next <= prefix_nb; next++) write_integer(Out,4,0);
+
+   // init
+
+   Run = run;
+   Heap = (int *) my_malloc((run_nb>0)?run_nb*sizeof(int):1);
+   HeapSize = 0;
+
+   for (r = 0; r < run_nb; r++) {
+      if (fseeko(run[r].file,0,SEEK_SET) != 0) my_fatal("gameindex_build(): fseeko(): %s\n",strerror(errno));
+      if (run_next(&run[r])) Heap[HeapSize++] = r;
+   }
+
+   for (pos = HeapSize / 2 - 1; pos >= 0; pos--) heap_down(pos);
+
+   key_nb = 0;
+   posting_nb = 0;
+   next = 0;
+
+   // position loop
+
+   while (HeapSize > 0) {
+
+      key = Run[Heap[0]].item.key;
+
+      if (key_nb == 0xFFFFFFFF) my_fatal("gameindex_build(): too many positions\n");
+
+      for (; next <= sint64((bits == 0) ? 0 : key >> (64 - bits)); next++) prefix[next] = uint32(key_nb);
+
+      write_integer(Out,8,key);
+      write_integer(Out,8,posting_nb);
+      key_nb++;
+
+      // the games of a position come in order from all the runs, a game
+      // is in a single run
+
+      while (HeapSize > 0 && Run[Heap[0]].item.key == key) {
+
+         r = Heap[0];
+         game = Run[r].item.game + Run[r].base;
+
+         write_integer(posting,4,game);
+         posting_nb++;
+
+         if (!run_next(&Run[r])) Heap[0] = Heap[--HeapSize];
+         heap_down(0);
+      }
+   }
+
+   for (; next <= prefix_nb; next++) prefix[next] = uint32(key_nb);
+
+   write_integer(Out,8,0); // end of the positions
+   write_integer(Out,8,posting_nb);
+
+   // postings
+
+   if (fflush(posting) == EOF || fseeko(posting,0,SEEK_SET) != 0) {
+      my_fatal("gameindex_build(): temporary file: %s\n",strerror(errno));
+   }
+
+   while ((c = getc(posting)) != EOF) {
+      if (putc(c,Out) == EOF) my_fatal("gameindex_build(): putc(): %s\n",strerror(errno));
+   }
+
+   if (ferror(posting)) my_fatal("gameindex_build(): temporary file: %s\n",strerror(errno));
+
+   fclose(posting);
+
+   // header and prefixes
+
+   if (fflush(Out) == EOF || fseeko(Out,0,SEEK_SET) != 0) {
+      my_fatal("gameindex_build(): can't write file \"%s\": %s\n",file_name,strerror(errno));
+   }
+
+   for (pos = 0; pos < MagicSize; pos++) write_integer(Out,1,GameIndexMagic[pos]);
+   write_integer(Out,4,GameIndexVersion);
+   write_integer(Out,4,bits);
+   write_integer(Out,8,key_nb);
+   write_integer(Out,8,posting_nb);
+
+   for (next = 0; next <= prefix_nb; next++) write_integer(Out,4,prefix[next]);
+
+   if (fclose(Out) == EOF) my_fatal("gameindex_build(): fclose(): %s\n",strerror(errno));
+
+   for (r = 0; r < run_nb; r++) fclose(run[r].file);
+
+   my_free(prefix);
+   my_free(Heap);
+
+   printf("%lld positions, %lld postings.\n",key_nb,posting_nb);
+}
+
+// gameindex_disp()
+
+void gameindex_disp(const board_t * board, const char file_name[]) {
+
+   ASSERT(board!=NULL);
+
+   // the index stays open for the next queries
+
+   if (file_name != NULL && file_name[0] != '\0' && (IndexFile == NULL || !my_string_equal(file_name,IndexFile))) {
+      if (IndexFile != NULL) gameindex_close(Index);
+      gameindex_open(Index,file_name);
+      my_string_set(&IndexFile,file_name);
+   }
+
+   if (IndexFile == NULL) {
+      printf("no position index, use \"games <file>\"\n");
+      return;
+   }
+
+   disp_games(Index,board->key,NULL,DispMax);
+}
+
+// gameindex_query()
+
+void gameindex_query(int argc, char * argv[]) {
+
+   int i;
+   const char * index_file;
+   const char * db_file;
+   const char * fen;
+   const char * moves;
+   gameindex_t index[1];
+   gamedb_t db[1];
+   board_t board[1];
+   char string[256];
+   const char * p;
+   int size;
+   int move;
+
+   index_file = NULL;
+   my_string_set(&index_file,"games.idx");
+
+   db_file = NULL;
+   fen = NULL;
+   moves = NULL;
+
+   for (i = 1; i < argc; i++) {
+
+      if (false) {
+
+      } else if (my_string_equal(argv[i],"find-games")) {
+
+         // skip
+
+      } else if (my_string_equal(argv[i],"-index")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("gameindex_query(): missing argument\n");
+
+         my_string_set(&index_file,argv[i]);
+
+      } else if (my_string_equal(argv[i],"-db")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("gameindex_query(): missing argument\n");
+
+         my_string_set(&db_file,argv[i]);
+
+      } else if (my_string_equal(argv[i],"-fen")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("gameindex_query(): missing argument\n");
+
+         my_string_set(&fen,argv[i]);
+
+      } else if (my_string_equal(argv[i],"-moves")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("gameindex_query(): missing argument\n");
+
+         my_string_set(&moves,argv[i]);
+
+      } else {
+
+         my_fatal("gameindex_query(): unknown option \"%s\"\n",argv[i]);
+      }
+   }
+
+   // position
+
+   if (fen == NULL) {
+      board_start(board);
+   } else if (!board_from_fen(board,fen)) {
+      my_fatal("gameindex_query(): bad FEN \"%s\"\n",fen);
+   }
+
+   for (p = moves; p != NULL && *p != '\0';) {
+
+      while (*p == ' ') p++;
+
+      for (size = 0; p[size] != '\0' && p[size] != ' '; size++)
+         ;
+
+      if (size == 0) break;
+      if (size >= 256) my_fatal("gameindex_query(): bad move\n");
+
+      memcpy(string,p,size);
+      string[size] = '\0';
+      p += size;
+
+      move = move_from_san(string,board);
+      if (move == MoveNone || !move_is_legal(move,board)) my_fatal("gameindex_query(): illegal move \"%s\"\n",string);
+
+      move_do(board,move);
+   }
+
+   // query
+
+   gameindex_open(index,index_file);
+   if (db_file != NULL) gamedb_open(db,db_file);
+
+   disp_games(index,board->key,(db_file!=NULL)?db:NULL,-1);
+
+   if (db_file != NULL) gamedb_close(db);
+   gameindex_close(index);
+}
+
+// disp_games()
+
+static void disp_games(const gameindex_t * index, uint64 key, const gamedb_t * db, int max) {
+
+   sint64 first;
+   int size;
+   int i;
+   int game;
+   gamedb_game_t info[1];
+   static const char * const Result[] = { "*", "1-0", "0-1", "1/2-1/2" };
+
+   ASSERT(index!=NULL);
+   ASSERT(max>=-1);
+
+   // at most "max" games are listed, all of them if it is -1
+
+   size = gameindex_find(index,key,&first);
+
+   printf("%d game%s\n",size,(size==1)?"":"s");
+
+   if (max == -1 || max > size) max = size;
+
+   for (i = 0; i < max; i++) {
+
+      game = gameindex_game(index,first+i);
+
+      if (db != NULL) {
+
+         if (game >= db->game_nb) my_fatal("disp_games(): game %d is not in the database\n",game+1);
+
+         gamedb_read(db,game,info);
+         printf(" %d: %s - %s %s\n",game+1,info->white,info->black,Result[info->result&3]);
+
+      } else {
+
+         printf(" %d",game+1);
+         if (i % 10 == 9 || i == max-1) printf("\n");
+      }
+   }
+
+   if (max < size) printf(" ...\n");
+}
+
+// run_next()
+
+static bool run_next(gameindex_run_t * run) {
+
+   ASSERT(run!=NULL);
+
+   return fread(&run->item,sizeof(gameindex_item_t),1,run->file) == 1;
+}
+
+// heap_down()
+
+static void heap_down(int pos) {
+
+   int child;
+   int tmp;
+
+   // sift the run at "pos" down the heap
+
+   while ((child = pos * 2 + 1) < HeapSize) {
+
+      if (child + 1 < HeapSize && item_less(&Run[Heap[child+1]],&Run[Heap[child]])) child++;
+
+      if (!item_less(&Run[Heap[child]],&Run[Heap[pos]])) break;
+
+      tmp = Heap[pos];
+      Heap[pos] = Heap[child];
+      Heap[child] = tmp;
+
+      pos = child;
+   }
+}
+
+// item_less()
+
+static bool item_less(const gameindex_run_t * run1, const gameindex_run_t * run2) {
+
+   ASSERT(run1!=NULL);
+   ASSERT(run2!=NULL);
+
+   if (run1->item.key != run2->item.key) return run1->item.key < run2->item.key;
+
+   return run1->item.game + run1->base < run2->item.game + run2->base;
+}
+
+// item_compare()
+
+static int item_compare(const void * p1, const void * p2) {
+
+   const gameindex_item_t * item1, * item2;
+
+   ASSERT(p1!=NULL);
+   ASSERT(p2!=NULL);
+
+   item1 = (const gameindex_item_t *) p1;
+   item2 = (const gameindex_item_t *) p2;
+
+   if (item1->key < item2->key) return -1;
+   if (item1->key > item2->key) return +1;
+
+   if (item1->game < item2->game) return -1;
+   if (item1->game > item2->game) return +1;
+
+   return 0;
+}
+
+// temp_file()
+
+static FILE * temp_file(const char file_name[]) {
+
+   char temp_name[4096];
+   int fd;
+   FILE * file;
+
+   ASSERT(file_name!=NULL);
+
+   // temporary file next to the index, removed as soon as it is open
+
+   snprintf(temp_name,sizeof(temp_name),"%s.run.XXXXXX",file_name);
+
+   fd = mkstemp(temp_name);
+   if (fd == -1) my_fatal("temp_file(): can't create file \"%s\": %s\n",temp_name,strerror(errno));
+   unlink(temp_name);
+
+   file = fdopen(fd,"w+b");
+   if (file == NULL) my_fatal("temp_file(): fdopen(): %s\n",strerror(errno));
+
+   return file;
+}
+
+// read_integer()
+
+static uint64 read_integer(const uint8 * p, int size) {
+
+   uint64 n;
+   int i;
+
+   ASSERT(p!=NULL);
+   ASSERT(size>0&&size<=8);
+
+   n = 0;
+   for (i = 0; i < size; i++) n = (n << 8) | p[i];
+
+   return n;
+}
+
+// write_integer()
+
+static void write_integer(FILE * file, int size, uint64 n) {
+
+   int i;
+
+   ASSERT(file!=NULL);
+   ASSERT(size>0&&size<=8);
+   ASSERT(size==8||n>>(size*8)==0);
+
+   for (i = size-1; i >= 0; i--) {
+      if (putc((n >> (i*8)) & 0xFF,file) == EOF) {
+         my_fatal("write_integer(): putc(): %s\n",strerror(errno));
+      }
+   }
+}
+
+}  // namespace adapter
+
+// end of gameindex.cpp
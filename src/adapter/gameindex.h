@@ -0,0 +1,84 @@
+/* gameindex.h
+
+   GNU Chess protocol adapter
+
+   Copyright (C) 2001-2011 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// gameindex.h
+
+#ifndef GAMEINDEX_H
+#define GAMEINDEX_H
+
+// includes
+
+#include <cstdio>
+
+#include "board.h"
+#include "util.h"
+
+namespace adapter {
+
+// constants
+
+const char GameIndexMagic[] = "GCHESSIX"; // 8 characters
+const int GameIndexVersion = 1;
+const int GameIndexHeaderSize = 32;
+
+// types
+
+struct gameindex_t {
+   const uint8 * data; // the whole file, mapped in memory
+   sint64 size;
+   int bits; // key prefix size
+   sint64 key_nb;
+   sint64 posting_nb;
+   const uint8 * prefix; // first key of each prefix
+   const uint8 * key; // key and first posting of each position
+   const uint8 * posting; // game numbers
+};
+
+struct gameindex_item_t { // one game reaching one position
+   uint64 key;
+   uint32 game;
+};
+
+struct gameindex_run_t { // sorted items spilled to a temporary file
+   FILE * file;
+   int base; // added to the game numbers of the run
+   gameindex_item_t item; // next item
+};
+
+// functions
+
+extern void   gameindex_open  (gameindex_t * index, const char file_name[]);
+extern void   gameindex_close (gameindex_t * index);
+
+extern int    gameindex_find  (const gameindex_t * index, uint64 key, sint64 * first);
+extern int    gameindex_game  (const gameindex_t * index, sint64 pos);
+
+extern FILE * gameindex_run   (const char file_name[], gameindex_item_t item[], int size);
+extern void   gameindex_build (const char file_name[], gameindex_run_t run[], int run_nb, sint64 item_nb);
+
+extern void   gameindex_disp  (const board_t * board, const char file_name[]);
+extern void   gameindex_query (int argc, char * argv[]);
+
+}  // namespace adapter
+
+#endif // !defined GAMEINDEX_H
+
+// end of gameindex.h
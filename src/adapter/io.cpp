@@ -29,9 +29,6 @@
 #include <cstdlib>
 #include <cstring>
 
-#include <sys/types.h>
-#include <unistd.h>
-
 #include "io.h"
 #include "util.h"
 
@@ -49,8 +46,8 @@ static const char CR = '\r';
 
 // prototypes
 
-static int  my_read  (int fd, char string[], int size);
-static void my_write (int fd, const char string[], int size);
+static int  my_read  (queue_t * queue, char string[], int size);
+static void my_write (queue_t * queue, const char string[], int size);
 
 // functions
 
@@ -65,6 +62,7 @@ bool io_is_ok(const io_t * io) {
    if (io->in_eof != true && io->in_eof != false) return false;
 
    if (io->in_size < 0 || io->in_size > BufferSize) return false;
+   if (io->in_line_nb < 0 || io->in_line_nb > io->in_size) return false;
    if (io->out_size < 0 || io->out_size > BufferSize) return false;
 
    return true;
@@ -78,7 +76,9 @@ void io_init(io_t * io) {
 
    io->in_eof = false;
 
+   io->in_start = 0;
    io->in_size = 0;
+   io->in_line_nb = 0;
    io->out_size = 0;
 
    ASSERT(io_is_ok(io));
@@ -90,15 +90,13 @@ void io_close(io_t * io) {
 
    ASSERT(io_is_ok(io));
 
-   ASSERT(io->out_fd>=0);
+   ASSERT(io->out_queue!=NULL);
 
-   my_log("> %s EOF\n",io->name);
+   if (my_log_is_open()) my_log("> %s EOF\n",io->name);
 
-   if (close(io->out_fd) == -1) {
-      my_fatal("io_close(): close(): %s\n",strerror(errno));
-   }
+   queue_close(io->out_queue);
 
-   io->out_fd = -1;
+   io->out_queue = NULL;
 }
 
 // io_get_update()
@@ -107,22 +105,25 @@ void io_get_update(io_t * io) {
 
    int pos, size;
    int n;
+   const char * p, * end;
 
    ASSERT(io_is_ok(io));
 
-   ASSERT(io->in_fd>=0);
+   ASSERT(io->in_queue!=NULL);
    ASSERT(!io->in_eof);
 
-   // init
+   // init, the free space is read up to the end of the ring at most
 
-   pos = io->in_size;
+   pos = (io->in_start + io->in_size) & (BufferSize - 1);
 
-   size = BufferSize - pos;
+   size = BufferSize - io->in_size;
    if (size <= 0) my_fatal("io_get_update(): buffer overflow\n");
 
+   if (size > BufferSize - pos) size = BufferSize - pos;
+
    // read as many data as possible
 
-   n = my_read(io->in_fd,&io->in_buffer[pos],size);
+   n = my_read(io->in_queue,&io->in_buffer[pos],size);
    if (UseDebug) my_log("POLYGLOT read %d byte%s from %s\n",n,(n>1)?"s":"",io->name);
 
    if (n > 0) { // at least one character was read
@@ -134,6 +135,14 @@ void io_get_update(io_t * io) {
       io->in_size += n;
       ASSERT(io->in_size>=0&&io->in_size<=BufferSize);
 
+      // count the new lines, so that io_line_ready() need not search
+
+      end = &io->in_buffer[pos+n];
+
+      for (p = &io->in_buffer[pos]; (p = (const char *) memchr(p,LF,end-p)) != NULL; p++) {
+         io->in_line_nb++;
+      }
+
    } else { // EOF
 
       ASSERT(n==0);
@@ -150,66 +159,92 @@ bool io_line_ready(const io_t * io) {
 
    if (io->in_eof) return true;
 
-   if (memchr(io->in_buffer,LF,io->in_size) != NULL) return true; // buffer contains LF
-
-   return false;
+   return io->in_line_nb > 0; // buffer contains LF
 }
 
 // io_get_line()
 
 bool io_get_line(io_t * io, char string[], int size) {
 
-   int src, dst;
-   int c;
+   const char * line;
+   int len;
 
    ASSERT(io_is_ok(io));
    ASSERT(string!=NULL);
    ASSERT(size>=256);
 
-   src = 0;
-   dst = 0;
+   if (!io_get_view(io,&line)) return false;
 
-   while (true) {
+   len = strlen(line);
+   if (len >= size) my_fatal("io_get_line(): buffer overflow\n");
 
-      // test for end of buffer
+   memcpy(string,line,len+1);
 
-      if (src >= io->in_size) {
-         if (io->in_eof) {
-            my_log("< %s EOF\n",io->name);
-            return false;
-         } else {
-            my_fatal("io_get_line(): no EOL in buffer\n");
-         }
-      }
+   return true;
+}
+
+// io_get_view()
 
-      // test for end of string
+bool io_get_view(io_t * io, const char ** string) {
 
-      if (dst >= size) my_fatal("io_get_line(): buffer overflow\n");
+   int pos, len, first;
+   char * line;
+   const char * lf;
 
-      // copy the next character
+   ASSERT(io_is_ok(io));
+   ASSERT(string!=NULL);
 
-      c = io->in_buffer[src++];
+   // the line stays in the ring, unless it wraps around its end, and is
+   // valid until the next io_get_update()
 
-      if (c == LF) { // LF => line complete
-         string[dst] = '\0';
-         break;
-      } else if (c != CR) { // skip CRs
-         string[dst++] = c;
+   if (io->in_line_nb == 0) {
+      if (io->in_eof) {
+         if (my_log_is_open()) my_log("< %s EOF\n",io->name);
+         return false;
+      } else {
+         my_fatal("io_get_view(): no EOL in buffer\n");
       }
    }
 
-   // shift the buffer
+   pos = io->in_start & (BufferSize - 1);
+   first = BufferSize - pos; // bytes before the end of the ring
+   if (first > io->in_size) first = io->in_size;
+
+   lf = (const char *) memchr(&io->in_buffer[pos],LF,first);
+
+   if (lf != NULL) {
+
+      line = &io->in_buffer[pos];
+      len = int(lf - line);
+
+   } else { // copy both parts
+
+      lf = (const char *) memchr(&io->in_buffer[0],LF,io->in_size-first);
+      ASSERT(lf!=NULL);
+
+      line = io->in_line;
+      len = first + int(lf - io->in_buffer);
+
+      memcpy(&line[0],&io->in_buffer[pos],first);
+      memcpy(&line[first],&io->in_buffer[0],len-first);
+   }
+
+   // consume the line and its LF, which is replaced by the terminator
 
-   ASSERT(src>0);
+   io->in_start += len + 1;
+   io->in_size -= len + 1;
+   io->in_line_nb--;
 
-   io->in_size -= src;
    ASSERT(io->in_size>=0);
 
-   if (io->in_size > 0) memmove(&io->in_buffer[0],&io->in_buffer[src],io->in_size);
+   if (len > 0 && line[len-1] == CR) len--; // skip CR
+   line[len] = '\0';
 
-   // return
+   *string = line;
 
-   my_log("< %s %s\n",io->name,string);
+   // log
+
+   if (my_log_is_open()) my_log("< %s %s\n",io->name,line);
 
    return true;
 }
@@ -225,7 +260,7 @@ void io_send(io_t * io, const char format[], ...) {
    ASSERT(io_is_ok(io));
    ASSERT(format!=NULL);
 
-   ASSERT(io->out_fd>=0);
+   ASSERT(io->out_queue!=NULL);
 
    // format
 
@@ -245,8 +280,10 @@ void io_send(io_t * io, const char format[], ...) {
 
    // log
 
-   io->out_buffer[io->out_size] = '\0';
-   my_log("> %s %s\n",io->name,io->out_buffer);
+   if (my_log_is_open()) {
+      io->out_buffer[io->out_size] = '\0';
+      my_log("> %s %s\n",io->name,io->out_buffer);
+   }
 
    // append EOL to buffer
 
@@ -258,7 +295,7 @@ void io_send(io_t * io, const char format[], ...) {
    // flush buffer
 
    if (UseDebug) my_log("POLYGLOT writing %d byte%s to %s\n",io->out_size,(io->out_size>1)?"s":"",io->name);
-   my_write(io->out_fd,io->out_buffer,io->out_size);
+   my_write(io->out_queue,io->out_buffer,io->out_size);
 
    io->out_size = 0;
 }
@@ -274,7 +311,7 @@ void io_send_queue(io_t * io, const char format[], ...) {
    ASSERT(io_is_ok(io));
    ASSERT(format!=NULL);
 
-   ASSERT(io->out_fd>=0);
+   ASSERT(io->out_queue!=NULL);
 
    // format
 
@@ -295,19 +332,15 @@ void io_send_queue(io_t * io, const char format[], ...) {
 
 // my_read()
 
-static int my_read(int fd, char string[], int size) {
+static int my_read(queue_t * queue, char string[], int size) {
 
    int n;
 
-   ASSERT(fd>=0);
+   ASSERT(queue!=NULL);
    ASSERT(string!=NULL);
    ASSERT(size>0);
 
-   do {
-      n = read(fd,string,size);
-   } while (n == -1 && errno == EINTR);
-
-   if (n == -1) my_fatal("my_read(): read(): %s\n",strerror(errno));
+   n = queue_read(queue,string,size);
 
    ASSERT(n>=0);
 
@@ -316,39 +349,13 @@ static int my_read(int fd, char string[], int size) {
 
 // my_write()
 
-static void my_write(int fd, const char string[], int size) {
+static void my_write(queue_t * queue, const char string[], int size) {
 
-   int n;
-
-   ASSERT(fd>=0);
+   ASSERT(queue!=NULL);
    ASSERT(string!=NULL);
    ASSERT(size>0);
 
-   do {
-
-      n = write(fd,string,size);
-
-      // if (n == -1 && errno != EINTR && errno != EPIPE) my_fatal("my_write(): write(): %s\n",strerror(errno));
-
-      if (n == -1) {
-         if (false) {
-         } else if (errno == EINTR) {
-            n = 0; // nothing has been written
-         } else if (errno == EPIPE) {
-            n = size; // pretend everything has been written
-         } else {
-            my_fatal("my_write(): write(): %s\n",strerror(errno));
-         }
-      }
-
-      ASSERT(n>=0);
-
-      string += n;
-      size -= n;
-
-   } while (size > 0);
-
-   ASSERT(size==0);
+   queue_write(queue,string,size);
 }
 
 }  // namespace adapter
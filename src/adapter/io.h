@@ -26,29 +26,33 @@
 
 // includes
 
+#include "queue.h"
 #include "util.h"
 
 namespace adapter {
 
 // constants
 
-const int BufferSize = 16384;
+const int BufferSize = 16384; // must be a power of two
 
 // types
 
 struct io_t {
 
-   int in_fd;
-   int out_fd;
+   queue_t * in_queue;
+   queue_t * out_queue;
 
    const char * name;
 
    bool in_eof;
 
+   uint32 in_start; // read position in the ring, not wrapped
    sint32 in_size;
+   sint32 in_line_nb; // complete lines in the ring
    sint32 out_size;
 
-   char in_buffer[BufferSize];
+   char in_buffer[BufferSize]; // ring
+   char in_line[BufferSize]; // lines that wrap around the end of the ring
    char out_buffer[BufferSize];
 };
 
@@ -63,6 +67,7 @@ extern void io_get_update (io_t * io);
 
 extern bool io_line_ready (const io_t * io);
 extern bool io_get_line   (io_t * io, char string[], int size);
+extern bool io_get_view   (io_t * io, const char ** string);
 
 extern void io_send       (io_t * io, const char format[], ...);
 extern void io_send_queue (io_t * io, const char format[], ...);
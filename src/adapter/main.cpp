@@ -36,6 +36,8 @@
 #include "book.h"
 #include "book_make.h"
 #include "book_merge.h"
+#include "gamedb.h"
+#include "gameindex.h"
 #include "engine.h"
 #include "epd.h"
 #include "fen.h"
@@ -118,6 +120,16 @@ int main_adapter(int argc, char * argv[]) {
       return EXIT_SUCCESS;
    }
 
+   if (argc >= 2 && my_string_equal(argv[1],"make-gamedb")) {
+      gamedb_make(argc,argv);
+      return EXIT_SUCCESS;
+   }
+
+   if (argc >= 2 && my_string_equal(argv[1],"find-games")) {
+      gameindex_query(argc,argv);
+      return EXIT_SUCCESS;
+   }
+
    // read options
 
    if (argc == 2) option_set("OptionFile",argv[1]); // HACK for compatibility
@@ -127,8 +139,7 @@ int main_adapter(int argc, char * argv[]) {
    // EPD test
 
    if (argc >= 2 && my_string_equal(argv[1],"epd-test")) {
-      epd_test(argc,argv);
-      return EXIT_SUCCESS;
+      return epd_test(argc,argv) ? EXIT_SUCCESS : EXIT_FAILURE;
    }
 
    // opening book
@@ -168,7 +179,7 @@ static void parse_option() {
    file_name = option_get_string("OptionFile");
 
    file = fopen(file_name,"r");
-   if (file == NULL) my_fatal( "Can't open file \"%s\": %s - using defaults\n",file_name,strerror(errno));
+   if (file == NULL) fprintf(stderr,"Can't open file \"%s\": %s - using defaults\n",file_name,strerror(errno)); // not fatal
 
    // PolyGlot options (assumed first)
 
@@ -79,6 +79,7 @@ static option_t Option[] = {
    { "KibitzDelay",   NULL, }, // seconds
 
    { "ShowPonder",    NULL, }, // true/false
+   { "PVDelay",       NULL, }, // milliseconds
 
    // work-arounds
 
@@ -149,6 +150,7 @@ void option_init() {
    option_set("KibitzDelay","5");
 
    option_set("ShowPonder","true");
+   option_set("PVDelay","0");
 
    // work-arounds
 
@@ -28,6 +28,11 @@
 #include <cstdio>
 #include <cstring>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "pgn.h"
 #include "util.h"
 
@@ -37,12 +42,9 @@ namespace adapter {
 
 static const bool DispMove = false;
 static const bool DispToken = false;
-static const bool DispChar = false;
 
 static const int TAB_SIZE = 8;
 
-static const int CHAR_EOF = 256;
-
 // types
 
 enum token_t {
@@ -57,6 +59,8 @@ enum token_t {
 
 // prototypes
 
+static void pgn_load         (pgn_t * pgn, int fd, const char file_name[]);
+
 static void pgn_token_read   (pgn_t * pgn);
 static void pgn_token_unread (pgn_t * pgn);
 
@@ -67,8 +71,7 @@ static bool is_symbol_next   (int c);
 
 static void pgn_skip_blanks  (pgn_t * pgn);
 
-static void pgn_char_read    (pgn_t * pgn);
-static void pgn_char_unread  (pgn_t * pgn);
+static void pgn_fatal        (const pgn_t * pgn, sint64 pos, const char message[]);
 
 // functions
 
@@ -76,31 +79,59 @@ static void pgn_char_unread  (pgn_t * pgn);
 
 void pgn_open(pgn_t * pgn, const char file_name[]) {
 
+   int fd;
+   struct stat st;
+   void * map;
+
    ASSERT(pgn!=NULL);
    ASSERT(file_name!=NULL);
 
-   pgn->file = fopen(file_name,"r");
-   if (pgn->file == NULL) my_fatal("pgn_open(): can't open file \"%s\": %s\n",file_name,strerror(errno));
+   fd = open(file_name,O_RDONLY);
+   if (fd == -1) my_fatal("pgn_open(): can't open file \"%s\": %s\n",file_name,strerror(errno));
+
+   if (fstat(fd,&st) == -1) my_fatal("pgn_open(): fstat(): %s\n",strerror(errno));
+
+   // map the file, the whole input is then scanned in place
+
+   pgn->data = NULL;
+   pgn->size = 0;
+   pgn->mapped = false;
+   pgn->owner = true;
+
+   if (S_ISREG(st.st_mode) && st.st_size > 0) {
+
+      map = mmap(NULL,size_t(st.st_size),PROT_READ,MAP_PRIVATE,fd,0);
+
+      if (map != MAP_FAILED) {
+         madvise(map,size_t(st.st_size),MADV_SEQUENTIAL);
+         pgn->data = (const char *) map;
+         pgn->size = sint64(st.st_size);
+         pgn->mapped = true;
+      }
+   }
+
+   if (!pgn->mapped) pgn_load(pgn,fd,file_name); // pipe, or mmap() failed
 
-   pgn->char_hack = CHAR_EOF; // DEBUG
-   pgn->char_line = 1;
-   pgn->char_column = 0;
-   pgn->char_unread = false;
-   pgn->char_first = true;
+   close(fd);
+
+   pgn->char_pos = 0;
+   pgn->char_end = pgn->size;
 
    pgn->token_type = TOKEN_ERROR; // DEBUG
    strcpy(pgn->token_string,"?"); // DEBUG
    pgn->token_length = -1; // DEBUG
-   pgn->token_line = -1; // DEBUG
-   pgn->token_column = -1; // DEBUG
+   pgn->token_pos = -1; // DEBUG
    pgn->token_unread = false;
    pgn->token_first = true;
 
    strcpy(pgn->result,"?"); // DEBUG
    strcpy(pgn->fen,"?"); // DEBUG
+   strcpy(pgn->white,"?"); // DEBUG
+   strcpy(pgn->black,"?"); // DEBUG
+   strcpy(pgn->white_elo,"?"); // DEBUG
+   strcpy(pgn->black_elo,"?"); // DEBUG
 
-   pgn->move_line = -1; // DEBUG
-   pgn->move_column = -1; // DEBUG
+   pgn->move_pos = -1; // DEBUG
 }
 
 // pgn_close()
@@ -109,7 +140,96 @@ void pgn_close(pgn_t * pgn) {
 
    ASSERT(pgn!=NULL);
 
-   fclose(pgn->file);
+   if (!pgn->owner) {
+      // range of a shared file
+   } else if (pgn->mapped) {
+      munmap((void *) pgn->data,size_t(pgn->size));
+   } else if (pgn->data != NULL) {
+      my_free((void *) pgn->data);
+   }
+
+   pgn->data = NULL;
+   pgn->size = 0;
+}
+
+// pgn_open_range()
+
+void pgn_open_range(pgn_t * pgn, const pgn_t * file, sint64 start, sint64 end) {
+
+   ASSERT(pgn!=NULL);
+   ASSERT(file!=NULL);
+   ASSERT(start>=0&&start<=end);
+
+   // reads part of a file that is already open, "file" must not be closed first
+
+   ASSERT(file->owner);
+
+   *pgn = *file;
+   pgn->owner = false;
+
+   if (end > pgn->size) end = pgn->size;
+   if (start > end) start = end;
+
+   pgn->char_pos = start;
+   pgn->char_end = end;
+
+   pgn->token_type = TOKEN_ERROR; // DEBUG
+   pgn->token_unread = false;
+   pgn->token_first = true;
+}
+
+// pgn_discard()
+
+void pgn_discard(const pgn_t * pgn, sint64 end) {
+
+   long page;
+
+   ASSERT(pgn!=NULL);
+   ASSERT(end>=0);
+
+   // the part of the file before "end" will not be read again soon,
+   // release its pages (they are reloaded from the file if needed)
+
+   if (!pgn->mapped) return;
+
+   if (end > pgn->size) end = pgn->size;
+
+   page = sysconf(_SC_PAGESIZE);
+   end -= end % page;
+
+   if (end > 0) madvise((void *) pgn->data,size_t(end),MADV_DONTNEED);
+}
+
+// pgn_line_column()
+
+void pgn_line_column(const pgn_t * pgn, sint64 pos, int * line, int * column) {
+
+   sint64 i;
+   int c;
+
+   ASSERT(pgn!=NULL);
+   ASSERT(line!=NULL);
+   ASSERT(column!=NULL);
+
+   // only used for messages, so it is fine to count from the start
+
+   *line = 1;
+   *column = 0;
+
+   for (i = 0; i < pos && i < pgn->size; i++) {
+
+      c = pgn->data[i];
+
+      if (false) {
+      } else if (c == '\n') {
+         (*line)++;
+         *column = 0;
+      } else if (c == '\t') {
+         *column += TAB_SIZE - (*column % TAB_SIZE);
+      } else {
+         (*column)++;
+      }
+   }
 }
 
 // pgn_next_game()
@@ -118,6 +238,7 @@ bool pgn_next_game(pgn_t * pgn) {
 
    char name[PGN_STRING_SIZE];
    char value[PGN_STRING_SIZE];
+   int line, column;
 
    ASSERT(pgn!=NULL);
 
@@ -125,6 +246,10 @@ bool pgn_next_game(pgn_t * pgn) {
 
    strcpy(pgn->result,"*");
    strcpy(pgn->fen,"");
+   strcpy(pgn->white,"");
+   strcpy(pgn->black,"");
+   strcpy(pgn->white_elo,"");
+   strcpy(pgn->black_elo,"");
 
    // loop
 
@@ -138,30 +263,30 @@ bool pgn_next_game(pgn_t * pgn) {
 
       pgn_token_read(pgn);
       if (pgn->token_type != TOKEN_SYMBOL) {
-         my_fatal("pgn_next_game(): malformed tag at line %d, column %d\n",pgn->token_line,pgn->token_column);
+         pgn_fatal(pgn,pgn->token_pos,"pgn_next_game(): malformed tag");
       }
       strcpy(name,pgn->token_string);
 
       pgn_token_read(pgn);
       if (pgn->token_type != TOKEN_STRING) {
-         my_fatal("pgn_next_game(): malformed tag at line %d, column %d\n",pgn->token_line,pgn->token_column);
+         pgn_fatal(pgn,pgn->token_pos,"pgn_next_game(): malformed tag");
       }
       strcpy(value,pgn->token_string);
 
       pgn_token_read(pgn);
       if (pgn->token_type != ']') {
          if ( (my_string_equal(name,"Result")) || (my_string_equal(name,"FEN")) ) {
-            my_fatal("pgn_next_game(): malformed tag at line %d, column %d\n",pgn->token_line,pgn->token_column);
+            pgn_fatal(pgn,pgn->token_pos,"pgn_next_game(): malformed tag");
          } else {
             // Ignore rest of line up to ']'
-            my_log("pgn_next_game(): malformed tag at line %d, column %d\n",pgn->token_line,pgn->token_column);
-            while (pgn->char_hack!= ']') {
-               pgn_char_read(pgn);
+            pgn_line_column(pgn,pgn->token_pos,&line,&column);
+            my_log("pgn_next_game(): malformed tag at line %d, column %d\n",line,column);
+            while (pgn->char_pos < pgn->char_end && pgn->data[pgn->char_pos] != ']') {
+               pgn->char_pos++;
             }
-            pgn_char_unread(pgn);
             pgn_token_read(pgn);
             if (pgn->token_type != ']') {
-               my_fatal("pgn_next_game(): malformed tag at line %d, column %d\n",pgn->token_line,pgn->token_column);
+               pgn_fatal(pgn,pgn->token_pos,"pgn_next_game(): malformed tag");
             }
          }
       }
@@ -173,6 +298,14 @@ bool pgn_next_game(pgn_t * pgn) {
          strcpy(pgn->result,value);
       } else if (my_string_equal(name,"FEN")) {
          strcpy(pgn->fen,value);
+      } else if (my_string_equal(name,"White")) {
+         strcpy(pgn->white,value);
+      } else if (my_string_equal(name,"Black")) {
+         strcpy(pgn->black,value);
+      } else if (my_string_equal(name,"WhiteElo")) {
+         strcpy(pgn->white_elo,value);
+      } else if (my_string_equal(name,"BlackElo")) {
+         strcpy(pgn->black_elo,value);
       }
    }
 
@@ -195,8 +328,7 @@ bool pgn_next_move(pgn_t * pgn, char string[], int size) {
 
    // init
 
-   pgn->move_line = -1; // DEBUG
-   pgn->move_column = -1; // DEBUG
+   pgn->move_pos = -1; // DEBUG
 
    // loop
 
@@ -219,7 +351,7 @@ bool pgn_next_move(pgn_t * pgn, char string[], int size) {
          // close RAV
 
          if (depth == 0) {
-            my_fatal("pgn_next_move(): malformed variation at line %d, column %d\n",pgn->token_line,pgn->token_column);
+            pgn_fatal(pgn,pgn->token_pos,"pgn_next_move(): malformed variation");
          }
 
          depth--;
@@ -230,7 +362,7 @@ bool pgn_next_move(pgn_t * pgn, char string[], int size) {
          // game finished
 
          if (depth > 0) {
-            my_fatal("pgn_next_move(): malformed variation at line %d, column %d\n",pgn->token_line,pgn->token_column);
+            pgn_fatal(pgn,pgn->token_pos,"pgn_next_move(): malformed variation");
          }
 
          return false;
@@ -246,7 +378,7 @@ bool pgn_next_move(pgn_t * pgn, char string[], int size) {
          // move must be a symbol
 
          if (pgn->token_type != TOKEN_SYMBOL) {
-            my_fatal("pgn_next_move(): malformed move at line %d, column %d\n",pgn->token_line,pgn->token_column);
+            pgn_fatal(pgn,pgn->token_pos,"pgn_next_move(): malformed move");
          }
 
          // store move for later use
@@ -254,12 +386,11 @@ bool pgn_next_move(pgn_t * pgn, char string[], int size) {
          if (depth == 0) {
 
             if (pgn->token_length >= size) {
-               my_fatal("pgn_next_move(): move too long at line %d, column %d\n",pgn->token_line,pgn->token_column);
+               pgn_fatal(pgn,pgn->token_pos,"pgn_next_move(): move too long");
             }
 
             strcpy(string,pgn->token_string);
-            pgn->move_line = pgn->token_line;
-            pgn->move_column = pgn->token_column;
+            pgn->move_pos = pgn->token_pos;
          }
 
          // skip optional NAGs
@@ -281,6 +412,49 @@ bool pgn_next_move(pgn_t * pgn, char string[], int size) {
    return false;
 }
 
+// pgn_load()
+
+static void pgn_load(pgn_t * pgn, int fd, const char file_name[]) {
+
+   char * data;
+   int alloc;
+   int size;
+   ssize_t n;
+
+   ASSERT(pgn!=NULL);
+   ASSERT(fd>=0);
+   ASSERT(file_name!=NULL);
+
+   // read the whole input in memory
+
+   alloc = 65536;
+   size = 0;
+   data = (char *) my_malloc(alloc);
+
+   while (true) {
+
+      if (size == alloc) {
+         if (alloc >= (1 << 30)) my_fatal("pgn_open(): file \"%s\" is too large\n",file_name);
+         alloc *= 2;
+         data = (char *) my_realloc(data,alloc);
+      }
+
+      n = read(fd,&data[size],alloc-size);
+
+      if (n == 0) break;
+
+      if (n == -1) {
+         if (errno == EINTR) continue;
+         my_fatal("pgn_open(): read(): %s\n",strerror(errno));
+      }
+
+      size += int(n);
+   }
+
+   pgn->data = data;
+   pgn->size = size;
+}
+
 // pgn_token_read()
 
 static void pgn_token_read(pgn_t * pgn) {
@@ -306,9 +480,9 @@ static void pgn_token_read(pgn_t * pgn) {
    // read a new token
 
    pgn_read_token(pgn);
-   if (pgn->token_type == TOKEN_ERROR) my_fatal("pgn_token_read(): lexical error at line %d, column %d\n",pgn->char_line,pgn->char_column);
+   if (pgn->token_type == TOKEN_ERROR) pgn_fatal(pgn,pgn->char_pos,"pgn_token_read(): lexical error");
 
-   if (DispToken) printf("< L%d C%d \"%s\" (%03X)\n",pgn->token_line,pgn->token_column,pgn->token_string,pgn->token_type);
+   if (DispToken) printf("< P%lld \"%s\" (%03X)\n",pgn->token_pos,pgn->token_string,pgn->token_type);
 }
 
 // pgn_token_unread()
@@ -327,6 +501,10 @@ static void pgn_token_unread(pgn_t * pgn) {
 
 static void pgn_read_token(pgn_t * pgn) {
 
+   const char * data;
+   sint64 pos, end;
+   int c;
+
    ASSERT(pgn!=NULL);
 
    // skip white-space characters
@@ -335,89 +513,62 @@ static void pgn_read_token(pgn_t * pgn) {
 
    // init
 
+   data = pgn->data;
+   pos = pgn->char_pos;
+   end = pgn->char_end;
+
    pgn->token_type = TOKEN_ERROR;
    strcpy(pgn->token_string,"");
    pgn->token_length = 0;
-   pgn->token_line = pgn->char_line;
-   pgn->token_column = pgn->char_column;
+   pgn->token_pos = pos;
 
    // determine token type
 
+   c = (pos < end) ? (unsigned char) data[pos] : TOKEN_EOF;
+
    if (false) {
 
-   } else if (pgn->char_hack == CHAR_EOF) {
+   } else if (c == TOKEN_EOF) {
 
       pgn->token_type = TOKEN_EOF;
 
-   } else if (strchr(".[]()<>",pgn->char_hack) != NULL) {
+   } else if (c == '.' || c == '[' || c == ']' || c == '(' || c == ')' || c == '<' || c == '>') {
 
       // single-character token
 
-      pgn->token_type = pgn->char_hack;
-      sprintf(pgn->token_string,"%c",pgn->char_hack);
+      pgn->token_type = c;
+      pgn->token_string[0] = c;
+      pgn->token_string[1] = '\0';
       pgn->token_length = 1;
+      pos++;
 
-   } else if (pgn->char_hack == '*') {
+   } else if (c == '*') {
 
       pgn->token_type = TOKEN_RESULT;
-      sprintf(pgn->token_string,"%c",pgn->char_hack);
+      strcpy(pgn->token_string,"*");
       pgn->token_length = 1;
+      pos++;
 
-   } else if (pgn->char_hack == '!') {
-
-      pgn_char_read(pgn);
-
-      if (false) {
-
-      } else if (pgn->char_hack == '!') { // "!!"
-
-         pgn->token_type = TOKEN_NAG;
-         strcpy(pgn->token_string,"3");
-         pgn->token_length = 1;
-
-      } else if (pgn->char_hack == '?') { // "!?"
-
-         pgn->token_type = TOKEN_NAG;
-         strcpy(pgn->token_string,"5");
-         pgn->token_length = 1;
-
-      } else { // "!"
-
-         pgn_char_unread(pgn);
+   } else if (c == '!' || c == '?') {
 
-         pgn->token_type = TOKEN_NAG;
-         strcpy(pgn->token_string,"1");
-         pgn->token_length = 1;
-      }
-
-   } else if (pgn->char_hack == '?') {
-
-      pgn_char_read(pgn);
-
-      if (false) {
+      // "!", "?", "!!", "??", "!?" or "?!"
 
-      } else if (pgn->char_hack == '?') { // "??"
+      pos++;
 
-         pgn->token_type = TOKEN_NAG;
-         strcpy(pgn->token_string,"4");
-         pgn->token_length = 1;
-
-      } else if (pgn->char_hack == '!') { // "?!"
-
-         pgn->token_type = TOKEN_NAG;
-         strcpy(pgn->token_string,"6");
-         pgn->token_length = 1;
-
-      } else { // "?"
-
-         pgn_char_unread(pgn);
+      pgn->token_type = TOKEN_NAG;
+      pgn->token_length = 1;
 
-         pgn->token_type = TOKEN_NAG;
-         strcpy(pgn->token_string,"2");
-         pgn->token_length = 1;
+      if (pos < end && data[pos] == '!') {
+         strcpy(pgn->token_string,(c=='!')?"3":"6");
+         pos++;
+      } else if (pos < end && data[pos] == '?') {
+         strcpy(pgn->token_string,(c=='!')?"5":"4");
+         pos++;
+      } else {
+         strcpy(pgn->token_string,(c=='!')?"1":"2");
       }
 
-   } else if (is_symbol_start(pgn->char_hack)) {
+   } else if (is_symbol_start(c)) {
 
       // symbol, integer, or result
 
@@ -427,29 +578,29 @@ static void pgn_read_token(pgn_t * pgn) {
       do {
 
          if (pgn->token_length >= PGN_STRING_SIZE-1) {
-            my_fatal("pgn_read_token(): symbol too long at line %d, column %d\n",pgn->char_line,pgn->char_column);
+            pgn_fatal(pgn,pos,"pgn_read_token(): symbol too long");
          }
 
-         if (!isdigit(pgn->char_hack)) pgn->token_type = TOKEN_SYMBOL;
-
-         pgn->token_string[pgn->token_length++] = pgn->char_hack;
+         if (!isdigit(c)) pgn->token_type = TOKEN_SYMBOL;
 
-         pgn_char_read(pgn);
+         pgn->token_string[pgn->token_length++] = c;
 
-      } while (is_symbol_next(pgn->char_hack));
+         pos++;
+         c = (pos < end) ? (unsigned char) data[pos] : TOKEN_EOF;
 
-      pgn_char_unread(pgn);
+      } while (is_symbol_next(c));
 
       ASSERT(pgn->token_length>0&&pgn->token_length<PGN_STRING_SIZE);
       pgn->token_string[pgn->token_length] = '\0';
 
-      if (my_string_equal(pgn->token_string,"1-0")
-       || my_string_equal(pgn->token_string,"0-1")
-       || my_string_equal(pgn->token_string,"1/2-1/2")) {
+      if ((pgn->token_string[0] == '0' || pgn->token_string[0] == '1')
+       && (my_string_equal(pgn->token_string,"1-0")
+        || my_string_equal(pgn->token_string,"0-1")
+        || my_string_equal(pgn->token_string,"1/2-1/2"))) {
          pgn->token_type = TOKEN_RESULT;
       }
 
-   } else if (pgn->char_hack == '"') {
+   } else if (c == '"') {
 
       // string
 
@@ -458,28 +609,28 @@ static void pgn_read_token(pgn_t * pgn) {
 
       while (true) {
 
-         pgn_char_read(pgn);
+         pos++;
 
-         if (pgn->char_hack == CHAR_EOF) {
-            my_fatal("pgn_read_token(): EOF in string at line %d, column %d\n",pgn->char_line,pgn->char_column);
-         }
+         if (pos >= end) pgn_fatal(pgn,end,"pgn_read_token(): EOF in string");
 
-         if (pgn->char_hack == '"') break;
+         c = (unsigned char) data[pos];
 
-         if (pgn->char_hack == '\\') {
+         if (c == '"') break;
 
-            pgn_char_read(pgn);
+         if (c == '\\') {
 
-            if (pgn->char_hack == CHAR_EOF) {
-               my_fatal("pgn_read_token(): EOF in string at line %d, column %d\n",pgn->char_line,pgn->char_column);
-            }
+            pos++;
 
-            if (pgn->char_hack != '"' && pgn->char_hack != '\\') {
+            if (pos >= end) pgn_fatal(pgn,end,"pgn_read_token(): EOF in string");
+
+            c = (unsigned char) data[pos];
+
+            if (c != '"' && c != '\\') {
 
                // bad escape, ignore
 
                if (pgn->token_length >= PGN_STRING_SIZE-1) {
-                  my_fatal("pgn_read_token(): string too long at line %d, column %d\n",pgn->char_line,pgn->char_column);
+                  pgn_fatal(pgn,pos,"pgn_read_token(): string too long");
                }
 
                pgn->token_string[pgn->token_length++] = '\\';
@@ -487,39 +638,35 @@ static void pgn_read_token(pgn_t * pgn) {
          }
 
          if (pgn->token_length >= PGN_STRING_SIZE-1) {
-            my_fatal("pgn_read_token(): string too long at line %d, column %d\n",pgn->char_line,pgn->char_column);
+            pgn_fatal(pgn,pos,"pgn_read_token(): string too long");
          }
 
-         pgn->token_string[pgn->token_length++] = pgn->char_hack;
+         pgn->token_string[pgn->token_length++] = c;
       }
 
+      pos++; // closing quote
+
       ASSERT(pgn->token_length>=0&&pgn->token_length<PGN_STRING_SIZE);
       pgn->token_string[pgn->token_length] = '\0';
 
-   } else if (pgn->char_hack == '$') {
+   } else if (c == '$') {
 
       // NAG
 
       pgn->token_type = TOKEN_NAG;
       pgn->token_length = 0;
 
-      while (true) {
-
-         pgn_char_read(pgn);
-
-         if (!isdigit(pgn->char_hack)) break;
+      for (pos++; pos < end && isdigit((unsigned char) data[pos]); pos++) {
 
          if (pgn->token_length >= 3) {
-            my_fatal("pgn_read_token(): NAG too long at line %d, column %d\n",pgn->char_line,pgn->char_column);
+            pgn_fatal(pgn,pos,"pgn_read_token(): NAG too long");
          }
 
-         pgn->token_string[pgn->token_length++] = pgn->char_hack;
+         pgn->token_string[pgn->token_length++] = data[pos];
       }
 
-      pgn_char_unread(pgn);
-
       if (pgn->token_length == 0) {
-         my_fatal("pgn_read_token(): malformed NAG at line %d, column %d\n",pgn->char_line,pgn->char_column);
+         pgn_fatal(pgn,pos,"pgn_read_token(): malformed NAG");
       }
 
       ASSERT(pgn->token_length>0&&pgn->token_length<=3);
@@ -531,148 +678,93 @@ static void pgn_read_token(pgn_t * pgn) {
 
       // my_fatal("lexical error at line %d, column %d\n",pgn->char_line,pgn->char_column);
    }
+
+   pgn->char_pos = pos;
 }
 
 // pgn_skip_blanks()
 
 static void pgn_skip_blanks(pgn_t * pgn) {
 
+   const char * data;
+   const char * eol;
+   sint64 pos, end;
+   int c;
+
    ASSERT(pgn!=NULL);
 
-   while (true) {
+   data = pgn->data;
+   pos = pgn->char_pos;
+   end = pgn->char_end;
 
-      pgn_char_read(pgn);
+   while (pos < end) {
+
+      c = (unsigned char) data[pos];
 
       if (false) {
 
-      } else if (isspace(pgn->char_hack)) {
+      } else if (c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f') {
 
          // skip white space
 
-      } else if (pgn->char_hack == ';') {
-
-         // skip comment to EOL
-
-         do {
+         pos++;
 
-            pgn_char_read(pgn);
-
-            if (pgn->char_hack == CHAR_EOF) {
-               my_fatal("pgn_skip_blanks(): EOF in comment at line %d, column %d\n",pgn->char_line,pgn->char_column);
-            }
-
-         } while (pgn->char_hack != '\n');
-
-      } else if (pgn->char_hack == '%' && pgn->char_column == 0) {
+      } else if (c == ';' || (c == '%' && (pos == 0 || data[pos-1] == '\n'))) {
 
          // skip comment to EOL
 
-         do {
-
-            pgn_char_read(pgn);
+         eol = (const char *) memchr(&data[pos],'\n',size_t(end-pos));
+         if (eol == NULL) pgn_fatal(pgn,end,"pgn_skip_blanks(): EOF in comment");
 
-            if (pgn->char_hack == CHAR_EOF) {
-               my_fatal("pgn_skip_blanks(): EOF in comment at line %d, column %d\n",pgn->char_line,pgn->char_column);
-            }
-
-         } while (pgn->char_hack != '\n');
+         pos = (eol - data) + 1;
 
-      } else if (pgn->char_hack == '{') {
+      } else if (c == '{') {
 
          // skip comment to next '}'
 
-         do {
-
-            pgn_char_read(pgn);
-
-            if (pgn->char_hack == CHAR_EOF) {
-               my_fatal("pgn_skip_blanks(): EOF in comment at line %d, column %d\n",pgn->char_line,pgn->char_column);
-            }
+         eol = (const char *) memchr(&data[pos],'}',size_t(end-pos));
+         if (eol == NULL) pgn_fatal(pgn,end,"pgn_skip_blanks(): EOF in comment");
 
-         } while (pgn->char_hack != '}');
+         pos = (eol - data) + 1;
 
       } else { // not a white space
 
          break;
       }
    }
+
+   pgn->char_pos = pos;
 }
 
 // is_symbol_start()
 
 static bool is_symbol_start(int c) {
 
-   return strchr("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",c) != NULL;
+   return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
 }
 
 // is_symbol_next()
 
 static bool is_symbol_next(int c) {
 
-   return strchr("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_+#=:-/",c) != NULL;
-}
-
-// pgn_char_read()
-
-static void pgn_char_read(pgn_t * pgn) {
-
-   ASSERT(pgn!=NULL);
-
-   // char "stack"
-
-   if (pgn->char_unread) {
-      pgn->char_unread = false;
-      return;
-   }
+   if (is_symbol_start(c)) return true;
 
-   // consume the current character
-
-   if (pgn->char_first) {
-
-      pgn->char_first = false;
-
-   } else {
-
-      // update counters
-
-      ASSERT(pgn->char_hack!=CHAR_EOF);
-
-      if (false) {
-      } else if (pgn->char_hack == '\n') {
-         pgn->char_line++;
-         pgn->char_column = 0;
-      } else if (pgn->char_hack == '\t') {
-         pgn->char_column += TAB_SIZE - (pgn->char_column % TAB_SIZE);
-      } else {
-         pgn->char_column++;
-      }
-   }
-
-   // read a new character
-
-   pgn->char_hack = fgetc(pgn->file);
-
-   if (pgn->char_hack == EOF) {
-      if (ferror(pgn->file)) my_fatal("pgn_char_read(): fgetc(): %s\n",strerror(errno));
-      pgn->char_hack = TOKEN_EOF;
-   }
-
-   if (DispChar) printf("< L%d C%d '%c' (%02X)\n",pgn->char_line,pgn->char_column,pgn->char_hack,pgn->char_hack);
+   return c == '_' || c == '+' || c == '#' || c == '=' || c == ':' || c == '-' || c == '/';
 }
 
-// pgn_char_unread()
+// pgn_fatal()
 
-static void pgn_char_unread(pgn_t * pgn) {
+static void pgn_fatal(const pgn_t * pgn, sint64 pos, const char message[]) {
 
-   ASSERT(pgn!=NULL);
+   int line, column;
 
-   ASSERT(!pgn->char_unread);
-   ASSERT(!pgn->char_first);
+   ASSERT(pgn!=NULL);
+   ASSERT(message!=NULL);
 
-   pgn->char_unread = true;
+   pgn_line_column(pgn,pos,&line,&column);
+   my_fatal("%s at line %d, column %d\n",message,line,column);
 }
 
 }  // namespace adapter
 
 // end of pgn.cpp
-
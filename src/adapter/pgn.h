@@ -26,8 +26,6 @@
 
 // includes
 
-#include <cstdio>
-
 #include "util.h"
 
 namespace adapter {
@@ -40,36 +38,43 @@ const int PGN_STRING_SIZE = 256;
 
 struct pgn_t {
 
-   FILE * file;
+   const char * data; // the whole file, mapped in memory
+   sint64 size;
+   bool mapped;
+   bool owner; // false for a range of a shared file
 
-   int char_hack;
-   int char_line;
-   int char_column;
-   bool char_unread;
-   bool char_first;
+   sint64 char_pos; // offset of the next character
+   sint64 char_end; // end of the range being read
 
    int token_type;
    char token_string[PGN_STRING_SIZE];
    int token_length;
-   int token_line;
-   int token_column;
+   sint64 token_pos;
    bool token_unread;
    bool token_first;
 
    char result[PGN_STRING_SIZE];
    char fen[PGN_STRING_SIZE];
+   char white[PGN_STRING_SIZE];
+   char black[PGN_STRING_SIZE];
+   char white_elo[PGN_STRING_SIZE];
+   char black_elo[PGN_STRING_SIZE];
 
-   int move_line;
-   int move_column;
+   sint64 move_pos;
 };
 
 // functions
 
-extern void pgn_open      (pgn_t * pgn, const char file_name[]);
-extern void pgn_close     (pgn_t * pgn);
+extern void pgn_open        (pgn_t * pgn, const char file_name[]);
+extern void pgn_close       (pgn_t * pgn);
+
+extern void pgn_open_range  (pgn_t * pgn, const pgn_t * file, sint64 start, sint64 end);
+extern void pgn_discard     (const pgn_t * pgn, sint64 end);
+
+extern void pgn_line_column (const pgn_t * pgn, sint64 pos, int * line, int * column);
 
-extern bool pgn_next_game (pgn_t * pgn);
-extern bool pgn_next_move (pgn_t * pgn, char string[], int size);
+extern bool pgn_next_game   (pgn_t * pgn);
+extern bool pgn_next_move   (pgn_t * pgn, char string[], int size);
 
 }  // namespace adapter
 
@@ -47,6 +47,36 @@ static const bool UseDebug = false;
 
 static const int StringSize = 4096;
 
+static const int MoveStringSize = 8;
+
+// "info" keywords, in the order of InfoKeyword[]
+
+enum info_keyword_t {
+   INFO_CPULOAD,
+   INFO_CURRLINE,
+   INFO_CURRMOVE,
+   INFO_CURRMOVENUMBER,
+   INFO_DEPTH,
+   INFO_HASHFULL,
+   INFO_MULTIPV,
+   INFO_NODES,
+   INFO_NPS,
+   INFO_PV,
+   INFO_REFUTATION,
+   INFO_SCORE,
+   INFO_SELDEPTH,
+   INFO_STRING,
+   INFO_TBHITS,
+   INFO_TIME,
+   INFO_NONE
+};
+
+static const char * const InfoKeyword[INFO_NONE] = {
+   "cpuload", "currline", "currmove", "currmovenumber", "depth", "hashfull",
+   "multipv", "nodes", "nps", "pv", "refutation", "score", "seldepth",
+   "string", "tbhits", "time",
+};
+
 // variables
 
 uci_t Uci[1];
@@ -61,7 +91,11 @@ static int  parse_bestmove (uci_t * uci, const char string[]);
 static void parse_id       (uci_t * uci, const char string[]);
 static int  parse_info     (uci_t * uci, const char string[]);
 static void parse_option   (uci_t * uci, const char string[]);
-static void parse_score    (uci_t * uci, const char string[]);
+static void parse_score    (uci_t * uci, const char * * ptr);
+static void parse_line     (move_t line[], const board_t * board, const char * * ptr);
+
+static const char * next_word (const char * * ptr, int * len);
+static int  info_keyword   (const char word[], int len);
 
 static int  mate_score     (int dist);
 
@@ -317,6 +351,17 @@ int uci_parse(uci_t * uci, const char string[]) {
 
    event = EVENT_NONE;
 
+   // "info" lines are most of the traffic, they are parsed in place
+
+   if (strncmp(string,"info",4) == 0 && (string[4] == ' ' || string[4] == '\0')) {
+
+      if (uci->searching && uci->pending_nb == 1) { // current search
+         event = parse_info(uci,&string[4]);
+      }
+
+      return event;
+   }
+
    // parse
 
    parse_open(parse,string);
@@ -357,14 +402,6 @@ int uci_parse(uci_t * uci, const char string[]) {
 
          parse_id(uci,argument);
 
-      } else if (my_string_equal(command,"info")) {
-
-         // search information
-
-         if (uci->searching && uci->pending_nb == 1) { // current search
-            event = parse_info(uci,argument);
-         }
-
       } else if (my_string_equal(command,"option")) {
 
          parse_option(uci,argument);
@@ -510,10 +547,10 @@ static void parse_id(uci_t * uci, const char string[]) {
 static int parse_info(uci_t * uci, const char string[]) {
 
    int event;
-   parse_t parse[1];
-   char command[StringSize];
-   char option[StringSize];
-   char argument[StringSize];
+   const char * ptr;
+   const char * word;
+   int len;
+   int key;
    int n;
    sint64 ln;
 
@@ -524,174 +561,140 @@ static int parse_info(uci_t * uci, const char string[]) {
 
    event = EVENT_NONE;
 
-   strcpy(command,"info");
+   // single pass over the line, values are read where they are
 
-   parse_open(parse,string);
-   parse_add_keyword(parse,"cpuload");
-   parse_add_keyword(parse,"currline");
-   parse_add_keyword(parse,"currmove");
-   parse_add_keyword(parse,"currmovenumber");
-   parse_add_keyword(parse,"depth");
-   parse_add_keyword(parse,"hashfull");
-   parse_add_keyword(parse,"multipv");
-   parse_add_keyword(parse,"nodes");
-   parse_add_keyword(parse,"nps");
-   parse_add_keyword(parse,"pv");
-   parse_add_keyword(parse,"refutation");
-   parse_add_keyword(parse,"score");
-   parse_add_keyword(parse,"seldepth");
-   parse_add_keyword(parse,"string");
-   parse_add_keyword(parse,"tbhits");
-   parse_add_keyword(parse,"time");
+   ptr = string;
 
-   // loop
+   while ((word = next_word(&ptr,&len)) != NULL) {
 
-   while (parse_get_word(parse,option,StringSize)) {
+      key = info_keyword(word,len);
 
-      parse_get_string(parse,argument,StringSize);
-
-      if (UseDebug) my_log("POLYGLOT COMMAND \"%s\" OPTION \"%s\" ARGUMENT \"%s\"\n",command,option,argument);
+      if (UseDebug) my_log("POLYGLOT COMMAND \"info\" OPTION \"%.*s\"\n",len,word);
 
       if (false) {
 
-      } else if (my_string_equal(option,"cpuload")) {
-
-         ASSERT(!my_string_empty(argument));
-
-         n = atoi(argument);
-         ASSERT(n>=0);
-
-         if (n >= 0) uci->cpu = double(n) / 1000.0;
-
-      } else if (my_string_equal(option,"currline")) {
-
-         ASSERT(!my_string_empty(argument));
-
-         line_from_can(uci->current_line,uci->board,argument,LineSize);
-
-      } else if (my_string_equal(option,"currmove")) {
+      } else if (key == INFO_CURRLINE) {
 
-         ASSERT(!my_string_empty(argument));
+         parse_line(uci->current_line,uci->board,&ptr);
 
-         uci->root_move = move_from_can(argument,uci->board);
-         ASSERT(uci->root_move!=MoveNone);
+      } else if (key == INFO_PV) {
 
-      } else if (my_string_equal(option,"currmovenumber")) {
+         parse_line(uci->pv,uci->board,&ptr);
+         event |= EVENT_PV;
 
-         ASSERT(!my_string_empty(argument));
+      } else if (key == INFO_REFUTATION) {
 
-         n = atoi(argument);
-         ASSERT(n>=1&&n<=uci->root_move_nb);
+         parse_line(uci->pv,uci->board,&ptr);
 
-         if (n >= 1 && n <= uci->root_move_nb) {
-            uci->root_move_pos = n - 1;
-            ASSERT(uci->root_move_pos>=0&&uci->root_move_pos<uci->root_move_nb);
-         }
+      } else if (key == INFO_SCORE) {
 
-      } else if (my_string_equal(option,"depth")) {
+         parse_score(uci,&ptr);
 
-         ASSERT(!my_string_empty(argument));
+      } else if (key == INFO_STRING) {
 
-         n = atoi(argument);
-         ASSERT(n>=1);
+         break; // the rest of the line
 
-         if (n >= 0) {
-            if (n > uci->depth) event |= EVENT_DEPTH;
-            uci->depth = n;
-         }
+      } else if (key == INFO_NONE) {
 
-      } else if (my_string_equal(option,"hashfull")) {
+         my_log("POLYGLOT unknown option \"%.*s\" for command \"info\"\n",len,word);
 
-         ASSERT(!my_string_empty(argument));
+      } else {
 
-         n = atoi(argument);
-         ASSERT(n>=0);
+         // single-word argument
 
-         if (n >= 0) uci->hash = double(n) / 1000.0;
+         word = next_word(&ptr,&len);
+         ASSERT(word!=NULL);
 
-      } else if (my_string_equal(option,"multipv")) {
+         if (word == NULL) break;
 
-         ASSERT(!my_string_empty(argument));
+         if (false) {
 
-         n = atoi(argument);
-         ASSERT(n>=1);
+         } else if (key == INFO_CPULOAD) {
 
-      } else if (my_string_equal(option,"nodes")) {
+            n = atoi(word);
+            ASSERT(n>=0);
 
-         ASSERT(!my_string_empty(argument));
+            if (n >= 0) uci->cpu = double(n) / 1000.0;
 
-         ln = my_atoll(argument);
-         ASSERT(ln>=0);
+         } else if (key == INFO_CURRMOVE) {
 
-         if (ln >= 0) uci->node_nb = ln;
+            char move_string[MoveStringSize];
 
-      } else if (my_string_equal(option,"nps")) {
+            if (len >= MoveStringSize) len = MoveStringSize - 1;
+            memcpy(move_string,word,len);
+            move_string[len] = '\0';
 
-         ASSERT(!my_string_empty(argument));
-
-         n = atoi(argument);
-         ASSERT(n>=0);
+            uci->root_move = move_from_can(move_string,uci->board);
+            ASSERT(uci->root_move!=MoveNone);
 
-         if (n >= 0) uci->speed = double(n);
+         } else if (key == INFO_CURRMOVENUMBER) {
 
-      } else if (my_string_equal(option,"pv")) {
+            n = atoi(word);
+            ASSERT(n>=1&&n<=uci->root_move_nb);
 
-         ASSERT(!my_string_empty(argument));
-
-         line_from_can(uci->pv,uci->board,argument,LineSize);
-         event |= EVENT_PV;
+            if (n >= 1 && n <= uci->root_move_nb) {
+               uci->root_move_pos = n - 1;
+               ASSERT(uci->root_move_pos>=0&&uci->root_move_pos<uci->root_move_nb);
+            }
 
-      } else if (my_string_equal(option,"refutation")) {
+         } else if (key == INFO_DEPTH) {
 
-         ASSERT(!my_string_empty(argument));
+            n = atoi(word);
+            ASSERT(n>=1);
 
-         line_from_can(uci->pv,uci->board,argument,LineSize);
+            if (n >= 0) {
+               if (n > uci->depth) event |= EVENT_DEPTH;
+               uci->depth = n;
+            }
 
-      } else if (my_string_equal(option,"score")) {
+         } else if (key == INFO_HASHFULL) {
 
-         ASSERT(!my_string_empty(argument));
+            n = atoi(word);
+            ASSERT(n>=0);
 
-         parse_score(uci,argument);
+            if (n >= 0) uci->hash = double(n) / 1000.0;
 
-      } else if (my_string_equal(option,"seldepth")) {
+         } else if (key == INFO_MULTIPV) {
 
-         ASSERT(!my_string_empty(argument));
+            n = atoi(word);
+            ASSERT(n>=1);
 
-         n = atoi(argument);
-         ASSERT(n>=0);
+         } else if (key == INFO_NODES) {
 
-         if (n >= 0) uci->sel_depth = n;
+            ln = my_atoll(word);
+            ASSERT(ln>=0);
 
-      } else if (my_string_equal(option,"string")) {
+            if (ln >= 0) uci->node_nb = ln;
 
-         // TODO: argument to EOS
+         } else if (key == INFO_NPS) {
 
-         ASSERT(!my_string_empty(argument));
+            n = atoi(word);
+            ASSERT(n>=0);
 
-      } else if (my_string_equal(option,"tbhits")) {
+            if (n >= 0) uci->speed = double(n);
 
-         ASSERT(!my_string_empty(argument));
+         } else if (key == INFO_SELDEPTH) {
 
-         ln = my_atoll(argument);
-         ASSERT(ln>=0);
+            n = atoi(word);
+            ASSERT(n>=0);
 
-      } else if (my_string_equal(option,"time")) {
+            if (n >= 0) uci->sel_depth = n;
 
-         ASSERT(!my_string_empty(argument));
+         } else if (key == INFO_TBHITS) {
 
-         n = atoi(argument);
-         ASSERT(n>=0);
+            ln = my_atoll(word);
+            ASSERT(ln>=0);
 
-         if (n >= 0) uci->time = double(n) / 1000.0;
+         } else if (key == INFO_TIME) {
 
-      } else {
+            n = atoi(word);
+            ASSERT(n>=0);
 
-         my_log("POLYGLOT unknown option \"%s\" for command \"%s\"\n",option,command);
+            if (n >= 0) uci->time = double(n) / 1000.0;
+         }
       }
    }
 
-   parse_close(parse);
-
    // update display
 
    if ((event & EVENT_PV) != 0) {
@@ -798,69 +801,173 @@ static void parse_option(uci_t * uci, const char string[]) {
 
 // parse_score()
 
-static void parse_score(uci_t * uci, const char string[]) {
+static void parse_score(uci_t * uci, const char * * ptr) {
 
-   parse_t parse[1];
-   char command[StringSize];
-   char option[StringSize];
-   char argument[StringSize];
+   const char * word;
+   const char * save;
+   int len;
    int n;
 
    ASSERT(uci_is_ok(uci));
-   ASSERT(string!=NULL);
+   ASSERT(ptr!=NULL);
 
-   // init
+   // loop, up to the next "info" keyword
 
-   strcpy(command,"score");
+   while (true) {
 
-   parse_open(parse,string);
-   parse_add_keyword(parse,"cp");
-   parse_add_keyword(parse,"lowerbound");
-   parse_add_keyword(parse,"mate");
-   parse_add_keyword(parse,"upperbound");
+      save = *ptr;
+      word = next_word(ptr,&len);
+      if (word == NULL) break;
 
-   // loop
+      if (UseDebug) my_log("POLYGLOT COMMAND \"score\" OPTION \"%.*s\"\n",len,word);
 
-   while (parse_get_word(parse,option,StringSize)) {
+      if (false) {
 
-      parse_get_string(parse,argument,StringSize);
+      } else if (len == 2 && memcmp(word,"cp",2) == 0) {
 
-      if (UseDebug) my_log("POLYGLOT COMMAND \"%s\" OPTION \"%s\" ARGUMENT \"%s\"\n",command,option,argument);
+         word = next_word(ptr,&len);
+         ASSERT(word!=NULL);
 
-      if (false) {
+         if (word != NULL) {
+            n = atoi(word);
+            uci->score = n;
+         }
 
-      } else if (my_string_equal(option,"cp")) {
+      } else if (len == 4 && memcmp(word,"mate",4) == 0) {
 
-         ASSERT(!my_string_empty(argument));
+         word = next_word(ptr,&len);
+         ASSERT(word!=NULL);
+
+         if (word != NULL) {
+            n = atoi(word);
+            ASSERT(n!=0);
+            if (n != 0) uci->score = mate_score(n);
+         }
 
-         n = atoi(argument);
+      } else if (len == 10 && memcmp(word,"lowerbound",10) == 0) {
 
-         uci->score = n;
+         // nothing
 
-      } else if (my_string_equal(option,"lowerbound")) {
+      } else if (len == 10 && memcmp(word,"upperbound",10) == 0) {
 
-         ASSERT(my_string_empty(argument));
+         // nothing
 
-      } else if (my_string_equal(option,"mate")) {
+      } else if (info_keyword(word,len) != INFO_NONE) {
 
-         ASSERT(!my_string_empty(argument));
+         *ptr = save; // end of the score
+         break;
+
+      } else {
+
+         my_log("POLYGLOT unknown option \"%.*s\" for command \"score\"\n",len,word);
+      }
+   }
+}
 
-         n = atoi(argument);
-         ASSERT(n!=0);
+// parse_line()
 
-         uci->score = mate_score(n);
+static void parse_line(move_t line[], const board_t * board, const char * * ptr) {
 
-      } else if (my_string_equal(option,"upperbound")) {
+   board_t new_board[1];
+   char move_string[MoveStringSize];
+   const char * word;
+   const char * save;
+   int len;
+   int pos;
+   int move;
+   bool legal;
 
-         ASSERT(my_string_empty(argument));
+   ASSERT(line!=NULL);
+   ASSERT(board_is_ok(board));
+   ASSERT(ptr!=NULL);
 
-      } else {
+   // same as line_from_can(), but stops at the next "info" keyword
 
-         my_log("POLYGLOT unknown option \"%s\" for command \"%s\"\n",option,command);
+   board_copy(new_board,board);
+   pos = 0;
+   legal = true;
+
+   while (true) {
+
+      save = *ptr;
+      word = next_word(ptr,&len);
+      if (word == NULL) break;
+
+      if (info_keyword(word,len) != INFO_NONE) {
+         *ptr = save;
+         break;
+      }
+
+      if (!legal || pos >= LineSize - 1) continue; // skip the rest of the line
+
+      if (len >= MoveStringSize) len = MoveStringSize - 1;
+      memcpy(move_string,word,len);
+      move_string[len] = '\0';
+
+      move = move_from_can(move_string,new_board);
+
+      ASSERT(move!=MoveNone);
+      ASSERT(move_is_legal(move,new_board));
+
+      if (move == MoveNone || !move_is_legal(move,new_board)) { // HACK: ignore illegal moves
+         legal = false;
+         continue;
       }
+
+      line[pos++] = move;
+      move_do(new_board,move);
    }
 
-   parse_close(parse);
+   ASSERT(pos<LineSize);
+   line[pos] = MoveNone;
+}
+
+// next_word()
+
+static const char * next_word(const char * * ptr, int * len) {
+
+   const char * start;
+   const char * end;
+
+   ASSERT(ptr!=NULL);
+   ASSERT(*ptr!=NULL);
+   ASSERT(len!=NULL);
+
+   start = *ptr;
+   while (*start == ' ' || *start == '\t') start++;
+
+   if (*start == '\0') {
+      *ptr = start;
+      return NULL;
+   }
+
+   end = start;
+   while (*end != '\0' && *end != ' ' && *end != '\t') end++;
+
+   *ptr = end;
+   *len = int(end - start);
+
+   return start;
+}
+
+// info_keyword()
+
+static int info_keyword(const char word[], int len) {
+
+   int key;
+
+   ASSERT(word!=NULL);
+   ASSERT(len>0);
+
+   for (key = 0; key < INFO_NONE; key++) {
+      if (InfoKeyword[key][0] == word[0]
+       && strncmp(InfoKeyword[key],word,len) == 0
+       && InfoKeyword[key][len] == '\0') {
+         return key;
+      }
+   }
+
+   return INFO_NONE;
 }
 
 // mate_score()
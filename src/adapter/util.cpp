@@ -32,6 +32,11 @@
 #include <cstring>
 #include <ctime>
 
+#include <atomic>
+
+#include <pthread.h>
+#include <unistd.h>
+
 #include "main.h"
 #include "posix.h"
 #include "util.h"
@@ -43,12 +48,41 @@ namespace adapter {
 
 const int MaxFileNameSize = 256;
 
+const int LogSlotNb = 1024; // must be a power of two
+const int LogLineSize = 1024; // longer lines are truncated
+const int LogBufferSize = 65536;
+const int LogDelay = 10000; // microseconds between two batches
+
+// types
+
+struct log_slot_t {
+   std::atomic<uint32> seq; // position + 1 once the line is written
+   double time;
+   char string[LogLineSize];
+};
+
 // variables
 
 static bool Error;
 
 static FILE * LogFile;
 
+// lines are queued by any thread and written in batches by LogThread
+
+static log_slot_t LogSlot[LogSlotNb];
+static std::atomic<uint32> LogHead; // next position to fill
+static std::atomic<uint32> LogTail; // next position to write
+static std::atomic<uint32> LogDropped; // lines lost on a full ring
+static std::atomic<bool> LogStop;
+static uint32 LogReported; // dropped lines already reported
+static double LogStart;
+static pthread_t LogThread;
+
+// prototypes
+
+static void * log_thread (void * arg);
+static int    log_drain  ();
+
 // functions
 
 // util_init()
@@ -155,16 +189,51 @@ void my_log_open(const char file_name[]) {
 
    ASSERT(file_name!=NULL);
 
+   ASSERT(LogFile==NULL);
+
    LogFile = fopen(file_name,"a");
+   if (LogFile == NULL) return;
 
-   if (LogFile != NULL) setvbuf(LogFile,NULL,_IOLBF,0); // line buffering
+   setvbuf(LogFile,NULL,_IOFBF,LogBufferSize); // flushed once per batch
+
+   for (int pos = 0; pos < LogSlotNb; pos++) {
+      LogSlot[pos].seq.store(pos,std::memory_order_relaxed);
+   }
+
+   LogHead.store(0);
+   LogTail.store(0);
+   LogDropped.store(0);
+   LogStop.store(false);
+   LogReported = 0;
+   LogStart = now_real();
+
+   if (pthread_create(&LogThread,NULL,log_thread,NULL) != 0) {
+      fclose(LogFile);
+      LogFile = NULL;
+      my_fatal("my_log_open(): pthread_create(): failed\n");
+   }
+
+   atexit(my_log_close); // the lines still queued when the program exits
 }
 
 // my_log_close()
 
 void my_log_close() {
 
-   if (LogFile != NULL) fclose(LogFile);
+   if (LogFile == NULL) return;
+
+   LogStop.store(true,std::memory_order_release);
+   pthread_join(LogThread,NULL);
+
+   fclose(LogFile);
+   LogFile = NULL;
+}
+
+// my_log_is_open()
+
+bool my_log_is_open() {
+
+   return LogFile != NULL;
 }
 
 // my_log()
@@ -172,14 +241,122 @@ void my_log_close() {
 void my_log(const char format[], ...) {
 
    va_list ap;
+   double time;
+   uint32 pos, seq;
+   log_slot_t * slot;
+   int len;
 
    ASSERT(format!=NULL);
 
-   if (LogFile != NULL) {
-      va_start(ap,format);
-      vfprintf(LogFile,format,ap);
-      va_end(ap);
+   if (LogFile == NULL) return;
+
+   time = now_real() - LogStart; // when the event happened, not when it is written
+
+   // reserve a slot, or drop the line if the writer is too far behind
+
+   pos = LogHead.load(std::memory_order_relaxed);
+
+   while (true) {
+
+      slot = &LogSlot[pos&(LogSlotNb-1)];
+      seq = slot->seq.load(std::memory_order_acquire);
+
+      if (seq == pos) {
+         if (LogHead.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed)) break;
+      } else if (sint32(seq - pos) < 0) { // full
+         LogDropped.fetch_add(1,std::memory_order_relaxed);
+         return;
+      } else {
+         pos = LogHead.load(std::memory_order_relaxed);
+      }
+   }
+
+   // fill it
+
+   slot->time = time;
+
+   va_start(ap,format);
+   len = vsnprintf(slot->string,LogLineSize,format,ap);
+   va_end(ap);
+
+   if (len >= LogLineSize) slot->string[LogLineSize-2] = '\n'; // truncated
+
+   slot->seq.store(pos+1,std::memory_order_release);
+}
+
+// my_log_flush()
+
+void my_log_flush() {
+
+   uint32 head;
+
+   if (LogFile == NULL) return;
+
+   // wait until the lines queued so far have been written
+
+   head = LogHead.load(std::memory_order_acquire);
+
+   while (sint32(LogTail.load(std::memory_order_acquire) - head) < 0) {
+      usleep(LogDelay/10);
+   }
+}
+
+// log_thread()
+
+static void * log_thread(void * /* arg */) {
+
+   bool stop;
+
+   while (true) {
+      stop = LogStop.load(std::memory_order_acquire);
+      if (log_drain() == 0) {
+         if (stop) break;
+         usleep(LogDelay);
+      }
+   }
+
+   return NULL;
+}
+
+// log_drain()
+
+static int log_drain() {
+
+   uint32 pos, dropped;
+   log_slot_t * slot;
+   int n;
+
+   ASSERT(LogFile!=NULL);
+
+   // write the complete lines in order, stop at the first one being filled
+
+   pos = LogTail.load(std::memory_order_relaxed);
+
+   for (n = 0; n < LogSlotNb; n++) {
+
+      slot = &LogSlot[pos&(LogSlotNb-1)];
+      if (slot->seq.load(std::memory_order_acquire) != pos + 1) break;
+
+      fprintf(LogFile,"%.3f %s",slot->time,slot->string);
+
+      slot->seq.store(pos+LogSlotNb,std::memory_order_release);
+      pos++;
+   }
+
+   dropped = LogDropped.load(std::memory_order_relaxed);
+
+   if (dropped != LogReported) {
+      fprintf(LogFile,"%.3f POLYGLOT *** %u LOG LINES DROPPED ***\n",now_real()-LogStart,dropped-LogReported);
+      LogReported = dropped;
+      n++;
+   }
+
+   if (n > 0) {
+      fflush(LogFile); // one write() for the whole batch
+      LogTail.store(pos,std::memory_order_release);
    }
+
+   return n;
 }
 
 // my_fatal()
@@ -187,15 +364,20 @@ void my_log(const char format[], ...) {
 void my_fatal(const char format[], ...) {
 
    va_list ap;
+   char string[LogLineSize];
 
    ASSERT(format!=NULL);
 
    va_start(ap,format);
+   vsnprintf(string,LogLineSize,format,ap);
+   va_end(ap);
 
-   vfprintf(stderr,format,ap);
-   if (LogFile != NULL) vfprintf(LogFile,format,ap);
+   fputs(string,stderr);
 
-   va_end(ap);
+   if (LogFile != NULL) {
+      my_log("%s",string);
+      my_log_flush();
+   }
 
    if (Error) { // recursive error
       my_log("POLYGLOT *** RECURSIVE ERROR ***\n");
@@ -203,7 +385,8 @@ void my_fatal(const char format[], ...) {
       // abort();
    } else {
       Error = true;
-      quit();
+      quit(); // returns if the engine is not running, as in the command-line tools
+      exit(EXIT_FAILURE);
    }
 }
 
@@ -119,6 +119,8 @@ extern void   my_free               (void * address);
 
 extern void   my_log_open           (const char file_name[]);
 extern void   my_log_close          ();
+extern bool   my_log_is_open        ();
+extern void   my_log_flush          ();
 
 extern void   my_log                (const char format[], ...);
 extern void   my_fatal              (const char format[], ...);
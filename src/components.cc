@@ -1,4 +1,4 @@
-/* GNU Chess 6 - components.cc - Pipes shared across modules
+/* GNU Chess 6 - components.cc - Queues shared across modules
 
    Copyright (c) 2001-2017 Free Software Foundation, Inc.
 
@@ -56,15 +56,15 @@ pthread_t adapter_thread;
 /* Engine thread */
 pthread_t engine_thread;
 
-int pipefd_i2f[2];
+queue_t queue_i2f[1];
 
-/* Pipes to communicate frontend and adapter */
-int pipefd_f2a[2];
-int pipefd_a2f[2];
+/* Queues to communicate frontend and adapter */
+queue_t queue_f2a[1];
+queue_t queue_a2f[1];
 
-/* Pipes to communicate adapter and engine */
-int pipefd_a2e[2];
-int pipefd_e2a[2];
+/* Queues to communicate adapter and engine */
+queue_t queue_a2e[1];
+queue_t queue_e2a[1];
 
 /*
  * Entry point for the input thread
@@ -80,11 +80,8 @@ int pipefd_e2a[2];
 
 void InitInputThread()
 {
-  /* Create pipes to communicate input and frontend. */
-  if ( pipe( pipefd_i2f ) != 0 ) {
-    printf( "Error while creating pipe.\n" );
-    exit( 1 );
-  }
+  /* Create queue to communicate input and frontend. */
+  queue_init( queue_i2f );
 
   /* Start input thread */
   pthread_create(&input_thread, NULL, input_func, NULL);
@@ -107,11 +104,9 @@ void *adapter_func(void *arg)
  */
 void InitAdapter()
 {
-  /* Create pipes to communicate frontend and adapter. */
-  if ( ( pipe( pipefd_f2a ) != 0 ) || ( pipe( pipefd_a2f ) != 0 ) ) {
-    printf( "Error while creating pipes.\n" );
-    exit( 1 );
-  }
+  /* Create queues to communicate frontend and adapter. */
+  queue_init( queue_f2a );
+  queue_init( queue_a2f );
 
   pthread_mutex_init( &adapter::adapter_init_mutex, NULL );
   pthread_cond_init( &adapter::adapter_init_cond, NULL );
@@ -144,16 +139,28 @@ void *engine_func(void *arg)
 
 void InitEngine()
 {
-  /* Create pipes to communicate adapter and engine. */
-  if ( ( pipe( pipefd_a2e ) != 0 ) || ( pipe( pipefd_e2a ) != 0 ) ) {
-    printf( "Error while creating pipes.\n" );
-    exit( 1 );
-  }
+  /* Create queues to communicate adapter and engine. */
+  queue_init( queue_a2e );
+  queue_init( queue_e2a );
 
   /* Start engine thread */
   pthread_create(&engine_thread, NULL, engine_func, NULL);
 }
 
+/*
+ * Runs one of the adapter command line tools (epd-test, make-book,
+ * merge-book, make-gamedb, find-games) in the calling thread and returns
+ * its exit status.
+ */
+int RunAdapterTool( int argc, char *argv[] )
+{
+  /* Only epd-test talks to the engine, the others work on files */
+  if ( argc >= 2 && strcmp( argv[1], "epd-test" ) == 0 ) {
+    InitEngine();
+  }
+  return adapter::main_adapter( argc, argv );
+}
+
 int SendToEngine( char msg[] );
 
 void TerminateAdapterEngine()
@@ -171,6 +178,9 @@ void TerminateAdapterEngine()
 
 void TerminateInput()
 {
-  pthread_cancel( input_thread );
-  pthread_join( input_thread, NULL );
+  /* There is no input thread in UCI mode */
+  if ( ! (flags & UCI ) ) {
+    pthread_cancel( input_thread );
+    pthread_join( input_thread, NULL );
+  }
 }
@@ -1,4 +1,4 @@
-/* GNU Chess 6 - components.h - Pipes shared across modules
+/* GNU Chess 6 - components.h - Queues shared across modules
 
    Copyright (c) 2001-2017 Free Software Foundation, Inc.
 
@@ -28,15 +28,17 @@
 
 #include <pthread.h>
 
-/* File descriptors for the pipes to be used to communicate frontend, adapter and engine */
+#include "queue.h"
 
-extern int pipefd_i2f[2];
+/* Queues used to communicate frontend, adapter and engine */
 
-extern int pipefd_f2a[2];
-extern int pipefd_a2f[2];
+extern queue_t queue_i2f[1];
 
-extern int pipefd_a2e[2];
-extern int pipefd_e2a[2];
+extern queue_t queue_f2a[1];
+extern queue_t queue_a2f[1];
+
+extern queue_t queue_a2e[1];
+extern queue_t queue_e2a[1];
 
 /*
  * Entry point for the adapter thread
@@ -54,4 +56,9 @@ void InitEngine();
 void TerminateAdapterEngine();
 void TerminateInput();
 
+/*
+ * Runs an adapter command line tool such as "epd-test" and returns its exit status.
+ */
+int RunAdapterTool( int argc, char *argv[] );
+
 #endif /* COMPONENTS_H */
@@ -0,0 +1,313 @@
+/* api.cpp
+
+   GNU Chess engine
+
+   Copyright (C) 2001-2011 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// api.cpp
+
+// replaces protocol.cpp in the library: search() reports to the caller
+// through iteration() instead of sending "info" lines
+
+// includes
+
+#include <atomic>
+#include <cstdarg>
+#include <cstring>
+
+#include "api.h"
+#include "board.h"
+#include "eval.h"
+#include "fen.h"
+#include "init.h"
+#include "list.h"
+#include "move.h"
+#include "move_do.h"
+#include "move_gen.h"
+#include "option.h"
+#include "protocol.h"
+#include "search.h"
+#include "trans.h"
+#include "util.h"
+#include "value.h"
+
+namespace engine {
+
+// variables
+
+std::atomic<bool> InputEvent;
+
+static std::atomic<bool> StopRequest;
+
+static api_callback_t Callback;
+static void * CallbackData;
+
+// prototypes
+
+static bool play_move (board_t * board, const char move_string[]);
+
+// functions
+
+// api_init()
+
+void api_init() {
+
+   init_early();
+
+   search_clear();
+   board_from_fen(SearchInput->board,StartFen);
+
+   InputEvent = false;
+   StopRequest = false;
+
+   Callback = NULL;
+   CallbackData = NULL;
+}
+
+// api_set_option()
+
+bool api_set_option(const char name[], const char value[]) {
+
+   ASSERT(name!=NULL);
+   ASSERT(value!=NULL);
+
+   if (!option_set(name,value)) return false;
+
+   // update transposition-table size if needed
+
+   if (init_is_done() && my_string_equal(name,"Hash")) { // already allocated
+
+      if (option_get_int("Hash") >= 4) {
+         trans_free(Trans);
+         trans_alloc(Trans);
+      }
+   }
+
+   return true;
+}
+
+// api_new_game()
+
+void api_new_game() {
+
+   if (init_is_done()) trans_clear(Trans);
+}
+
+// api_set_position()
+
+bool api_set_position(const char fen[], const char moves[]) {
+
+   board_t board[1];
+   const char * ptr;
+   char move_string[8];
+   int len;
+
+   init_late();
+
+   // the position is built aside, the current one is kept on error
+
+   if (fen == NULL) fen = StartFen;
+   if (!fen_is_ok(fen)) return false;
+
+   board_from_fen(board,fen);
+
+   // moves
+
+   for (ptr = moves; ptr != NULL && *ptr != '\0'; ptr += len) {
+
+      while (*ptr == ' ') ptr++;
+      if (*ptr == '\0') break;
+
+      len = int(strcspn(ptr," "));
+      if (len >= int(sizeof(move_string))) return false;
+
+      memcpy(move_string,ptr,len);
+      move_string[len] = '\0';
+
+      if (!play_move(board,move_string)) return false;
+   }
+
+   board_copy(SearchInput->board,board);
+
+   return true;
+}
+
+// api_play_move()
+
+bool api_play_move(const char move_string[]) {
+
+   ASSERT(move_string!=NULL);
+
+   return play_move(SearchInput->board,move_string);
+}
+
+// play_move()
+
+static bool play_move(board_t * board, const char move_string[]) {
+
+   int move;
+   list_t list[1];
+   undo_t undo[1];
+
+   ASSERT(board!=NULL);
+   ASSERT(move_string!=NULL);
+
+   move = move_from_string(move_string,board);
+   if (move == MoveNone) return false;
+
+   gen_legal_moves(list,board);
+   if (!list_contain(list,move)) return false;
+
+   move_do(board,move,undo);
+
+   return true;
+}
+
+// api_search()
+
+int api_search(const api_limit_t * limit, api_callback_t callback, void * data, int * ponder_move) {
+
+   const mv_t * pv;
+
+   ASSERT(limit!=NULL);
+
+   // init
+
+   init_late();
+
+   search_clear();
+
+   if (limit->depth > 0) {
+      SearchInput->depth_is_limited = true;
+      SearchInput->depth_limit = limit->depth;
+   }
+
+   search_set_time((limit->move_time > 0.0) ? limit->move_time : -1.0,
+                   (limit->time > 0.0) ? limit->time : -1.0,
+                   limit->inc,
+                   limit->moves_to_go);
+
+   SearchInput->infinite = limit->infinite;
+
+   StopRequest = false; // as in UCI, "stop" does nothing between searches
+
+   Callback = callback;
+   CallbackData = data;
+
+   // search
+
+   search();
+   search_update_current();
+
+   Callback = NULL;
+   CallbackData = NULL;
+
+   // best move
+
+   pv = SearchBest->pv;
+
+   if (ponder_move != NULL) {
+      *ponder_move = (pv[0] == SearchBest->move && move_is_ok(pv[1])) ? pv[1] : MoveNone;
+   }
+
+   return SearchBest->move;
+}
+
+// api_stop()
+
+void api_stop() {
+
+   StopRequest = true;
+   InputEvent = true; // checked at every node
+}
+
+// api_eval()
+
+int api_eval() {
+
+   init_late();
+
+   return eval(SearchInput->board);
+}
+
+// api_move_to_string()
+
+bool api_move_to_string(int move, char string[], int size) {
+
+   ASSERT(string!=NULL);
+
+   return move_to_string(move,string,size);
+}
+
+// event()
+
+void event() {
+
+   InputEvent = false;
+
+   if (StopRequest) SearchInfo->stop = true;
+}
+
+// iteration()
+
+void iteration() {
+
+   api_info_t info[1];
+   int size;
+
+   if (Callback == NULL) return;
+
+   info->depth = SearchBest->depth;
+   info->sel_depth = SearchCurrent->max_depth;
+   info->score = SearchBest->value;
+   info->mate = value_to_mate(SearchBest->value);
+
+   if (SearchBest->flags == SearchLower) {
+      info->bound = ApiLower;
+   } else if (SearchBest->flags == SearchUpper) {
+      info->bound = ApiUpper;
+   } else {
+      info->bound = ApiExact;
+   }
+
+   info->node_nb = SearchCurrent->node_nb;
+   info->time = SearchCurrent->time;
+   info->speed = SearchCurrent->speed;
+
+   for (size = 0; size < ApiPvSize && SearchBest->pv[size] != MoveNone; size++) {
+      info->pv[size] = SearchBest->pv[size];
+   }
+
+   info->pv_size = size;
+
+   Callback(info,CallbackData);
+}
+
+// send()
+
+void send(const char format[], ...) {
+
+   // no text output, the caller gets the search information from iteration()
+
+   ASSERT(format!=NULL);
+}
+
+}  // namespace engine
+
+// end of api.cpp
+
@@ -0,0 +1,91 @@
+/* api.h
+
+   GNU Chess engine
+
+   Copyright (C) 2001-2011 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// api.h
+
+// direct interface to the engine, for programs that link it as a library
+// (libgnuchess-engine) instead of talking UCI to it
+
+// the engine state is global: there is one engine per process, and all
+// the functions except api_stop() must be called from the same thread
+
+#ifndef API_H
+#define API_H
+
+namespace engine {
+
+// constants
+
+const int ApiPvSize = 256;
+
+const int ApiExact = 0; // score bounds
+const int ApiLower = 1;
+const int ApiUpper = 2;
+
+// types
+
+struct api_limit_t { // zero for no limit
+   int depth; // plies
+   double move_time; // seconds for this move
+   double time; // clock of the side to move, seconds
+   double inc; // increment per move, seconds
+   int moves_to_go;
+   bool infinite; // until api_stop()
+};
+
+struct api_info_t { // state of the search after an iteration
+   int depth;
+   int sel_depth;
+   int score; // centipawns, from the side to move
+   int mate; // mate in that many moves, negative if mated, 0 if none
+   int bound; // ApiExact, ApiLower or ApiUpper
+   long long node_nb;
+   double time; // seconds
+   double speed; // nodes per second
+   int pv_size;
+   int pv[ApiPvSize]; // see api_move_to_string()
+};
+
+typedef void (*api_callback_t) (const api_info_t * info, void * data);
+
+// functions
+
+extern void api_init            (); // once, before anything else
+
+extern bool api_set_option      (const char name[], const char value[]); // UCI options, false if unknown
+extern void api_new_game        ();
+
+extern bool api_set_position    (const char fen[], const char moves[]); // fen = NULL for the start position, false and unchanged if invalid
+extern bool api_play_move       (const char move[]); // coordinate notation, "e2e4"
+
+extern int  api_search          (const api_limit_t * limit, api_callback_t callback, void * data, int * ponder_move);
+extern void api_stop            (); // from any thread
+
+extern int  api_eval            (); // static evaluation of the position, from the side to move
+
+extern bool api_move_to_string  (int move, char string[], int size);
+
+}  // namespace engine
+
+#endif // !defined API_H
+
+// end of api.h
+
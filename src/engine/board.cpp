@@ -233,6 +233,15 @@ void board_copy(board_t * dst, const board_t * src) {
 
 void board_init_list(board_t * board) {
 
+   ASSERT(board!=NULL);
+
+   if (!board_try_init_list(board)) my_fatal("board_init_list(): illegal position\n");
+}
+
+// board_try_init_list()
+
+bool board_try_init_list(board_t * board) {
+
    int sq_64, sq, piece;
    int colour, pos;
    int i, size;
@@ -263,11 +272,11 @@ void board_init_list(board_t * board) {
 
          sq = SQUARE_FROM_64(sq_64);
          piece = board->square[sq];
-         if (piece != Empty && !piece_is_ok(piece)) my_fatal("board_init_list(): illegal position\n");
+         if (piece != Empty && !piece_is_ok(piece)) return false;
 
          if (COLOUR_IS(piece,colour) && !PIECE_IS_PAWN(piece)) {
 
-            if (pos >= 16) my_fatal("board_init_list(): illegal position\n");
+            if (pos >= 16) return false;
             ASSERT(pos>=0&&pos<16);
 
             board->pos[sq] = pos;
@@ -279,7 +288,7 @@ void board_init_list(board_t * board) {
          }
       }
 
-      if (board->number[COLOUR_IS_WHITE(colour)?WhiteKing12:BlackKing12] != 1) my_fatal("board_init_list(): illegal position\n");
+      if (board->number[COLOUR_IS_WHITE(colour)?WhiteKing12:BlackKing12] != 1) return false;
 
       ASSERT(pos>=1&&pos<=16);
       board->piece[colour][pos] = SquareNone;
@@ -341,7 +350,7 @@ void board_init_list(board_t * board) {
 
          if (COLOUR_IS(piece,colour) && PIECE_IS_PAWN(piece)) {
 
-            if (pos >= 8 || SQUARE_IS_PROMOTE(sq)) my_fatal("board_init_list(): illegal position\n");
+            if (pos >= 8 || SQUARE_IS_PROMOTE(sq)) return false;
             ASSERT(pos>=0&&pos<8);
 
             board->pos[sq] = pos;
@@ -358,7 +367,7 @@ void board_init_list(board_t * board) {
       board->pawn[colour][pos] = SquareNone;
       board->pawn_size[colour] = pos;
 
-      if (board->piece_size[colour] + board->pawn_size[colour] > 16) my_fatal("board_init_list(): illegal position\n");
+      if (board->piece_size[colour] + board->pawn_size[colour] > 16) return false;
    }
 
    // last square
@@ -372,6 +381,8 @@ void board_init_list(board_t * board) {
 
    // hash key
 
+   if (board->ply_nb >= StackSize) return false;
+
    for (i = 0; i < board->ply_nb; i++) board->stack[i] = 0; // HACK
    board->sp = board->ply_nb;
 
@@ -381,11 +392,13 @@ void board_init_list(board_t * board) {
 
    // legality
 
-   if (!board_is_legal(board)) my_fatal("board_init_list(): illegal position\n");
+   if (!board_is_legal(board)) return false;
 
    // debug
 
    ASSERT(board_is_ok(board));
+
+   return true;
 }
 
 // board_is_legal()
@@ -108,6 +108,7 @@ extern void board_clear         (board_t * board);
 extern void board_copy          (board_t * dst, const board_t * src);
 
 extern void board_init_list     (board_t * board);
+extern bool board_try_init_list (board_t * board); // false instead of fatal on an illegal position
 
 extern bool board_is_legal      (const board_t * board);
 extern bool board_is_check      (const board_t * board);
@@ -44,12 +44,44 @@ const char * const StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQk
 
 static const bool Strict = false;
 
+// prototypes
+
+static bool fen_parse (board_t * board, const char fen[], int * error);
+
 // functions
 
 // board_from_fen()
 
 void board_from_fen(board_t * board, const char fen[]) {
 
+   int pos;
+
+   ASSERT(board!=NULL);
+   ASSERT(fen!=NULL);
+
+   if (!fen_parse(board,fen,&pos)) my_fatal("board_from_fen(): bad FEN (pos=%d)\n",pos);
+
+   board_init_list(board);
+}
+
+// fen_is_ok()
+
+bool fen_is_ok(const char fen[]) {
+
+   board_t board[1];
+   int pos;
+
+   ASSERT(fen!=NULL);
+
+   if (!fen_parse(board,fen,&pos)) return false;
+
+   return board_try_init_list(board);
+}
+
+// fen_parse()
+
+static bool fen_parse(board_t * board, const char fen[], int * error) {
+
    int pos;
    int file, rank, sq;
    int c;
@@ -76,7 +108,7 @@ void board_from_fen(board_t * board, const char fen[]) {
             len = c - '0';
 
             for (i = 0; i < len; i++) {
-               if (file > FileH) my_fatal("board_from_fen(): bad FEN (pos=%d)\n",pos);
+               if (file > FileH) goto error;
                board->square[SQUARE_MAKE(file,rank)] = Empty;
                file++;
             }
@@ -84,7 +116,7 @@ void board_from_fen(board_t * board, const char fen[]) {
          } else { // piece
 
             piece = piece_from_char(c);
-            if (piece == PieceNone256) my_fatal("board_from_fen(): bad FEN (pos=%d)\n",pos);
+            if (piece == PieceNone256) goto error;
 
             board->square[SQUARE_MAKE(file,rank)] = piece;
             file++;
@@ -94,14 +126,14 @@ void board_from_fen(board_t * board, const char fen[]) {
       }
 
       if (rank > Rank1) {
-         if (c != '/') my_fatal("board_from_fen(): bad FEN (pos=%d)\n",pos);
+         if (c != '/') goto error;
          c = fen[++pos];
      }
    }
 
    // active colour
 
-   if (c != ' ') my_fatal("board_from_fen(): bad FEN (pos=%d)\n",pos);
+   if (c != ' ') goto error;
    c = fen[++pos];
 
    switch (c) {
@@ -112,7 +144,7 @@ void board_from_fen(board_t * board, const char fen[]) {
       board->turn = Black;
       break;
    default:
-      my_fatal("board_from_fen(): bad FEN (pos=%d)\n",pos);
+      goto error;
       break;
    }
 
@@ -120,7 +152,7 @@ void board_from_fen(board_t * board, const char fen[]) {
 
    // castling
 
-   if (c != ' ') my_fatal("board_from_fen(): bad FEN (pos=%d)\n",pos);
+   if (c != ' ') goto error;
    c = fen[++pos];
 
    board->flags = FlagsNone;
@@ -154,7 +186,7 @@ void board_from_fen(board_t * board, const char fen[]) {
 
    // en-passant
 
-   if (c != ' ') my_fatal("board_from_fen(): bad FEN (pos=%d)\n",pos);
+   if (c != ' ') goto error;
    c = fen[++pos];
 
    if (c == '-') { // no en-passant
@@ -164,11 +196,11 @@ void board_from_fen(board_t * board, const char fen[]) {
 
    } else {
 
-      if (c < 'a' || c > 'h') my_fatal("board_from_fen(): bad FEN (pos=%d)\n",pos);
+      if (c < 'a' || c > 'h') goto error;
       file = file_from_char(c);
       c = fen[++pos];
 
-      if (c != (COLOUR_IS_WHITE(board->turn) ? '6' : '3')) my_fatal("board_from_fen(): bad FEN (pos=%d)\n",pos);
+      if (c != (COLOUR_IS_WHITE(board->turn) ? '6' : '3')) goto error;
       rank = rank_from_char(c);
       c = fen[++pos];
 
@@ -190,22 +222,24 @@ void board_from_fen(board_t * board, const char fen[]) {
    board->ply_nb = 0;
 
    if (c != ' ') {
-      if (!Strict) goto update;
-      my_fatal("board_from_fen(): bad FEN (pos=%d)\n",pos);
+      if (!Strict) return true;
+      goto error;
    }
    c = fen[++pos];
 
    if (!isdigit(c)) {
-      if (!Strict) goto update;
-      my_fatal("board_from_fen(): bad FEN (pos=%d)\n",pos);
+      if (!Strict) return true;
+      goto error;
    }
 
    board->ply_nb = atoi(&fen[pos]);
 
-   // board update
+   return true;
 
-update:
-   board_init_list(board);
+error:
+
+   *error = pos;
+   return false;
 }
 
 // board_to_fen()
@@ -38,6 +38,7 @@ extern const char * const StartFen;
 // functions
 
 extern void board_from_fen (board_t * board, const char fen[]);
+extern bool fen_is_ok      (const char fen[]); // board_from_fen() would not be fatal
 extern bool board_to_fen   (const board_t * board, char fen[], int size);
 
 }  // namespace engine
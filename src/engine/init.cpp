@@ -0,0 +1,116 @@
+/* init.cpp
+
+   GNU Chess engine
+
+   Copyright (C) 2001-2011 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// init.cpp
+
+// includes
+
+#include "attack.h"
+#include "book.h"
+#include "eval.h"
+#include "hash.h"
+#include "init.h"
+#include "material.h"
+#include "move_do.h"
+#include "option.h"
+#include "pawn.h"
+#include "piece.h"
+#include "pst.h"
+#include "random.h"
+#include "square.h"
+#include "trans.h"
+#include "util.h"
+#include "value.h"
+#include "vector.h"
+
+namespace engine {
+
+// variables
+
+static bool Init;
+
+// functions
+
+// init_early()
+
+void init_early() {
+
+   Init = false;
+
+   my_random_init(); // for opening book
+
+   // early initialisation (the rest is done after the options are set)
+
+   option_init();
+
+   square_init();
+   piece_init();
+   pawn_init_bit();
+   value_init();
+   vector_init();
+   attack_init();
+   move_do_init();
+
+   random_init();
+   hash_init();
+
+   trans_init(Trans);
+   book_init();
+}
+
+// init_late()
+
+void init_late() {
+
+   if (!Init) {
+
+      // late initialisation
+
+      Init = true;
+
+      if (option_get_bool("OwnBook")) {
+         book_open(option_get_string("BookFile"));
+      }
+
+      trans_alloc(Trans);
+
+      pawn_init();
+      pawn_alloc();
+
+      material_init();
+      material_alloc();
+
+      pst_init();
+      eval_init();
+   }
+}
+
+// init_is_done()
+
+bool init_is_done() {
+
+   return Init;
+}
+
+}  // namespace engine
+
+// end of init.cpp
+
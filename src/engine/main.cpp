@@ -26,63 +26,21 @@
 #include <cstdio>
 #include <cstdlib>
 
-#include "attack.h"
-#include "book.h"
-#include "hash.h"
-#include "move_do.h"
-#include "option.h"
-#include "pawn.h"
-#include "piece.h"
+#include "init.h"
 #include "protocol.h"
-#include "random.h"
-#include "square.h"
-#include "trans.h"
 #include "util.h"
-#include "value.h"
-#include "vector.h"
-#include "components.h"
 
 namespace engine {
 
-// Streams used to communicate with the adapter
-
-FILE *pipefd_a2e_0_stream;
-FILE *pipefd_e2a_1_stream;
-
 // functions
 
 // main()
 
 int main_engine(int argc, char * argv[]) {
 
-   // Get reference stream of pipes to communicate with the adapter
-
-   pipefd_a2e_0_stream = fdopen( pipefd_a2e[0], "r" );
-   pipefd_e2a_1_stream = fdopen( pipefd_e2a[1], "w" );
-   setvbuf(pipefd_a2e_0_stream,NULL,_IONBF,0);
-   setvbuf(pipefd_e2a_1_stream,NULL,_IONBF,0); // _IOLBF breaks on Windows!
-
    // init
 
-   my_random_init(); // for opening book
-
-   // early initialisation (the rest is done after UCI options are parsed in protocol.cpp)
-
-   option_init();
-
-   square_init();
-   piece_init();
-   pawn_init_bit();
-   value_init();
-   vector_init();
-   attack_init();
-   move_do_init();
-
-   random_init();
-   hash_init();
-
-   trans_init(Trans);
-   book_init();
+   init_early();
 
    // loop
 
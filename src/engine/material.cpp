@@ -191,6 +191,17 @@ void material_get_info(material_info_t * info, const board_t * board) {
    }
 }
 
+// material_get_stats()
+
+void material_get_stats(sint64 * read_nb, sint64 * read_hit) {
+
+   ASSERT(read_nb!=NULL);
+   ASSERT(read_hit!=NULL);
+
+   *read_nb = Material->read_nb;
+   *read_hit = Material->read_hit;
+}
+
 // material_comp_info()
 
 static void material_comp_info(material_info_t * info, const board_t * board) {
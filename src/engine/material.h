@@ -79,6 +79,8 @@ extern void material_clear    ();
 
 extern void material_get_info (material_info_t * info, const board_t * board);
 
+extern void material_get_stats (sint64 * read_nb, sint64 * read_hit);
+
 }  // namespace engine
 
 #endif // !defined MATERIAL_H
@@ -27,6 +27,7 @@
 
 #include "option.h"
 #include "protocol.h"
+#include "trace.h"
 #include "util.h"
 
 namespace engine {
@@ -75,6 +76,13 @@ static option_t Option[] = {
    { "Pawn Structure",  true, "100", "spin", "min 0 max 400", NULL },
    { "Passed Pawns",    true, "100", "spin", "min 0 max 400", NULL },
 
+   { "Search Statistics", true, "false", "check", "", NULL },
+
+#ifdef SEARCH_TRACE
+   { "Trace File", true, "<empty>", "string", "", NULL },
+   { "Trace Size", true, "64",      "spin",   "min 1 max 4096", NULL },
+#endif
+
    { NULL, false, NULL, NULL, NULL, NULL, },
 };
 
@@ -284,6 +284,17 @@ void pawn_get_info(pawn_info_t * info, const board_t * board) {
    }
 }
 
+// pawn_get_stats()
+
+void pawn_get_stats(sint64 * read_nb, sint64 * read_hit) {
+
+   ASSERT(read_nb!=NULL);
+   ASSERT(read_hit!=NULL);
+
+   *read_nb = Pawn->read_nb;
+   *read_hit = Pawn->read_hit;
+}
+
 // pawn_comp_info()
 
 static void pawn_comp_info(pawn_info_t * info, const board_t * board) {
@@ -79,6 +79,8 @@ extern void pawn_clear    ();
 
 extern void pawn_get_info (pawn_info_t * info, const board_t * board);
 
+extern void pawn_get_stats (sint64 * read_nb, sint64 * read_hit);
+
 extern int  quad          (int y_min, int y_max, int x);
 
 }  // namespace engine
@@ -32,8 +32,6 @@ namespace engine {
 
 // functions
 
-extern bool   input_available ();
-
 extern double now_real        ();
 extern double now_cpu         ();
 
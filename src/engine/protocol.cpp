@@ -30,9 +30,9 @@
 #include <pthread.h>
 
 #include "board.h"
-#include "book.h"
-#include "eval.h"
+#include "components.h"
 #include "fen.h"
+#include "init.h"
 #include "material.h"
 #include "move.h"
 #include "move_do.h"
@@ -41,8 +41,8 @@
 #include "pawn.h"
 #include "posix.h"
 #include "protocol.h"
-#include "pst.h"
 #include "search.h"
+#include "trace.h"
 #include "trans.h"
 #include "util.h"
 #include "config.h"
@@ -51,31 +51,50 @@
 
 namespace engine {
 
-static const double NormalRatio = 1.0;
-static const double PonderRatio = 1.25;
+static const int MailboxSize = 256; // lines
 
 // variables
 
-static bool Init;
+std::atomic<bool> InputEvent;
 
-static bool Searching; // search in progress?
+static std::atomic<bool> Searching; // search in progress? (read by the input thread)
 static bool Infinite; // infinite or ponder mode?
 static bool Delay; // postpone "bestmove" in infinite/ponder mode?
 
+static char PositionString[65536]; // last "position" command, "" if none
+static board_t PositionBoard[1]; // the resulting board
+
 extern bool UseTrans;
 
-// Streams used for communication with the adapter
+// input thread -> engine thread mailbox
+
+static pthread_t InputThread;
+
+static pthread_mutex_t MailboxMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t MailboxCond = PTHREAD_COND_INITIALIZER;
+static char * Mailbox[MailboxSize]; // NULL = EOF
+static int MailboxHead;
+static std::atomic<int> MailboxNb;
+
+static std::atomic<double> StopTime; // when "stop" was read, 0.0 if none
 
-extern FILE *pipefd_a2e_0_stream;
-extern FILE *pipefd_e2a_1_stream;
+static std::atomic<int> StopReadNb; // "stop" commands read by the input thread
+static std::atomic<int> StopDoneNb; // ... of which answered by the engine thread
+static int StopNb; // "stop" commands taken from the mailbox
+
+static pthread_mutex_t SendMutex = PTHREAD_MUTEX_INITIALIZER;
 
 // prototypes
 
-static void init              ();
 static void loop_step         ();
 
+static void * input_thread    (void * arg);
+static void mailbox_put       (char * string);
+static bool input_available   ();
+
 static void parse_go          (char string[]);
 static void parse_position    (char string[]);
+static void parse_moves       (const char string[]);
 static void parse_setoption   (char string[]);
 
 static void send_best_move    ();
@@ -91,8 +110,6 @@ void loop() {
 
    // init (to help debugging)
 
-   Init = false;
-
    Searching = false;
    Infinite = false;
    Delay = false;
@@ -101,43 +118,107 @@ void loop() {
 
    board_from_fen(SearchInput->board,StartFen);
 
+   PositionString[0] = '\0';
+
+   // input
+
+   InputEvent = false;
+   MailboxHead = 0;
+   MailboxNb = 0;
+   StopTime = 0.0;
+
+   StopReadNb = 0;
+   StopDoneNb = 0;
+   StopNb = 0;
+
+   if (pthread_create(&InputThread,NULL,input_thread,NULL) != 0) {
+      my_fatal("loop(): pthread_create(): failed\n");
+   }
+
+   pthread_detach(InputThread);
+
    // loop
 
    while (true) loop_step();
 }
 
-// init()
+// event()
+
+void event() {
 
-static void init() {
+   InputEvent = false;
+
+   while (!SearchInfo->stop && input_available()) loop_step();
+}
 
-   if (!Init) {
+// iteration()
 
-      // late initialisation
+void iteration() {
+
+   // nothing to do, search() has sent the "info" line
+}
+
+// input_thread()
+
+static void * input_thread(void * arg) {
+
+   char string[65536];
+   bool eof;
 
-      Init = true;
+   // reads the adapter queue so that the search never polls it;
+   // commands are handled by the engine thread in event() or loop(),
+   // except "isready" during a search with nothing queued ahead of it
+   // and no "stop" waiting for its "bestmove", which is answered at once
 
-      if (option_get_bool("OwnBook")) {
-         book_open(option_get_string("BookFile"));
+   while (true) {
+
+      eof = !queue_get_line(queue_a2e,string,65536);
+
+      if (eof) {
+         mailbox_put(NULL);
+         break;
       }
 
-      trans_alloc(Trans);
+      if (string_equal(string,"isready") && StopDoneNb == StopReadNb && Searching && MailboxNb == 0) {
+         send("readyok"); // no need to wait when searching (dixit SMK)
+         continue;
+      }
 
-      pawn_init();
-      pawn_alloc();
+      if (string_equal(string,"stop")) {
+         StopTime = now_real();
+         StopReadNb++;
+      }
 
-      material_init();
-      material_alloc();
+      mailbox_put(my_strdup(string));
 
-      pst_init();
-      eval_init();
+      if (string_equal(string,"quit")) break;
    }
+
+   return NULL;
 }
 
-// event()
+// mailbox_put()
 
-void event() {
+static void mailbox_put(char * string) {
 
-   while (!SearchInfo->stop && input_available()) loop_step();
+   pthread_mutex_lock(&MailboxMutex);
+
+   while (MailboxNb >= MailboxSize) pthread_cond_wait(&MailboxCond,&MailboxMutex);
+
+   Mailbox[(MailboxHead+MailboxNb)%MailboxSize] = string;
+   MailboxNb++;
+
+   pthread_cond_broadcast(&MailboxCond);
+   pthread_mutex_unlock(&MailboxMutex);
+
+   InputEvent = true;
+}
+
+// input_available()
+
+static bool input_available() {
+
+   return MailboxNb > 0;
 }
 
 // loop_step()
@@ -161,7 +242,7 @@ static void loop_step() {
    } else if (string_start_with(string,"go ")) {
 
       if (!Searching && !Delay) {
-         init();
+         init_late();
          parse_go(string);
       } else {
          ASSERT(false);
@@ -170,7 +251,7 @@ static void loop_step() {
    } else if (string_equal(string,"isready")) {
 
       if (!Searching && !Delay) {
-         init();
+         init_late();
       }
 
       send("readyok"); // no need to wait when searching (dixit SMK)
@@ -197,7 +278,7 @@ static void loop_step() {
    } else if (string_start_with(string,"position ")) {
 
       if (!Searching && !Delay) {
-         init();
+         init_late();
          parse_position(string);
       } else {
          ASSERT(false);
@@ -221,6 +302,8 @@ static void loop_step() {
 
    } else if (string_equal(string,"stop")) {
 
+      StopNb++;
+
       if (Searching) {
 
          SearchInfo->stop = true;
@@ -230,6 +313,10 @@ static void loop_step() {
 
          send_best_move();
          Delay = false;
+
+      } else {
+
+         StopDoneNb = StopNb; // nothing to stop
       }
 
    } else if (string_equal(string,"uci")) {
@@ -246,7 +333,7 @@ static void loop_step() {
 
    } else if (string_equal(string,"ucinewgame")) {
 
-      if (!Searching && !Delay && Init) {
+      if (!Searching && !Delay && init_is_done()) {
          trans_clear(Trans);
       } else {
          ASSERT(false);
@@ -273,7 +360,6 @@ static void parse_go(char string[]) {
    sint64 nodes;
    double binc, btime, movetime, winc, wtime;
    double time, inc;
-   double time_max, alloc;
 
    // init
 
@@ -410,36 +496,7 @@ static void parse_go(char string[]) {
       inc = binc;
    }
 
-   if (movestogo <= 0 || movestogo > 30) movestogo = 30; // HACK
-   if (inc < 0.0) inc = 0.0;
-
-   if (movetime >= 0.0) {
-
-      // fixed time
-
-      SearchInput->time_is_limited = true;
-      SearchInput->time_limit_1 = movetime * 5.0; // HACK to avoid early exit
-      SearchInput->time_limit_2 = movetime;
-
-   } else if (time >= 0.0) {
-
-      // dynamic allocation
-
-      time_max = time * 0.95 - 1.0;
-      if (time_max < 0.0) time_max = 0.0;
-
-      SearchInput->time_is_limited = true;
-
-      alloc = (time_max + inc * double(movestogo-1)) / double(movestogo);
-      alloc *= (option_get_bool("Ponder") ? PonderRatio : NormalRatio);
-      if (alloc > time_max) alloc = time_max;
-      SearchInput->time_limit_1 = alloc;
-
-      alloc = (time_max + inc * double(movestogo-1)) * 0.5;
-      if (alloc < SearchInput->time_limit_1) alloc = SearchInput->time_limit_1;
-      if (alloc > time_max) alloc = time_max;
-      SearchInput->time_limit_2 = alloc;
-   }
+   search_set_time(movetime,time,inc,movestogo);
 
    if (infinite || ponder) SearchInput->infinite = true;
 
@@ -454,6 +511,7 @@ static void parse_go(char string[]) {
 
    search();
    search_update_current();
+   trace_flush();
 
    ASSERT(Searching);
    ASSERT(!Delay);
@@ -471,9 +529,45 @@ static void parse_position(char string[]) {
    const char * fen;
    char * moves;
    const char * ptr;
-   char move_string[256];
-   int move;
-   undo_t undo[1];
+   int len;
+
+   // same position with some more moves?
+
+   len = int(strlen(PositionString));
+
+   if (len != 0 && strncmp(string,PositionString,len) == 0) {
+
+      ptr = string + len;
+
+      if (strstr(PositionString,"moves ") == NULL) {
+         if (*ptr == '\0') {
+            ptr = NULL;
+         } else if (strncmp(ptr," moves ",7) == 0) {
+            ptr += 7;
+         } else {
+            ptr = NULL;
+            len = 0;
+         }
+      } else if (*ptr != '\0' && *ptr != ' ') { // last move differs
+         len = 0;
+      }
+
+      if (len != 0) {
+
+         board_copy(SearchInput->board,PositionBoard);
+
+         if (ptr != NULL) {
+            while (*ptr == ' ') ptr++;
+            parse_moves(ptr);
+            board_copy(PositionBoard,SearchInput->board);
+            strcpy(PositionString,string);
+         }
+
+         return;
+      }
+   }
+
+   strcpy(PositionString,string);
 
    // init
 
@@ -501,31 +595,46 @@ static void parse_position(char string[]) {
    // moves
 
    if (moves != NULL) { // "moves" present
+      parse_moves(moves+6);
+   }
+
+   board_copy(PositionBoard,SearchInput->board);
+}
 
-      ptr = moves + 6;
+// parse_moves()
 
-      while (*ptr != '\0') {
+static void parse_moves(const char string[]) {
 
-         move_string[0] = *ptr++;
-         move_string[1] = *ptr++;
-         move_string[2] = *ptr++;
-         move_string[3] = *ptr++;
+   const char * ptr;
+   char move_string[256];
+   int move;
+   undo_t undo[1];
 
-         if (*ptr == '\0' || *ptr == ' ') {
-            move_string[4] = '\0';
-         } else { // promote
-            move_string[4] = *ptr++;
-            move_string[5] = '\0';
-         }
+   ASSERT(string!=NULL);
 
-         move = move_from_string(move_string,SearchInput->board);
+   ptr = string;
 
-         if (move == MoveNone) my_fatal("parse_position(): invalid move:%s\n",move_string);
+   while (*ptr != '\0') {
 
-         move_do(SearchInput->board,move,undo);
+      move_string[0] = *ptr++;
+      move_string[1] = *ptr++;
+      move_string[2] = *ptr++;
+      move_string[3] = *ptr++;
 
-         while (*ptr == ' ') ptr++;
+      if (*ptr == '\0' || *ptr == ' ') {
+         move_string[4] = '\0';
+      } else { // promote
+         move_string[4] = *ptr++;
+         move_string[5] = '\0';
       }
+
+      move = move_from_string(move_string,SearchInput->board);
+
+      if (move == MoveNone) my_fatal("parse_position(): invalid move:%s\n",move_string);
+
+      move_do(SearchInput->board,move,undo);
+
+      while (*ptr == ' ') ptr++;
    }
 }
 
@@ -553,7 +662,7 @@ static void parse_setoption(char string[]) {
 
    // update transposition-table size if needed
 
-   if (Init && my_string_equal(name,"Hash")) { // Init => already allocated
+   if (init_is_done() && my_string_equal(name,"Hash")) { // already allocated
 
       ASSERT(!Searching);
 
@@ -590,6 +699,13 @@ static void send_best_move() {
    // pawn_stats();
    // material_stats();
 
+   if (option_get_bool("Search Statistics")) {
+      search_stats();
+      if (StopTime > 0.0) send("info string stop latency %.2f ms",(now_real()-StopTime)*1000.0);
+   }
+
+   StopTime = 0.0;
+
    // best move
 
    move = SearchBest->move;
@@ -603,18 +719,40 @@ static void send_best_move() {
    } else {
       send("bestmove %s",move_string);
    }
+
+   StopDoneNb = StopNb; // the pending "stop" commands are answered
 }
 
 // get()
 
 void get(char string[], int size) {
 
+   char * line;
+
    ASSERT(string!=NULL);
    ASSERT(size>=65536);
 
-   if (!my_file_read_line(pipefd_a2e_0_stream,string,size)) { // EOF
+   // wait for the input thread
+
+   pthread_mutex_lock(&MailboxMutex);
+
+   while (MailboxNb == 0) pthread_cond_wait(&MailboxCond,&MailboxMutex);
+
+   line = Mailbox[MailboxHead];
+   MailboxHead = (MailboxHead + 1) % MailboxSize;
+   MailboxNb--;
+
+   pthread_cond_broadcast(&MailboxCond);
+   pthread_mutex_unlock(&MailboxMutex);
+
+   if (line == NULL) { // EOF
       exit(EXIT_SUCCESS);
    }
+
+   strncpy(string,line,size-1);
+   string[size-1] = '\0';
+
+   my_free(line);
 }
 
 // send()
@@ -623,14 +761,22 @@ void send(const char format[], ...) {
 
    va_list arg_list;
    char string[4096];
+   int len;
 
    ASSERT(format!=NULL);
 
    va_start(arg_list,format);
-   vsprintf(string,format,arg_list);
+   len = vsnprintf(string,4095,format,arg_list);
    va_end(arg_list);
 
-   fprintf(pipefd_e2a_1_stream,"%s\n",string);
+   if (len < 0 || len > 4094) len = 4094;
+   string[len++] = '\n';
+
+   // the input thread answers "isready" itself
+
+   pthread_mutex_lock(&SendMutex);
+   queue_write(queue_e2a,string,len);
+   pthread_mutex_unlock(&SendMutex);
 }
 
 // string_equal()
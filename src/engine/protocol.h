@@ -26,17 +26,24 @@
 
 // includes
 
+#include <atomic>
+
 #include "util.h"
 
 namespace engine {
 
+// variables
+
+extern std::atomic<bool> InputEvent; // a command arrived, checked at every node
+
 // functions
 
-extern void loop  ();
-extern void event ();
+extern void loop      ();
+extern void event     ();
+extern void iteration ();
 
-extern void get   (char string[], int size);
-extern void send  (const char format[], ...);
+extern void get       (char string[], int size);
+extern void send      (const char format[], ...);
 
 }  // namespace engine
 
@@ -41,6 +41,7 @@
 #include "search.h"
 #include "search_full.h"
 #include "sort.h"
+#include "trace.h"
 #include "trans.h"
 #include "util.h"
 #include "value.h"
@@ -72,6 +73,44 @@ static const bool UseBad = true;
 static const int BadThreshold = 50; // 50
 static const bool UseExtension = true;
 
+static const bool UseTimeScale = true; // rescale the soft limit after each iteration
+static const double InstabilityDecay = 0.5;
+static const double InstabilityScale = 0.4; // per best-move change
+static const int StableDepth = 4; // iterations with the same best move
+static const double StableRatio = 0.7;
+static const int DropThreshold = 30;
+static const int DropMax = 150;
+static const double DropScale = 1.0; // at DropMax
+static const int FewMoveNb = 4;
+static const double FewMoveRatio = 0.6;
+static const double TimeFactorMin = 0.4;
+static const double TimeFactorMax = 3.0;
+
+static const bool UsePredict = true; // don't start an iteration that can't complete
+static const double BranchRatioMin = 1.5;
+static const double BranchRatioMax = 6.0;
+static const double BranchRatioDefault = 3.0;
+
+// time allocation in search_set_time()
+
+static const double NormalRatio = 1.0;
+static const double PonderRatio = 1.25;
+
+// stop reasons
+
+static const int StopNone    = 0;
+static const int StopDepth   = 1;
+static const int StopSoft    = 2;
+static const int StopEasy    = 3;
+static const int StopEarly   = 4;
+static const int StopPredict = 5;
+static const int StopHard    = 6;
+static const int StopUser    = 7;
+
+static const char * const StopString[] = {
+   "none", "depth", "soft", "easy", "early", "predict", "hard", "stop",
+};
+
 // variables
 
 search_input_t SearchInput[1];
@@ -79,10 +118,16 @@ search_info_t SearchInfo[1];
 search_root_t SearchRoot[1];
 search_current_t SearchCurrent[1];
 search_best_t SearchBest[1];
+search_stat_t SearchStat[1];
 
 // prototypes
 
 static void search_send_stat ();
+static void search_stat_clear ();
+static void search_time_update ();
+static void search_set_flag    (int reason);
+
+static double percent         (sint64 part, sint64 total);
 
 // functions
 
@@ -110,6 +155,8 @@ void search_clear() {
    SearchInput->depth_is_limited = false;
    SearchInput->depth_limit = 0;
    SearchInput->time_is_limited = false;
+   SearchInput->time_is_dynamic = false;
+   SearchInput->time_limit_0 = 0.0;
    SearchInput->time_limit_1 = 0.0;
    SearchInput->time_limit_2 = 0.0;
 
@@ -140,6 +187,14 @@ void search_clear() {
    SearchRoot->change = false;
    SearchRoot->easy = false;
    SearchRoot->flag = false;
+   SearchRoot->best_move = MoveNone;
+   SearchRoot->change_nb = 0;
+   SearchRoot->stable_nb = 0;
+   SearchRoot->instability = 0.0;
+   SearchRoot->time_factor = 1.0;
+   SearchRoot->iter_time = 0.0;
+   SearchRoot->last_iter_time = 0.0;
+   SearchRoot->predicted_time = 0.0;
 
    // SearchCurrent
 
@@ -148,6 +203,77 @@ void search_clear() {
    SearchCurrent->time = 0.0;
    SearchCurrent->speed = 0.0;
    SearchCurrent->cpu = 0.0;
+
+   // SearchStat
+
+   search_stat_clear();
+}
+
+// search_stat_clear()
+
+static void search_stat_clear() {
+
+   SearchStat->trans_probe_nb = 0;
+   SearchStat->trans_hit_nb = 0;
+   SearchStat->trans_cut_nb = 0;
+   SearchStat->qs_node_nb = 0;
+   SearchStat->cut_nb = 0;
+   SearchStat->cut_first_nb = 0;
+   SearchStat->null_nb = 0;
+   SearchStat->null_cut_nb = 0;
+   SearchStat->history_nb = 0;
+   SearchStat->history_research_nb = 0;
+   SearchStat->research_nb = 0;
+   SearchStat->stop_reason = StopNone;
+   SearchStat->stop_depth = 0;
+
+   // the pawn and material tables are shared across searches
+
+   pawn_get_stats(&SearchStat->pawn_read_nb,&SearchStat->pawn_read_hit);
+   material_get_stats(&SearchStat->material_read_nb,&SearchStat->material_read_hit);
+}
+
+// search_set_time()
+
+void search_set_time(double movetime, double time, double inc, int movestogo) {
+
+   double time_max, alloc;
+
+   // negative values are not set
+
+   if (movestogo <= 0 || movestogo > 30) movestogo = 30; // HACK
+   if (inc < 0.0) inc = 0.0;
+
+   if (movetime >= 0.0) {
+
+      // fixed time
+
+      SearchInput->time_is_limited = true;
+      SearchInput->time_limit_0 = movetime * 5.0; // HACK to avoid early exit
+      SearchInput->time_limit_1 = movetime * 5.0;
+      SearchInput->time_limit_2 = movetime;
+
+   } else if (time >= 0.0) {
+
+      // dynamic allocation
+
+      time_max = time * 0.95 - 1.0;
+      if (time_max < 0.0) time_max = 0.0;
+
+      SearchInput->time_is_limited = true;
+      SearchInput->time_is_dynamic = true;
+
+      alloc = (time_max + inc * double(movestogo-1)) / double(movestogo);
+      alloc *= (option_get_bool("Ponder") ? PonderRatio : NormalRatio);
+      if (alloc > time_max) alloc = time_max;
+      SearchInput->time_limit_0 = alloc;
+      SearchInput->time_limit_1 = alloc; // rescaled by search() after each iteration
+
+      alloc = (time_max + inc * double(movestogo-1)) * 0.5;
+      if (alloc < SearchInput->time_limit_1) alloc = SearchInput->time_limit_1;
+      if (alloc > time_max) alloc = time_max;
+      SearchInput->time_limit_2 = alloc;
+   }
 }
 
 // search()
@@ -156,6 +282,7 @@ void search() {
 
    int move;
    int depth;
+   double start_time;
 
    ASSERT(board_is_ok(SearchInput->board));
 
@@ -214,6 +341,8 @@ void search() {
 
    trans_inc_date(Trans);
 
+   trace_start();
+
    sort_init();
    search_full_init(SearchRoot->list,SearchCurrent->board);
 
@@ -223,8 +352,13 @@ void search() {
 
       if (DispDepthStart) send("info depth %d",depth);
 
+      TRACE_MARK(TraceIteration,depth);
+
       SearchRoot->bad_1 = false;
       SearchRoot->change = false;
+      SearchRoot->change_nb = 0;
+
+      start_time = SearchCurrent->time;
 
       board_copy(SearchCurrent->board,SearchInput->board);
 
@@ -240,6 +374,8 @@ void search() {
          send("info depth %d seldepth %d time %.0f nodes " S64_FORMAT " nps %.0f",depth,SearchCurrent->max_depth,SearchCurrent->time*1000.0,SearchCurrent->node_nb,SearchCurrent->speed);
       }
 
+      iteration();
+
       // update search info
 
       if (depth >= 1) SearchInfo->can_stop = true;
@@ -256,19 +392,26 @@ void search() {
          ASSERT(SearchRoot->bad_2==(SearchBest->value<=SearchRoot->last_value-BadThreshold));
       }
 
+      // time management
+
+      SearchRoot->last_iter_time = SearchRoot->iter_time;
+      SearchRoot->iter_time = SearchCurrent->time - start_time;
+
+      search_time_update();
+
       SearchRoot->last_value = SearchBest->value;
 
       // stop search?
 
       if (SearchInput->depth_is_limited
        && depth >= SearchInput->depth_limit) {
-         SearchRoot->flag = true;
+         search_set_flag(StopDepth);
       }
 
       if (SearchInput->time_is_limited
        && SearchCurrent->time >= SearchInput->time_limit_1
        && !SearchRoot->bad_2) {
-         SearchRoot->flag = true;
+         search_set_flag(StopSoft);
       }
 
       if (UseEasy
@@ -277,7 +420,7 @@ void search() {
        && SearchRoot->easy) {
          ASSERT(!SearchRoot->bad_2);
          ASSERT(!SearchRoot->change);
-         SearchRoot->flag = true;
+         search_set_flag(StopEasy);
       }
 
       if (UseEarly
@@ -285,11 +428,20 @@ void search() {
        && SearchCurrent->time >= SearchInput->time_limit_1 * EarlyRatio
        && !SearchRoot->bad_2
        && !SearchRoot->change) {
-         SearchRoot->flag = true;
+         search_set_flag(StopEarly);
+      }
+
+      if (UsePredict
+       && SearchInput->time_is_dynamic
+       && depth > 1
+       && SearchCurrent->time + SearchRoot->predicted_time > SearchInput->time_limit_2
+       && !SearchRoot->bad_2) {
+         search_set_flag(StopPredict);
       }
 
       if (SearchInfo->can_stop
        && (SearchInfo->stop || (SearchRoot->flag && !SearchInput->infinite))) {
+         if (SearchInfo->stop) search_set_flag(StopUser);
          break;
       }
    }
@@ -355,6 +507,11 @@ void search_update_best() {
 
    // update time-management info
 
+   if (SearchBest->move != SearchRoot->best_move) {
+      if (SearchRoot->best_move != MoveNone && SearchBest->depth > 1) SearchRoot->change_nb++;
+      SearchRoot->best_move = SearchBest->move;
+   }
+
    if (UseBad && SearchBest->depth > 1) {
       if (SearchBest->value <= SearchRoot->last_value - BadThreshold) {
          SearchRoot->bad_1 = true;
@@ -425,12 +582,12 @@ void search_check() {
 
    if (SearchInput->depth_is_limited
     && SearchRoot->depth > SearchInput->depth_limit) {
-      SearchRoot->flag = true;
+      search_set_flag(StopDepth);
    }
 
    if (SearchInput->time_is_limited
     && SearchCurrent->time >= SearchInput->time_limit_2) {
-      SearchRoot->flag = true;
+      search_set_flag(StopHard);
    }
 
    if (SearchInput->time_is_limited
@@ -438,15 +595,151 @@ void search_check() {
     && !SearchRoot->bad_1
     && !SearchRoot->bad_2
     && (!UseExtension || SearchRoot->move_pos == 0)) {
-      SearchRoot->flag = true;
+      search_set_flag(StopSoft);
    }
 
    if (SearchInfo->can_stop
     && (SearchInfo->stop || (SearchRoot->flag && !SearchInput->infinite))) {
+      if (SearchInfo->stop) search_set_flag(StopUser);
       longjmp(SearchInfo->buf,1);
    }
 }
 
+// search_time_update()
+
+static void search_time_update() {
+
+   double factor, ratio, limit;
+   int drop;
+
+   // best-move stability
+
+   SearchRoot->instability = SearchRoot->instability * InstabilityDecay + double(SearchRoot->change_nb);
+
+   if (SearchRoot->change_nb == 0) {
+      SearchRoot->stable_nb++;
+   } else {
+      SearchRoot->stable_nb = 0;
+   }
+
+   // next-iteration prediction (effective branching factor)
+
+   if (SearchRoot->last_iter_time > 0.0) {
+      ratio = SearchRoot->iter_time / SearchRoot->last_iter_time;
+      if (ratio < BranchRatioMin) ratio = BranchRatioMin;
+      if (ratio > BranchRatioMax) ratio = BranchRatioMax;
+   } else {
+      ratio = BranchRatioDefault;
+   }
+
+   SearchRoot->predicted_time = SearchRoot->iter_time * ratio;
+
+   if (!UseTimeScale || !SearchInput->time_is_dynamic) return;
+
+   // soft-limit scaling
+
+   factor = 1.0 + InstabilityScale * SearchRoot->instability;
+
+   if (SearchRoot->stable_nb >= StableDepth) factor *= StableRatio;
+
+   drop = SearchRoot->last_value - SearchBest->value;
+
+   if (SearchBest->depth > 1 && drop >= DropThreshold) {
+      if (drop > DropMax) drop = DropMax;
+      factor *= 1.0 + DropScale * double(drop) / double(DropMax);
+   }
+
+   if (LIST_SIZE(SearchRoot->list) <= FewMoveNb) factor *= FewMoveRatio;
+
+   if (factor < TimeFactorMin) factor = TimeFactorMin;
+   if (factor > TimeFactorMax) factor = TimeFactorMax;
+
+   limit = SearchInput->time_limit_0 * factor;
+   if (limit > SearchInput->time_limit_2) limit = SearchInput->time_limit_2;
+
+   SearchRoot->time_factor = factor;
+   SearchInput->time_limit_1 = limit;
+}
+
+// search_set_flag()
+
+static void search_set_flag(int reason) {
+
+   ASSERT(reason>StopNone&&reason<=StopUser);
+
+   if (!SearchRoot->flag || SearchStat->stop_reason == StopNone || reason == StopUser) {
+      SearchStat->stop_reason = reason;
+      SearchStat->stop_depth = SearchRoot->depth;
+   }
+
+   SearchRoot->flag = true;
+}
+
+// search_stats()
+
+void search_stats() {
+
+   sint64 node_nb;
+   sint64 pawn_read_nb, pawn_read_hit;
+   sint64 material_read_nb, material_read_hit;
+
+   node_nb = SearchCurrent->node_nb;
+
+   pawn_get_stats(&pawn_read_nb,&pawn_read_hit);
+   pawn_read_nb -= SearchStat->pawn_read_nb;
+   pawn_read_hit -= SearchStat->pawn_read_hit;
+
+   material_get_stats(&material_read_nb,&material_read_hit);
+   material_read_nb -= SearchStat->material_read_nb;
+   material_read_hit -= SearchStat->material_read_hit;
+
+   send("info string trans probes " S64_FORMAT " hits %.1f%% cuts %.1f%%",
+        SearchStat->trans_probe_nb,
+        percent(SearchStat->trans_hit_nb,SearchStat->trans_probe_nb),
+        percent(SearchStat->trans_cut_nb,SearchStat->trans_probe_nb));
+
+   send("info string nodes " S64_FORMAT " qsearch %.1f%% fail-high " S64_FORMAT " first %.1f%% re-searches " S64_FORMAT,
+        node_nb,
+        percent(SearchStat->qs_node_nb,node_nb),
+        SearchStat->cut_nb,
+        percent(SearchStat->cut_first_nb,SearchStat->cut_nb),
+        SearchStat->research_nb);
+
+   send("info string null-move " S64_FORMAT " success %.1f%% history-pruning " S64_FORMAT " success %.1f%%",
+        SearchStat->null_nb,
+        percent(SearchStat->null_cut_nb,SearchStat->null_nb),
+        SearchStat->history_nb,
+        percent(SearchStat->history_nb-SearchStat->history_research_nb,SearchStat->history_nb));
+
+   send("info string pawn-table hits %.1f%% material-table hits %.1f%%",
+        percent(pawn_read_hit,pawn_read_nb),
+        percent(material_read_hit,material_read_nb));
+
+   if (SearchInput->time_is_limited) {
+      send("info string time soft %.0f (base %.0f factor %.2f) hard %.0f used %.0f last-iteration %.0f predicted %.0f stop %s depth %d",
+           SearchInput->time_limit_1*1000.0,
+           SearchInput->time_limit_0*1000.0,
+           SearchRoot->time_factor,
+           SearchInput->time_limit_2*1000.0,
+           SearchCurrent->time*1000.0,
+           SearchRoot->iter_time*1000.0,
+           SearchRoot->predicted_time*1000.0,
+           StopString[SearchStat->stop_reason],
+           SearchStat->stop_depth);
+   } else {
+      send("info string stop %s depth %d",StopString[SearchStat->stop_reason],SearchStat->stop_depth);
+   }
+}
+
+// percent()
+
+static double percent(sint64 part, sint64 total) {
+
+   if (total == 0) return 0.0;
+
+   return double(part) * 100.0 / double(total);
+}
+
 // search_send_stat()
 
 static void search_send_stat() {
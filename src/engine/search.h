@@ -57,8 +57,10 @@ struct search_input_t {
    bool depth_is_limited;
    int depth_limit;
    bool time_is_limited;
-   double time_limit_1;
-   double time_limit_2;
+   bool time_is_dynamic;
+   double time_limit_0; // unscaled soft limit
+   double time_limit_1; // soft limit, rescaled after each iteration
+   double time_limit_2; // hard limit
 };
 
 struct search_info_t {
@@ -82,6 +84,14 @@ struct search_root_t {
    bool change;
    bool easy;
    bool flag;
+   int best_move;
+   int change_nb;
+   int stable_nb;
+   double instability;
+   double time_factor;
+   double iter_time;
+   double last_iter_time;
+   double predicted_time;
 };
 
 struct search_best_t {
@@ -92,6 +102,26 @@ struct search_best_t {
    mv_t pv[HeightMax];
 };
 
+struct search_stat_t {
+   sint64 trans_probe_nb;
+   sint64 trans_hit_nb;
+   sint64 trans_cut_nb;
+   sint64 qs_node_nb;
+   sint64 cut_nb;
+   sint64 cut_first_nb;
+   sint64 null_nb;
+   sint64 null_cut_nb;
+   sint64 history_nb;
+   sint64 history_research_nb;
+   sint64 research_nb;
+   sint64 pawn_read_nb;
+   sint64 pawn_read_hit;
+   sint64 material_read_nb;
+   sint64 material_read_hit;
+   int stop_reason;
+   int stop_depth;
+};
+
 struct search_current_t {
    board_t board[1];
    my_timer_t timer[1];
@@ -109,6 +139,7 @@ extern search_info_t SearchInfo[1];
 extern search_best_t SearchBest[1];
 extern search_root_t SearchRoot[1];
 extern search_current_t SearchCurrent[1];
+extern search_stat_t SearchStat[1];
 
 // functions
 
@@ -116,6 +147,7 @@ extern bool depth_is_ok           (int depth);
 extern bool height_is_ok          (int height);
 
 extern void search_clear          ();
+extern void search_set_time       (double movetime, double time, double inc, int movestogo);
 extern void search                ();
 
 extern void search_update_best    ();
@@ -124,6 +156,8 @@ extern void search_update_current ();
 
 extern void search_check          ();
 
+extern void search_stats          ();
+
 }  // namespace engine
 
 #endif // !defined SEARCH_H
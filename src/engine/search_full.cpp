@@ -33,6 +33,7 @@
 #include "move_do.h"
 #include "option.h"
 #include "piece.h"
+#include "protocol.h"
 #include "pst.h"
 #include "pv.h"
 #include "recog.h"
@@ -40,6 +41,7 @@
 #include "search_full.h"
 #include "see.h"
 #include "sort.h"
+#include "trace.h"
 #include "trans.h"
 #include "util.h"
 #include "value.h"
@@ -302,6 +304,7 @@ static int full_root(list_t * list, board_t * board, int alpha, int beta, int de
       } else { // other moves
          value = -full_search(board,-alpha-1,-alpha,new_depth,height+1,new_pv,NodeCut);
          if (value > alpha) { // && value < beta
+            SearchStat->research_nb++;
             SearchRoot->change = true;
             SearchRoot->easy = false;
             SearchRoot->flag = false;
@@ -403,14 +406,19 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
 
    if (height > SearchCurrent->max_depth) SearchCurrent->max_depth = height;
 
-   if (SearchInfo->check_nb <= 0) {
-      SearchInfo->check_nb += SearchInfo->check_inc;
+   TRACE_ENTER(TraceEnter,depth,height,alpha,beta);
+
+   if (SearchInfo->check_nb <= 0 || InputEvent.load(std::memory_order_relaxed)) {
+      SearchInfo->check_nb = SearchInfo->check_inc; // not +=, an input event can trigger the check early
       search_check();
    }
 
    // draw?
 
-   if (board_is_repetition(board) || recog_draw(board)) return ValueDraw;
+   if (board_is_repetition(board) || recog_draw(board)) {
+      TRACE_EXIT(height,ValueDraw,MoveNone,TraceReasonDraw);
+      return ValueDraw;
+   }
 
    // mate-distance pruning
 
@@ -423,7 +431,10 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
 
       if (value > alpha) {
          alpha = value;
-         if (value >= beta) return value;
+         if (value >= beta) {
+            TRACE_EXIT(height,value,MoveNone,TraceReasonMate);
+            return value;
+         }
       }
 
       // upper bound
@@ -432,7 +443,10 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
 
       if (value < beta) {
          beta = value;
-         if (value <= alpha) return value;
+         if (value <= alpha) {
+            TRACE_EXIT(height,value,MoveNone,TraceReasonMate);
+            return value;
+         }
       }
    }
 
@@ -442,10 +456,14 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
 
    if (UseTrans && depth >= TransDepth) {
 
+      SearchStat->trans_probe_nb++;
+
       if (trans_retrieve(Trans,board->key,&trans_move,&trans_min_depth,&trans_max_depth,&trans_min_value,&trans_max_value)) {
 
          // trans_move is now updated
 
+         SearchStat->trans_hit_nb++;
+
          if (node_type != NodePV) {
 
             if (UseMateValues) {
@@ -463,24 +481,40 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
 
             if (DEPTH_MATCH(trans_min_depth,depth)) {
                min_value = value_from_trans(trans_min_value,height);
-               if (min_value >= beta) return min_value;
+               if (min_value >= beta) {
+                  SearchStat->trans_cut_nb++;
+                  TRACE_EXIT(height,min_value,trans_move,TraceReasonTrans);
+                  return min_value;
+               }
             }
 
             max_value = +ValueInf;
 
             if (DEPTH_MATCH(trans_max_depth,depth)) {
                max_value = value_from_trans(trans_max_value,height);
-               if (max_value <= alpha) return max_value;
+               if (max_value <= alpha) {
+                  SearchStat->trans_cut_nb++;
+                  TRACE_EXIT(height,max_value,trans_move,TraceReasonTrans);
+                  return max_value;
+               }
             }
 
-            if (min_value == max_value) return min_value; // exact match
+            if (min_value == max_value) { // exact match
+               SearchStat->trans_cut_nb++;
+               TRACE_EXIT(height,min_value,trans_move,TraceReasonTrans);
+               return min_value;
+            }
          }
       }
    }
 
    // height limit
 
-   if (height >= HeightMax-1) return eval(board);
+   if (height >= HeightMax-1) {
+      value = eval(board);
+      TRACE_EXIT(height,value,MoveNone,TraceReasonHeight);
+      return value;
+   }
 
    // more init
 
@@ -505,6 +539,8 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
 
          new_depth = depth - NullReduction - 1;
 
+         SearchStat->null_nb++;
+
          move_do_null(board,undo);
          value = -full_search(board,-beta,-beta+1,new_depth,height+1,new_pv,NODE_OPP(node_type));
          move_undo_null(board,undo);
@@ -522,10 +558,12 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
 
                if (value >= beta) {
                   ASSERT(move==new_pv[0]);
+                  SearchStat->null_cut_nb++;
                   played[played_nb++] = move;
                   best_move = move;
                   best_value = value;
                   pv_copy(pv,new_pv);
+                  TRACE_REASON(TraceReasonNull);
                   goto cut;
                }
             }
@@ -538,10 +576,13 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
             if (value > +ValueEvalInf) value = +ValueEvalInf; // do not return unproven mates
             ASSERT(!value_is_mate(value));
 
+            SearchStat->null_cut_nb++;
+
             // pv_cat(pv,new_pv,MoveNull);
 
             best_move = MoveNone;
             best_value = value;
+            TRACE_REASON(TraceReasonNull);
             goto cut;
          }
       }
@@ -594,6 +635,7 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
                ASSERT(!move_is_check(move,board));
                new_depth--;
                reduced = true;
+               SearchStat->history_nb++;
             }
          }
       }
@@ -638,6 +680,7 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
       } else { // other moves
          value = -full_search(board,-alpha-1,-alpha,new_depth,height+1,new_pv,NodeCut);
          if (value > alpha) { // && value < beta
+            SearchStat->research_nb++;
             value = -full_search(board,-beta,-alpha,new_depth,height+1,new_pv,NodePV);
          }
       }
@@ -648,6 +691,9 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
 
          ASSERT(node_type!=NodePV);
 
+         SearchStat->history_research_nb++;
+         SearchStat->research_nb++;
+
          new_depth++;
          ASSERT(new_depth==depth-1);
 
@@ -664,7 +710,12 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
          if (value > alpha) {
             alpha = value;
             best_move = move;
-            if (value >= beta) goto cut;
+            if (value >= beta) {
+               SearchStat->cut_nb++;
+               if (played_nb == 1) SearchStat->cut_first_nb++;
+               TRACE_REASON(TraceReasonBeta);
+               goto cut;
+            }
          }
       }
 
@@ -676,13 +727,17 @@ static int full_search(board_t * board, int alpha, int beta, int depth, int heig
    if (best_value == ValueNone) { // no legal move
       if (in_check) {
          ASSERT(board_is_mate(board));
+         TRACE_EXIT(height,VALUE_MATE(height),MoveNone,TraceReasonMate);
          return VALUE_MATE(height);
       } else {
          ASSERT(board_is_stalemate(board));
+         TRACE_EXIT(height,ValueDraw,MoveNone,TraceReasonDraw);
          return ValueDraw;
       }
    }
 
+   TRACE_REASON(TraceReasonNone);
+
 cut:
 
    ASSERT(value_is_ok(best_value));
@@ -719,6 +774,8 @@ cut:
       trans_store(Trans,board->key,trans_move,trans_depth,trans_min_value,trans_max_value);
    }
 
+   TRACE_EXIT(height,best_value,best_move,TraceReason);
+
    return best_value;
 }
 
@@ -755,8 +812,8 @@ static int full_no_null(board_t * board, int alpha, int beta, int depth, int hei
 
    if (height > SearchCurrent->max_depth) SearchCurrent->max_depth = height;
 
-   if (SearchInfo->check_nb <= 0) {
-      SearchInfo->check_nb += SearchInfo->check_inc;
+   if (SearchInfo->check_nb <= 0 || InputEvent.load(std::memory_order_relaxed)) {
+      SearchInfo->check_nb = SearchInfo->check_inc;
       search_check();
    }
 
@@ -830,19 +887,25 @@ static int full_quiescence(board_t * board, int alpha, int beta, int depth, int
    // init
 
    SearchCurrent->node_nb++;
+   SearchStat->qs_node_nb++;
    SearchInfo->check_nb--;
    PV_CLEAR(pv);
 
    if (height > SearchCurrent->max_depth) SearchCurrent->max_depth = height;
 
-   if (SearchInfo->check_nb <= 0) {
-      SearchInfo->check_nb += SearchInfo->check_inc;
+   TRACE_ENTER(TraceEnterQS,depth,height,alpha,beta);
+
+   if (SearchInfo->check_nb <= 0 || InputEvent.load(std::memory_order_relaxed)) {
+      SearchInfo->check_nb = SearchInfo->check_inc;
       search_check();
    }
 
    // draw?
 
-   if (board_is_repetition(board) || recog_draw(board)) return ValueDraw;
+   if (board_is_repetition(board) || recog_draw(board)) {
+      TRACE_EXIT(height,ValueDraw,MoveNone,TraceReasonDraw);
+      return ValueDraw;
+   }
 
    // mate-distance pruning
 
@@ -855,7 +918,10 @@ static int full_quiescence(board_t * board, int alpha, int beta, int depth, int
 
       if (value > alpha) {
          alpha = value;
-         if (value >= beta) return value;
+         if (value >= beta) {
+            TRACE_EXIT(height,value,MoveNone,TraceReasonMate);
+            return value;
+         }
       }
 
       // upper bound
@@ -864,7 +930,10 @@ static int full_quiescence(board_t * board, int alpha, int beta, int depth, int
 
       if (value < beta) {
          beta = value;
-         if (value <= alpha) return value;
+         if (value <= alpha) {
+            TRACE_EXIT(height,value,MoveNone,TraceReasonMate);
+            return value;
+         }
       }
    }
 
@@ -880,7 +949,11 @@ static int full_quiescence(board_t * board, int alpha, int beta, int depth, int
 
    // height limit
 
-   if (height >= HeightMax-1) return eval(board);
+   if (height >= HeightMax-1) {
+      value = eval(board);
+      TRACE_EXIT(height,value,MoveNone,TraceReasonHeight);
+      return value;
+   }
 
    // more init
 
@@ -894,7 +967,10 @@ static int full_quiescence(board_t * board, int alpha, int beta, int depth, int
 
       // lone-king stalemate?
 
-      if (simple_stalemate(board)) return ValueDraw;
+      if (simple_stalemate(board)) {
+         TRACE_EXIT(height,ValueDraw,MoveNone,TraceReasonDraw);
+         return ValueDraw;
+      }
 
       // stand pat
 
@@ -904,7 +980,10 @@ static int full_quiescence(board_t * board, int alpha, int beta, int depth, int
       best_value = value;
       if (value > alpha) {
          alpha = value;
-         if (value >= beta) goto cut;
+         if (value >= beta) {
+            TRACE_REASON(TraceReasonStandPat);
+            goto cut;
+         }
       }
 
       if (UseDelta) {
@@ -966,7 +1045,10 @@ static int full_quiescence(board_t * board, int alpha, int beta, int depth, int
          if (value > alpha) {
             alpha = value;
             best_move = move;
-            if (value >= beta) goto cut;
+            if (value >= beta) {
+               TRACE_REASON(TraceReasonBeta);
+               goto cut;
+            }
          }
       }
    }
@@ -975,13 +1057,18 @@ static int full_quiescence(board_t * board, int alpha, int beta, int depth, int
 
    if (best_value == ValueNone) { // no legal move
       ASSERT(board_is_mate(board));
+      TRACE_EXIT(height,VALUE_MATE(height),MoveNone,TraceReasonMate);
       return VALUE_MATE(height);
    }
 
+   TRACE_REASON(TraceReasonNone);
+
 cut:
 
    ASSERT(value_is_ok(best_value));
 
+   TRACE_EXIT(height,best_value,best_move,TraceReason);
+
    return best_value;
 }
 
@@ -0,0 +1,249 @@
+/* trace.cpp
+
+   GNU Chess engine
+
+   Copyright (C) 2001-2021 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// trace.cpp
+
+// includes
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "move.h"
+#include "option.h"
+#include "search.h"
+#include "trace.h"
+#include "util.h"
+
+namespace engine {
+
+// constants
+
+static const int TraceSizeMin = 1; // MB
+
+// types
+
+struct trace_t {
+   char * file_name;
+   int fd;
+   void * map;
+   sint64 map_size;
+   trace_header_t * header;
+   trace_record_t * record;
+   uint64 mask;
+   uint64 pos;
+};
+
+// variables
+
+bool TraceActive = false;
+int TraceReason = TraceReasonNone;
+
+static trace_t Trace[1] = { { NULL, -1, NULL, 0, NULL, NULL, 0, 0 } };
+
+// prototypes
+
+#ifdef SEARCH_TRACE
+static void trace_open  (const char file_name[], int size);
+static void trace_close ();
+#endif
+
+static void trace_write (const trace_record_t * record);
+
+// functions
+
+// trace_start()
+
+void trace_start() {
+
+#ifdef SEARCH_TRACE
+
+   const char * file_name;
+
+   file_name = option_get_string("Trace File");
+
+   if (my_string_empty(file_name) || my_string_equal(file_name,"<empty>")) {
+      trace_close();
+      return;
+   }
+
+   if (Trace->file_name == NULL || !my_string_equal(Trace->file_name,file_name)) {
+      trace_close();
+      trace_open(file_name,option_get_int("Trace Size"));
+   }
+
+   trace_mark(TraceSearch,0);
+
+#endif
+}
+
+// trace_flush()
+
+void trace_flush() {
+
+   if (Trace->map != NULL) msync(Trace->map,Trace->map_size,MS_ASYNC);
+}
+
+#ifdef SEARCH_TRACE
+
+// trace_open()
+
+static void trace_open(const char file_name[], int size) {
+
+   uint64 record_nb;
+
+   ASSERT(file_name!=NULL);
+
+   if (size < TraceSizeMin) size = TraceSizeMin;
+
+   // largest power of two that fits
+
+   record_nb = 1;
+   while (record_nb * 2 * sizeof(trace_record_t) <= uint64(size) * 1024 * 1024) record_nb *= 2;
+
+   Trace->map_size = sizeof(trace_header_t) + record_nb * sizeof(trace_record_t);
+
+   Trace->fd = open(file_name,O_RDWR|O_CREAT|O_TRUNC,0644);
+   if (Trace->fd < 0) my_fatal("trace_open(): can't open file \"%s\": %s\n",file_name,strerror(errno));
+
+   if (ftruncate(Trace->fd,Trace->map_size) != 0) {
+      my_fatal("trace_open(): ftruncate(): %s\n",strerror(errno));
+   }
+
+   Trace->map = mmap(NULL,Trace->map_size,PROT_READ|PROT_WRITE,MAP_SHARED,Trace->fd,0);
+   if (Trace->map == MAP_FAILED) my_fatal("trace_open(): mmap(): %s\n",strerror(errno));
+
+   Trace->header = (trace_header_t *) Trace->map;
+   Trace->record = (trace_record_t *) (Trace->header + 1);
+   Trace->mask = record_nb - 1;
+   Trace->pos = 0;
+
+   memset(Trace->header,0,sizeof(trace_header_t));
+   memcpy(Trace->header->magic,TraceMagic,sizeof(TraceMagic));
+   Trace->header->record_size = sizeof(trace_record_t);
+   Trace->header->record_nb = uint32(record_nb);
+   Trace->header->pos = 0;
+
+   Trace->file_name = my_strdup(file_name);
+
+   TraceActive = true;
+}
+
+// trace_close()
+
+static void trace_close() {
+
+   TraceActive = false;
+
+   if (Trace->map != NULL) {
+      msync(Trace->map,Trace->map_size,MS_SYNC);
+      munmap(Trace->map,Trace->map_size);
+      Trace->map = NULL;
+   }
+
+   if (Trace->fd >= 0) {
+      close(Trace->fd);
+      Trace->fd = -1;
+   }
+
+   if (Trace->file_name != NULL) {
+      my_free(Trace->file_name);
+      Trace->file_name = NULL;
+   }
+}
+
+#endif
+
+// trace_enter()
+
+void trace_enter(int type, int depth, int height, int alpha, int beta) {
+
+   trace_record_t record[1];
+
+   ASSERT(type==TraceEnter||type==TraceEnterQS);
+
+   record->type = type;
+   record->reason = TraceReasonNone;
+   record->depth = depth;
+   record->height = height;
+   record->alpha = alpha;
+   record->beta = beta;
+   record->move = MoveNone;
+   record->value = 0;
+   record->node = uint32(SearchCurrent->node_nb);
+
+   trace_write(record);
+}
+
+// trace_exit()
+
+void trace_exit(int height, int value, int move, int reason) {
+
+   trace_record_t record[1];
+
+   ASSERT(reason>=0&&reason<TraceReasonNb);
+
+   record->type = TraceExit;
+   record->reason = reason;
+   record->depth = 0;
+   record->height = height;
+   record->alpha = 0;
+   record->beta = 0;
+   record->move = move;
+   record->value = value;
+   record->node = uint32(SearchCurrent->node_nb);
+
+   trace_write(record);
+}
+
+// trace_mark()
+
+void trace_mark(int type, int depth) {
+
+   trace_record_t record[1];
+
+   ASSERT(type==TraceSearch||type==TraceIteration);
+
+   memset(record,0,sizeof(trace_record_t));
+
+   record->type = type;
+   record->depth = depth;
+   record->node = uint32(SearchCurrent->node_nb);
+
+   trace_write(record);
+}
+
+// trace_write()
+
+static void trace_write(const trace_record_t * record) {
+
+   ASSERT(TraceActive);
+
+   Trace->record[Trace->pos&Trace->mask] = *record;
+   Trace->header->pos = ++Trace->pos;
+}
+
+}  // namespace engine
+
+// end of trace.cpp
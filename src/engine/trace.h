@@ -0,0 +1,113 @@
+/* trace.h
+
+   GNU Chess engine
+
+   Copyright (C) 2001-2021 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// trace.h
+
+#ifndef TRACE_H
+#define TRACE_H
+
+// includes
+
+#include "config.h"
+#include "util.h"
+
+namespace engine {
+
+// constants
+
+const int TraceEnter     = 1; // full_search() node
+const int TraceEnterQS   = 2; // full_quiescence() node
+const int TraceExit      = 3;
+const int TraceSearch    = 4; // start of a search
+const int TraceIteration = 5; // start of an iteration, depth = iteration depth
+
+// cutoff reasons (exit records)
+
+const int TraceReasonNone      = 0; // all moves searched
+const int TraceReasonBeta      = 1; // fail high in the move loop
+const int TraceReasonTrans     = 2; // transposition-table cutoff
+const int TraceReasonNull      = 3; // null-move (or verification) cutoff
+const int TraceReasonStandPat  = 4; // quiescence stand pat
+const int TraceReasonDraw      = 5; // repetition, recognised draw or stalemate
+const int TraceReasonMate      = 6; // mate found or mate-distance pruning
+const int TraceReasonHeight    = 7; // height limit
+
+const int TraceReasonNb = 8;
+
+// file header
+
+const char TraceMagic[8] = { 'G', 'C', 'T', 'R', 'A', 'C', 'E', '1' };
+
+// types
+
+struct trace_record_t { // 16 bytes
+   uint8 type;
+   uint8 reason;
+   sint8 depth;
+   uint8 height;
+   sint16 alpha;  // enter
+   sint16 beta;   // enter
+   uint16 move;   // exit: best move
+   sint16 value;  // exit
+   uint32 node;   // low 32 bits of the node counter
+};
+
+struct trace_header_t { // 64 bytes
+   char magic[8];
+   uint32 record_size;
+   uint32 record_nb;  // ring capacity
+   uint64 pos;        // number of records ever written
+   uint8 pad[40];
+};
+
+// macros
+
+#ifdef SEARCH_TRACE
+#  define TRACE_ENTER(type,depth,height,alpha,beta) { if (TraceActive) trace_enter((type),(depth),(height),(alpha),(beta)); }
+#  define TRACE_EXIT(height,value,move,reason)      { if (TraceActive) trace_exit((height),(value),(move),(reason)); }
+#  define TRACE_MARK(type,depth)                    { if (TraceActive) trace_mark((type),(depth)); }
+#  define TRACE_REASON(reason)                      { TraceReason = (reason); }
+#else
+#  define TRACE_ENTER(type,depth,height,alpha,beta)
+#  define TRACE_EXIT(height,value,move,reason)
+#  define TRACE_MARK(type,depth)
+#  define TRACE_REASON(reason)
+#endif
+
+// variables
+
+extern bool TraceActive;
+extern int TraceReason; // reason of the cutoff about to be taken by "goto cut"
+
+// functions
+
+extern void trace_start (); // opens the "Trace File" if needed
+extern void trace_flush ();
+
+extern void trace_enter (int type, int depth, int height, int alpha, int beta);
+extern void trace_exit  (int height, int value, int move, int reason);
+extern void trace_mark  (int type, int depth);
+
+}  // namespace engine
+
+#endif // !defined TRACE_H
+
+// end of trace.h
@@ -37,19 +37,13 @@
 
 namespace engine {
 
-// Streams used for coommunication with the the adapter
-
-extern FILE *pipefd_a2e_0_stream;
-extern FILE *pipefd_e2a_1_stream;
-
 // functions
 
 // util_init()
 
 void util_init() {
 
-   setvbuf(pipefd_a2e_0_stream,NULL,_IONBF,0);
-   setvbuf(pipefd_e2a_1_stream,NULL,_IONBF,0); // _IOLBF breaks on Windows!
+   // nothing to do, the adapter queues are unbuffered
 }
 
 // my_random_init()
@@ -138,10 +138,10 @@ static char *build_setboard_cmd_from_epd_file(char *data, const char *epd_filena
 }
 
 /*
- * Takes a PGN filename as input and returns the contents as a
- * 'setboard <epd-position>' command.
+ * Takes a PGN filename as input and returns the contents of game
+ * 'game_nb' (the first one if 0) as a 'setboard <epd-position>' command.
  */
-static char *build_setboard_cmd_from_pgn_file(char *data, const char *pgn_filename, unsigned int data_len)
+static char *build_setboard_cmd_from_pgn_file(char *data, const char *pgn_filename, int game_nb, unsigned int data_len)
 {
   char *result = NULL;
   char *epdline = (char *)calloc(data_len, sizeof(char));
@@ -149,7 +149,12 @@ static char *build_setboard_cmd_from_pgn_file(char *data, const char *pgn_filena
   if (epdline == NULL) {
     return NULL;
   }
-  PGNReadFromFile (pgn_filename, 0);
+  if (game_nb == 0) {
+    PGNReadFromFile (pgn_filename, 0);
+  } else if (!PGNReadGameFromFile (pgn_filename, game_nb, 0)) {
+    free(epdline);
+    return NULL;
+  }
   EPD2str(epdline);
   if (strlen(setboard_cmd) + strlen(epdline) < data_len) {
     strcpy(data, setboard_cmd);
@@ -162,14 +167,36 @@ static char *build_setboard_cmd_from_pgn_file(char *data, const char *pgn_filena
 }
 
 /*
- * Loads a PGN file. Returns 1 on success, 0 on error.
+ * Loads a game of a PGN file, the first one unless a game number is
+ * given. Returns 1 on success, 0 on error.
  */
-static int pgnload(const char *pgn_filename)
+static int pgnload(const char *file_token, const char *game_token)
 {
   int success;
+  int game_nb = 0;
+  char pgn_filename[MAXSTR]="";
   char data[MAXSTR]="";
+  size_t len;
+
+  /* The file name token runs to the end of the line, game number included */
+  len = strlen(file_token);
+  if (game_token[0] != '\0' && strspn(game_token, "0123456789") == strlen(game_token)) {
+    game_nb = atoi( game_token );
+    if (game_nb < 1) {
+      printf( _("Incorrect game number: '%s'.\n"), game_token );
+      return 0;
+    }
+    len = game_token - file_token;
+    while (len > 0 && isspace(file_token[len-1])) len--;
+  }
+  if (len >= sizeof(pgn_filename)) {
+    printf( _("Error loading PGN file '%s'.\n"), file_token );
+    return 0;
+  }
+  memcpy(pgn_filename, file_token, len);
+  pgn_filename[len] = '\0';
 
-  if (build_setboard_cmd_from_pgn_file(data, pgn_filename, sizeof(data))) {
+  if (build_setboard_cmd_from_pgn_file(data, pgn_filename, game_nb, sizeof(data))) {
     SetDataToEngine( data );
     SetAutoGo( true );
     success = 1;
@@ -298,6 +325,22 @@ void cmd_force(void)
   SetDataToEngine( token[0] );
 }
 
+/* List the games of a position index that reached the current position */
+void cmd_games(void)
+{
+  char data[MAXSTR]="";
+  strcpy( data, "games" );
+  if ( token[1][0] != '\0' ) {
+    if (access(token[1], F_OK) < 0) {
+      printf(_("The syntax to look up a position index is:\n\n\tgames file.idx\n"));
+      return;
+    }
+    strcat( data, " " );
+    strcat( data, token[1] );
+  }
+  SetDataToEngine( data );
+}
+
 void cmd_go(void)
 {
   SET (flags, THINK);
@@ -516,13 +559,13 @@ void cmd_otim(void)
  */
 void cmd_pgnload(void)
 {
-  pgnload(token[1]);
+  pgnload(token[1], token[2]);
 }
 
 /* See comment above in cmd_pgnload about PGN -> EPD conversion. */
 void cmd_pgnreplay(void)
 {
-  if (!pgnload(token[1])) {
+  if (!pgnload(token[1], token[2])) {
     return;
   }
   pgnloaded = 1;
@@ -843,6 +886,11 @@ Play the game of chess.\n\n"), stdout );
  -g, --graphic      enable graphic mode\n"), stdout );
       fputs( _("\
 \n"), stdout );
+      printf ( _("\
+ %s epd-test|make-book|merge-book|make-gamedb|find-games [OPTION]...\n\
+ runs the adapter tools; epd-test accepts -epd, -max-time, -results,\n\
+ -baseline and -max-node-growth among others.\n\
+\n"), progname );
       fputs( _("\
  Options xboard and post are accepted without leading dashes\n\
  for backward compatibility.\n\
@@ -1062,9 +1110,10 @@ static const char * const helpstr[] = {
    gettext_noop(" Backs up one move in pgn loaded game."),
    "pgnsave FILENAME",
    gettext_noop(" Saves the game so far from memory to the file."),
-   "pgnload FILENAME",
-   gettext_noop(" Loads the game in the file into memory."),
-   "pgnreplay FILENAME",
+   "pgnload FILENAME [N]",
+   gettext_noop(" Loads the game in the file into memory, or game N of\n"
+                " a file holding several games."),
+   "pgnreplay FILENAME [N]",
    gettext_noop(" Loads the game in the file into memory, and enables\n"
                 " the commands 'first', 'last', 'next', 'previous'."),
    "next",
@@ -1163,6 +1212,9 @@ static const char * const helpstr[] = {
    gettext_noop(" evalspeed - tests speed of the evaluator"),
    "bk",
    gettext_noop(" Shows moves from opening book."),
+   "games [FILENAME]",
+   gettext_noop(" Shows the games of a position index (make-book -index)\n"
+                " that reached the current position."),
    "graphic",
    gettext_noop(" Enables display board in graphic mode."),
    "nographic",
@@ -1241,6 +1293,7 @@ const struct methodtable commands[] = {
   { "epdsave", cmd_save },
   { "exit", cmd_exit },
   { "force", cmd_force },
+  { "games", cmd_games },
   { "go", cmd_go },
   { "graphic", cmd_graphic },
   { "hard", cmd_hard },
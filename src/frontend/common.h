@@ -464,6 +464,8 @@ short ValidateBoard (void);
 /*  PGN routines  */
 void PGNSaveToFile (const char *, const char *);
 void PGNReadFromFile (const char *, int showheading);
+int PGNReadGameFromFile (const char *, int n, int showheading);
+int PGNFindGame (const char *, int n, off_t *start, off_t *end);
 
 /*  Some output routines */
 void ShowMoveList (int);
@@ -475,7 +477,24 @@ void ShowGame (void);
 void ShowTime (void);
 
 /*  Solver routines  */
+
+/*
+ * Search information gathered from the engine's thinking lines while
+ * solving a position. The 'found_' fields tell when the final best move
+ * became the first move of the principal variation for the last time.
+ */
+typedef struct
+{
+   int depth;
+   double time;            /* in seconds */
+   long long nodes;
+   int found_depth;
+   double found_time;
+   long long found_nodes;
+} SolveInfo;
+
 void Solve (char *);
+void SolvePosition (char move[], const char position[], SolveInfo *info);
 
 /* Player database */
 void DBSortPlayer (const char *style);
@@ -542,6 +561,7 @@ void cmd_edit(void);
 void cmd_epd(void);
 void cmd_exit(void);
 void cmd_force(void);
+void cmd_games(void);
 void cmd_go(void);
 void cmd_graphic(void);
 void cmd_hard(void);
@@ -707,4 +727,10 @@ void ForwardUserInputToEngine( void );
  */
 void ForwardEngineOutputToUser( void );
 
+/*
+ * Blocks until there is some input from the user or the engine to be
+ * processed by the main loop.
+ */
+void WaitForInput( void );
+
 #endif /* !COMMON_H */
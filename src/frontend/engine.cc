@@ -33,6 +33,7 @@
 #include <assert.h>
 #include <unistd.h>
 #include <math.h>
+#include <poll.h>
 
 #include "common.h"
 #include "components.h"
@@ -98,29 +99,16 @@ void InitFrontend( void )
  */
 int SendToEngine( char msg[] )
 {
-    int outError=0;
     int msg_size = strlen( msg );
-    int msg_count=0;
 
     /* The trailing '\n' is necessary. Otherwise, Polyglot will not realise of
        the new message. TODO: This should be improved. */
     msg[msg_size] = '\n';
     msg[msg_size+1] = '\0';
 
-    msg_count = write( pipefd_f2a[1], msg, msg_size+1 );
+    queue_write( queue_f2a, msg, msg_size+1 );
 
-    if (msg_count == -1)
-      outError = errno;
-    else
-      outError = 0;
-
-    if ( ( msg_count == msg_size+1 ) && ( outError == 0 ) ) {
-        return 1;
-    } else {
-        printf( "Error sending message to engine.\n" );
-        assert( 0 );
-        return 0;
-    }
+    return 1;
 }
 
 /*
@@ -133,24 +121,16 @@ int ReadFromEngine( void )
 {
 
   int nread=0;
-  fd_set set[1];
-  struct timeval time_val[1];
   int engineinputready=0;
   char engineinputaux[BUF_SIZE]="";
 
   /* Poll input from engine in non-blocking mode */
-  FD_ZERO(set);
-  FD_SET( pipefd_a2f[0],set);
-  time_val->tv_sec = 0;
-  time_val->tv_usec = 0;
-  engineinputready = select( pipefd_a2f[0]+1, set, NULL, NULL, time_val );
+  engineinputready = queue_ready( queue_a2f );
 
-  if ( engineinputready == -1 ) {
-    printf( "Error reading engine input.\n" );
-  } else if ( engineinputready > 0 ) {
+  if ( engineinputready > 0 ) {
     /* There are some data from the engine. Store it in buffer */
     strncpy( engineinputaux, zerochar, BUF_SIZE );
-    nread = read( pipefd_a2f[0], engineinputaux, BUF_SIZE );
+    nread = queue_read( queue_a2f, engineinputaux, BUF_SIZE-1 );
     /*write( STDOUT_FILENO, engineinputaux, BUF_SIZE );*/
     strcat( engineinputbuf, engineinputaux );
     engineinputbuf[strlen( engineinputbuf ) + nread] = '\0';
@@ -168,24 +148,16 @@ int ReadFromEngine( void )
 void ReadFromUser( void )
 {
   int nread=0;
-  fd_set set[1];
-  struct timeval time_val[1];
   int userinputready=0;
   char userinputaux[BUF_SIZE]="";
 
   /* Poll input from user in non-blocking mode */
-  FD_ZERO(set);
-  FD_SET(pipefd_i2f[0],set);
-  time_val->tv_sec = 0;
-  time_val->tv_usec = 0;
-  userinputready = select( pipefd_i2f[0]+1, set, NULL, NULL, time_val );
+  userinputready = queue_ready( queue_i2f );
 
-  if ( userinputready == -1 ) {
-    printf( "Error reading user input.\n" );
-  } else if ( userinputready > 0 ) {
+  if ( userinputready > 0 ) {
     /* There are some data from the user. Store it in buffer */
     strncpy( userinputaux, zerochar, BUF_SIZE );
-    nread = read( pipefd_i2f[0], userinputaux, BUF_SIZE );
+    nread = queue_read( queue_i2f, userinputaux, BUF_SIZE-1 );
     strcat( userinputbuf, userinputaux );
     userinputbuf[strlen( userinputbuf ) + nread] = '\0';
   }
@@ -439,45 +411,116 @@ int GetAutoGo( void )
   return autoGo;
 }
 
+/*
+ * Blocks until the adapter/engine has sent something.
+ */
+static void WaitForEngine( void )
+{
+  struct pollfd fds[1];
+
+  fds[0].fd = queue_fd( queue_a2f );
+  fds[0].events = POLLIN;
+  fds[0].revents = 0;
+
+  if ( poll( fds, 1, -1 ) == -1 && errno != EINTR ) {
+    printf( "Error waiting for engine input.\n" );
+  }
+}
+
+/*
+ * Parses an xboard thinking line "depth score time nodes pv..." (time in
+ * centiseconds) and updates 'info'. Returns 0 for other lines.
+ */
+static int ParseThinkingLine( const char line[], SolveInfo *info, char firstmove[] )
+{
+  int depth, score, pos=0;
+  double time;
+  long long nodes;
+  char move[BUF_SIZE]="";
+
+  if ( sscanf( line, "%d %d %lf %lld %n", &depth, &score, &time, &nodes, &pos ) < 4 || pos == 0 ) {
+    return 0;
+  }
+  if ( sscanf( line+pos, "%s", move ) != 1 ) {
+    return 0;
+  }
+
+  info->depth = depth;
+  info->time = time / 100.0;
+  info->nodes = nodes;
+
+  /* Remember when the current first move took over */
+  if ( strcmp( move, firstmove ) != 0 ) {
+    strcpy( firstmove, move );
+    info->found_depth = depth;
+    info->found_time = info->time;
+    info->found_nodes = nodes;
+  }
+
+  return 1;
+}
+
 /*
  * Solves a position given in an EPD file.
+ *
+ * Waits for the engine's answer without polling, and collects the search
+ * information of its thinking lines in 'info'.
  */
-void SolvePosition( char move[], const char position[] )
+void SolvePosition( char move[], const char position[], SolveInfo *info )
 {
   char msg[BUF_SIZE]="";
   char engineinput[BUF_SIZE]="";
+  char firstmove[BUF_SIZE]="";
   int solved = 0;
 
   /* TODO Translatable or not? */
   printf( "\nSolve position:\n\t%s\n", position );
 
+  memset( info, 0, sizeof(*info) );
+
   /* Send position to adapter/engine. */
   strcpy( msg, "setboard " );
   strcat( msg, position );
   msg[strlen(msg)-1] = '\0';
   SendToEngine( msg );
 
-  /* Set adapter/engine to analyse. */
-  sprintf( msg, "st %d\ngo", (int)round( SearchTime ) );
+  /* Set adapter/engine to analyse, showing its thinking. */
+  sprintf( msg, "post\nst %d\ngo", (int)round( SearchTime ) );
   SendToEngine( msg );
 
   /* Read adapter/engine's answer (the move). */
-  while ( ( ! ReadFromEngine() ) || ( ! solved ) ) {
-    if ( strlen( engineinputbuf ) > 0 ) {
-      GetNextLineNoRemove( engineinputbuf, engineinput );
-      assert( strlen( engineinput ) > 0 );
-      if ( strncmp( engineinput, "move", 4 ) == 0 ) {
-        solved = 1;
-        break;
-      } else {
-        GetNextLine( engineinputbuf, engineinput );
-        printf( "%s\n", engineinput );
+  while ( ! solved ) {
+    if ( ! GetNextLineNoRemove( engineinputbuf, engineinput ) ) {
+      /* No complete line yet: sleep until the engine sends more. */
+      if ( ! ReadFromEngine() ) {
+        WaitForEngine();
       }
+      continue;
+    }
+    assert( strlen( engineinput ) > 0 );
+    if ( strncmp( engineinput, "move", 4 ) == 0 ) {
+      solved = 1;
+    } else {
+      GetNextLine( engineinputbuf, engineinput );
+      ParseThinkingLine( engineinput, info, firstmove );
+      printf( "%s\n", engineinput );
     }
-    sleep( 0 );
   }
   NextEngineCmd();
 
+  /* The best move changed after the last thinking line */
+  if ( strcmp( firstmove, SANmv ) != 0 ) {
+    info->found_depth = info->depth;
+    info->found_time = info->time;
+    info->found_nodes = info->nodes;
+  }
+
+  /* Restore the user's setting. */
+  if ( !(flags & POST) ) {
+    strcpy( msg, "nopost" );
+    SendToEngine( msg );
+  }
+
   strcpy( move, SANmv );
 }
 
@@ -507,6 +550,12 @@ void ForwardUserInputToEngine( void )
     /* There are some data from the user. Read the data */
     strncpy( userinputaux, zerochar, BUF_SIZE );
     nread = read( STDIN_FILENO, userinputaux, BUF_SIZE );
+    if ( nread <= 0 ) {
+      /* End of input: stop the engine instead of waking up forever */
+      SET (flags, QUIT);
+      queue_write( queue_a2e, "quit\n", 5 );
+      return;
+    }
     /* Send the data to the engine */
     assert( nread+1 < BUF_SIZE-1 );
     if ( strcmp(userinputaux,"quit") == 0 || strcmp(userinputaux,"quit\n") == 0 ) {
@@ -514,17 +563,7 @@ void ForwardUserInputToEngine( void )
     }
     userinputaux[nread] = '\n';
     userinputaux[nread+1] = '\0';
-    int outError=0;
-    int msg_count=0;
-    msg_count = write( pipefd_a2e[1], userinputaux, nread+1 );
-    if (msg_count == -1)
-      outError = errno;
-    else
-      outError = 0;
-    if ( ! ( ( msg_count == nread+1 ) && ( outError == 0 ) ) ) {
-        printf( "Error sending message to engine.\n" );
-        assert( 0 );
-    }
+    queue_write( queue_a2e, userinputaux, nread+1 );
   }
 }
 
@@ -536,24 +575,16 @@ void ForwardEngineOutputToUser( void )
 {
 
   int nread=0;
-  fd_set set[1];
-  struct timeval time_val[1];
   int engineinputready=0;
   char engineinputaux[BUF_SIZE+1]="";
 
   /* Poll input from engine in non-blocking mode */
-  FD_ZERO(set);
-  FD_SET( pipefd_e2a[0],set);
-  time_val->tv_sec = 0;
-  time_val->tv_usec = 0;
-  engineinputready = select( pipefd_e2a[0]+1, set, NULL, NULL, time_val );
+  engineinputready = queue_ready( queue_e2a );
 
-  if ( engineinputready == -1 ) {
-    printf( "Error reading engine input.\n" );
-  } else if ( engineinputready > 0 ) {
+  if ( engineinputready > 0 ) {
     /* There are some data from the engine. Read the data */
     strncpy( engineinputaux, zerochar, BUF_SIZE+1 );
-    nread = read( pipefd_e2a[0], engineinputaux, BUF_SIZE+1 );
+    nread = queue_read( queue_e2a, engineinputaux, BUF_SIZE+1 );
     /* Write data to output */
     assert( nread <= BUF_SIZE+1 );
     if (nread < BUF_SIZE+1) {
@@ -567,3 +598,35 @@ void ForwardEngineOutputToUser( void )
     }
   }
 }
+
+/*
+ * Blocks until there is some input from the user or the engine to be
+ * processed by the main loop.
+ *
+ * Lines already buffered are processed without waiting. Otherwise, in
+ * UCI mode, waits on standard input and on the engine queue; in the
+ * other modes, waits on the input thread and adapter queues.
+ */
+void WaitForInput( void )
+{
+  struct pollfd fds[2];
+  int ret;
+
+  if ( flags & UCI ) {
+    fds[0].fd = STDIN_FILENO;
+    fds[1].fd = queue_fd( queue_e2a );
+  } else {
+    if ( strchr( userinputbuf, '\n' ) != NULL || strchr( engineinputbuf, '\n' ) != NULL ) {
+      return;
+    }
+    fds[0].fd = queue_fd( queue_i2f );
+    fds[1].fd = queue_fd( queue_a2f );
+  }
+  fds[0].events = fds[1].events = POLLIN;
+  fds[0].revents = fds[1].revents = 0;
+
+  ret = poll( fds, 2, -1 );
+  if ( ret == -1 && errno != EINTR ) {
+    printf( "Error waiting for input.\n" );
+  }
+}
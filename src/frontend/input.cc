@@ -107,24 +107,11 @@ void getline_standard(char *p)
  */
 int SendToFrontend( char msg[] )
 {
-    int outError=0;
     int msg_size = strlen( msg );
-    int msg_count=0;
 
-    msg_count = write( pipefd_i2f[1], msg, msg_size );
+    queue_write( queue_i2f, msg, msg_size );
 
-    if (msg_count == -1)
-      outError = errno;
-    else
-      outError = 0;
-
-    if ( ( msg_count == msg_size ) && ( outError == 0 ) ) {
-        return 1;
-    } else {
-        printf( "Error sending message to frontend.\n" );
-        assert( 0 );
-        return 0;
-    }
+    return 1;
 }
 
 void input_wakeup( void )
@@ -152,13 +139,15 @@ void *input_func(void *arg __attribute__((unused)) )
 	      (RealGameCnt+1)/2 + 1 );
     }
     get_line(prompt);
+    /* Clear the flag before the main thread can see the line, otherwise
+       its input_wakeup() may come first and be lost. */
+    pthread_mutex_lock( &input_mutex );
+    wait_for_input = 0;
+    pthread_mutex_unlock( &input_mutex );
     SendToFrontend( userinputstr );
 #ifdef HAVE_LIBREADLINE
     SendToFrontend( "\n" );
 #endif
-    pthread_mutex_lock( &input_mutex );
-    wait_for_input = 0;
-    pthread_mutex_unlock( &input_mutex );
     /* TODO Improve this test */
     if ( strncmp(userinputstr,"quit",4) == 0 ) {
         break;
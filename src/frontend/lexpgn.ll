@@ -416,3 +416,17 @@ NONSPACE	[^ \t\n\r\f]
 
 %%
 
+/*
+ * Scans one game held in memory, instead of reading yyin. Returns the
+ * same codes as yylex().
+ */
+int yylex_buffer (const char *buf, int len)
+{
+	YY_BUFFER_STATE b;
+	int ret;
+
+	b = yy_scan_bytes (buf, len);
+	ret = yylex ();
+	yy_delete_buffer (b);
+	return ret;
+}
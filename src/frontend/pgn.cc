@@ -31,6 +31,9 @@
 #include <ctype.h>
 #include <time.h>
 #include <errno.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <sys/stat.h>
 
 #include "common.h"
 #include "version.h"
@@ -44,6 +47,8 @@
 extern FILE *yyin;
 
 extern int yylex (void);
+extern void yyrestart (FILE *input_file);
+extern int yylex_buffer (const char *buf, int len);
 
 void PGNSaveToFile (const char *file, const char *resultstr)
 /****************************************************************************
@@ -169,6 +174,247 @@ void PGNSaveToFile (const char *file, const char *resultstr)
 }
 
 
+/*
+ * Sidecar index of a PGN file, "file.pgi", giving the offset of each
+ * game so that game N can be read without scanning the N-1 first ones.
+ * All integers are big-endian:
+ *
+ *   header: magic "GCHESSPI", version (4), number of games (4),
+ *           size (8) and modification time (8) of the PGN file
+ *   offsets: start of each game (8), then the size of the PGN file
+ *
+ * The index is built on first use and rebuilt when the size or the
+ * modification time of the PGN file changes.
+ */
+
+#define PGN_INDEX_SUFFIX  ".pgi"
+#define PGN_INDEX_MAGIC   "GCHESSPI"
+#define PGN_INDEX_VERSION 1
+#define PGN_INDEX_HEADER  32
+
+static void PGNIndexPut (unsigned char *p, int size, unsigned long long n)
+{
+   int i;
+
+   for (i = size - 1; i >= 0; i--) {
+      p[i] = n & 0xFF;
+      n >>= 8;
+   }
+}
+
+static unsigned long long PGNIndexGet (const unsigned char *p, int size)
+{
+   unsigned long long n = 0;
+   int i;
+
+   for (i = 0; i < size; i++) {
+      n = (n << 8) | p[i];
+   }
+   return n;
+}
+
+static void PGNIndexHeader (unsigned char *header, int count, const struct stat *st)
+{
+   memcpy (header, PGN_INDEX_MAGIC, 8);
+   PGNIndexPut (header + 8, 4, PGN_INDEX_VERSION);
+   PGNIndexPut (header + 12, 4, count);
+   PGNIndexPut (header + 16, 8, st->st_size);
+   PGNIndexPut (header + 24, 8, st->st_mtime);
+}
+
+/*
+ * Looks up game 'n' in the sidecar index. Returns 1 if the index is up
+ * to date, with '*found' telling whether the game exists, 0 otherwise.
+ */
+static int PGNIndexLookup (const char *index_file, const struct stat *st, int n,
+                           off_t *start, off_t *end, int *found)
+{
+   FILE *fp;
+   unsigned char header[PGN_INDEX_HEADER];
+   unsigned char expected[PGN_INDEX_HEADER];
+   unsigned char offset[16];
+   struct stat ist;
+   int count;
+   int valid = 0;
+
+   fp = fopen (index_file, "rb");
+   if (fp == NULL)
+      return 0;
+
+   if (fread (header, 1, PGN_INDEX_HEADER, fp) == PGN_INDEX_HEADER
+       && fstat (fileno (fp), &ist) == 0) {
+      count = PGNIndexGet (header + 12, 4);
+      PGNIndexHeader (expected, count, st);
+      if (memcmp (header, expected, PGN_INDEX_HEADER) == 0
+          && ist.st_size == PGN_INDEX_HEADER + ((off_t) count + 1) * 8) {
+         valid = 1;
+         *found = 0;
+         if (n <= count
+             && fseeko (fp, PGN_INDEX_HEADER + (off_t) (n - 1) * 8, SEEK_SET) == 0
+             && fread (offset, 1, 16, fp) == 16) {
+            *start = PGNIndexGet (offset, 8);
+            *end = PGNIndexGet (offset + 8, 8);
+            *found = ( *start < *end && *end <= st->st_size );
+         }
+      }
+   }
+
+   fclose (fp);
+   return valid;
+}
+
+/*
+ * Returns the offsets of the games of 'file', followed by its size, in
+ * an array to be freed by the caller; NULL on error. A game starts at a
+ * tag line that follows some moves, comments being skipped as the
+ * scanner does.
+ */
+static off_t *PGNIndexScan (const char *file, int *count)
+{
+   FILE *fp;
+   off_t *offset, *p;
+   int alloc;
+   off_t pos;
+   int c;
+   int line_start = 1, skip_line = 0, in_brace = 0, seen_moves = 0;
+
+   fp = fopen (file, "rb");
+   if (fp == NULL)
+      return NULL;
+
+   alloc = 1024;
+   offset = (off_t *) malloc (alloc * sizeof (off_t));
+   if (offset == NULL) {
+      fclose (fp);
+      return NULL;
+   }
+   offset[0] = 0;
+   *count = 1;
+
+   for (pos = 0; (c = getc (fp)) != EOF; pos++) {
+      if (c == '\n' || c == '\r') {
+         line_start = 1;
+         skip_line = 0;
+         continue;
+      }
+      if (skip_line) {
+         /* tag pair or ';' comment */
+      } else if (in_brace) {
+         if (c == '}') in_brace = 0;
+      } else if (line_start && c == '[') {
+         if (seen_moves) {
+            if (*count + 1 == alloc) {
+               alloc *= 2;
+               p = (off_t *) realloc (offset, alloc * sizeof (off_t));
+               if (p == NULL) {
+                  free (offset);
+                  fclose (fp);
+                  return NULL;
+               }
+               offset = p;
+            }
+            offset[(*count)++] = pos;
+            seen_moves = 0;
+         }
+         skip_line = 1;
+      } else if (c == ';' || (line_start && c == '%')) {
+         skip_line = 1;
+      } else if (c == '{') {
+         in_brace = 1;
+      } else if (!isspace (c)) {
+         seen_moves = 1;
+      }
+      line_start = 0;
+   }
+
+   fclose (fp);
+
+   if (pos == 0)
+      *count = 0;
+   offset[*count] = pos; /* one item is always left free */
+   return offset;
+}
+
+/*
+ * Writes the sidecar index. Failures are ignored, the index is then
+ * rebuilt next time.
+ */
+static void PGNIndexWrite (const char *index_file, const struct stat *st,
+                           const off_t *offset, int count)
+{
+   FILE *fp;
+   unsigned char header[PGN_INDEX_HEADER];
+   unsigned char item[8];
+   int i, ok;
+
+   fp = fopen (index_file, "wb");
+   if (fp == NULL)
+      return;
+
+   PGNIndexHeader (header, count, st);
+   ok = ( fwrite (header, 1, PGN_INDEX_HEADER, fp) == PGN_INDEX_HEADER );
+   for (i = 0; ok && i <= count; i++) {
+      PGNIndexPut (item, 8, offset[i]);
+      ok = ( fwrite (item, 1, 8, fp) == 8 );
+   }
+
+   if (fclose (fp) != 0 || !ok)
+      remove (index_file);
+}
+
+int PGNFindGame (const char *file, int n, off_t *start, off_t *end)
+/****************************************************************************
+ *
+ *  To find where game 'n' (from 1) of a PGN file starts and ends, using
+ *  the sidecar index. Returns 1 if the game exists.
+ *
+ ****************************************************************************/
+{
+   struct stat st;
+   char index_file[MAXSTR];
+   off_t *offset;
+   int count, found;
+
+   if (n < 1 || stat (file, &st) != 0)
+      return 0;
+
+   if (snprintf (index_file, sizeof (index_file), "%s%s", file, PGN_INDEX_SUFFIX) >= (int) sizeof (index_file))
+      return 0;
+
+   if (PGNIndexLookup (index_file, &st, n, start, end, &found))
+      return found;
+
+   offset = PGNIndexScan (file, &count);
+   if (offset == NULL)
+      return 0;
+
+   PGNIndexWrite (index_file, &st, offset, count);
+
+   found = ( n <= count );
+   if (found) {
+      *start = offset[n-1];
+      *end = offset[n];
+   }
+
+   free (offset);
+   return found;
+}
+
+static void PGNShowGame (int showheading)
+{
+   ShowBoard ();
+
+   if ( showheading ) {
+      printf("\n--------------------------------------------------\n");
+      printf("%s (%s) x %s (%s) - %s\nSite: %s\nDate: %s\n",
+             pgn_white  != NULL ? pgn_white  : "Unknown", pgn_whiteELO != NULL ? pgn_whiteELO : "Unknown",
+             pgn_black  != NULL ? pgn_black  : "Unknown", pgn_blackELO != NULL ? pgn_blackELO : "Unknown",
+             pgn_result != NULL ? pgn_result : "Unknown", pgn_site     != NULL ? pgn_site     : "Unknown",
+             pgn_date   != NULL ? pgn_date   : "Unknown");
+      printf("--------------------------------------------------\n");
+   }
+}
+
 void PGNReadFromFile (const char *file, int showheading)
 /****************************************************************************
  *
@@ -185,6 +431,8 @@ void PGNReadFromFile (const char *file, int showheading)
       return;
    }
    yyin = fp;
+   /* The scanner may still hold data of a previously read file */
+   yyrestart (yyin);
 
    InitVars ();
 
@@ -193,17 +441,50 @@ void PGNReadFromFile (const char *file, int showheading)
 
    fclose (fp);
 
-   ShowBoard ();
+   PGNShowGame (showheading);
+}
 
-   if ( showheading ) {
-      printf("\n--------------------------------------------------\n");
-      printf("%s (%s) x %s (%s) - %s\nSite: %s\nDate: %s\n",
-             pgn_white  != NULL ? pgn_white  : "Unknown", pgn_whiteELO != NULL ? pgn_whiteELO : "Unknown",
-             pgn_black  != NULL ? pgn_black  : "Unknown", pgn_blackELO != NULL ? pgn_blackELO : "Unknown",
-             pgn_result != NULL ? pgn_result : "Unknown", pgn_site     != NULL ? pgn_site     : "Unknown",
-             pgn_date   != NULL ? pgn_date   : "Unknown");
-      printf("--------------------------------------------------\n");
+int PGNReadGameFromFile (const char *file, int n, int showheading)
+/****************************************************************************
+ *
+ *  To read game 'n' (from 1) of a PGN file. Only the bytes of the game
+ *  are read and given to the scanner. Returns 1 on success.
+ *
+ ****************************************************************************/
+{
+   FILE *fp;
+   off_t start, end;
+   size_t size;
+   char *buf;
+
+   if (!PGNFindGame (file, n, &start, &end))
+   {
+      printf(_("Cannot find game %d in file %s\n"), n, file);
+      return 0;
    }
+
+   size = end - start;
+   buf = (size <= INT_MAX) ? (char *) malloc (size) : NULL;
+   fp = fopen (file, "rb");
+   if (buf == NULL || fp == NULL || fseeko (fp, start, SEEK_SET) != 0
+       || fread (buf, 1, size, fp) != size)
+   {
+      printf(_("Cannot read file %s\n"), file);
+      if (fp != NULL) fclose (fp);
+      free (buf);
+      return 0;
+   }
+   fclose (fp);
+
+   InitVars ();
+
+   data_dest = DEST_GAME;
+   (void) yylex_buffer (buf, (int) size);
+
+   free (buf);
+
+   PGNShowGame (showheading);
+   return 1;
 }
 
 /* Only players in the table below are permitted into the opening book
@@ -33,8 +33,6 @@
 /* A line read from an EPD file */
 extern char epd_line[];
 
-void SolvePosition( char move[], const char position[] );
-
 void Solve (char *file)
 /*****************************************************************************
  *
@@ -45,6 +43,9 @@ void Solve (char *file)
    int total, correct, found;
    char *p;
    char myMove[100]="";
+   SolveInfo info;
+   double found_time = 0.0;
+   long long found_nodes = 0;
 
    total = correct = 0;
    SET (flags, SOLVE);
@@ -53,7 +54,7 @@ void Solve (char *file)
       NewPosition ();
       total++;
       ShowBoard ();
-      SolvePosition( myMove, epd_line );
+      SolvePosition( myMove, epd_line, &info );
       p = solution;
       found = false;
       while (*p != '\0')
@@ -70,8 +71,22 @@ void Solve (char *file)
       printf ("id: %s : ", id);
       printf (found ? "Correct:  " : "Incorrect:  ");
       printf ("<%s> %s\n", myMove, solution);
+      if (found)
+      {
+         found_time += info.found_time;
+         found_nodes += info.found_nodes;
+         printf ("Solved at depth %d, time %.2f, nodes %lld\n",
+                 info.found_depth, info.found_time, info.found_nodes);
+      }
+      printf ("Searched to depth %d, time %.2f, nodes %lld\n",
+              info.depth, info.time, info.nodes);
       printf ("Correct=%d Total=%d\n", correct, total);
    }
+   if (correct > 0)
+   {
+      printf ("Average to solution: time %.2f, nodes %lld\n",
+              found_time / correct, found_nodes / correct);
+   }
    CLEAR (flags, SOLVE);
 }
 
@@ -253,6 +253,15 @@ int main (int argc, char *argv[])
 
   progname = argv[0]; /* Save in global for cmd_usage */
 
+  /* Adapter tools take their own options, e.g. "gnuchess epd-test -epd file" */
+  if ( argc >= 2 && ( strcmp( argv[1], "epd-test" ) == 0 ||
+                      strcmp( argv[1], "make-book" ) == 0 ||
+                      strcmp( argv[1], "merge-book" ) == 0 ||
+                      strcmp( argv[1], "make-gamedb" ) == 0 ||
+                      strcmp( argv[1], "find-games" ) == 0 ) ) {
+    return RunAdapterTool( argc, argv );
+  }
+
   while (1)
   {
     static struct option long_options[] =
@@ -491,6 +500,7 @@ There is NO WARRANTY, to the extent permitted by law.\n"),
    *         Add user input to user input buffer
    *     If engine input is ready for reading (select)
    *         Add engine input to engine input buffer
+   *     Wait until there is something new to process (poll)
    */
 
   //usleep(3000); /* So that Polyglot's and Fruit's banner has enough time to be displayed */
@@ -515,8 +525,10 @@ There is NO WARRANTY, to the extent permitted by law.\n"),
       /* Check if engine input ready for reading. If so, store it in a buffer. */
       ReadFromEngine();
     }
-    /* Avoid using 100% CPU */
-    usleep(100);
+    /* Sleep until the user or the engine has something for us */
+    if ( !(flags & QUIT) ) {
+      WaitForInput();
+    }
   }
 
   dbg_close();
@@ -0,0 +1,250 @@
+/* GNU Chess 6 - polybook.cc - Polyglot opening book reader
+
+   Copyright (c) 2001-2021 Free Software Foundation, Inc.
+
+   GNU Chess is based on the two research programs
+   Cobalt by Chua Kong-Sian and Gazebo by Stuart Cracraft.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   Contact Info:
+     bug-gnu-chess@gnu.org
+     cracraft@ai.mit.edu, cracraft@stanfordalumni.org, cracraft@earthlink.net
+*/
+
+#include <config.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "polybook.h"
+
+/* One index item per this many entries, i.e. 16 pages of the file */
+#define POLYBOOK_BUCKET_SIZE 4096
+
+/* Largest index: 2^20 items, 8 MB */
+#define POLYBOOK_INDEX_BITS_MAX 20
+
+static uint64_t decode( const unsigned char *p, int size )
+{
+  uint64_t n = 0;
+  int i;
+
+  for ( i = 0; i < size; i++ ) {
+    n = ( n << 8 ) | p[i];
+  }
+  return n;
+}
+
+static void encode( unsigned char *p, int size, uint64_t n )
+{
+  int i;
+
+  for ( i = size - 1; i >= 0; i-- ) {
+    p[i] = n & 0xFF;
+    n >>= 8;
+  }
+}
+
+/*
+ * Returns the first entry in [left, right) whose key is not less
+ * than 'key', or 'right' if there is none.
+ */
+static size_t lower_bound( const polybook_t *book, uint64_t key, size_t left, size_t right )
+{
+  size_t mid;
+
+  while ( left < right ) {
+    mid = left + ( right - left ) / 2;
+    if ( polybook_key( book, mid ) < key ) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
+}
+
+/*
+ * The index is filled with one binary search per prefix, each starting
+ * where the previous one ended, so that only about one page in sixteen
+ * is read when the book is opened.
+ */
+static int index_build( polybook_t *book )
+{
+  size_t nb, p;
+  int bits;
+
+  bits = 0;
+  while ( bits < POLYBOOK_INDEX_BITS_MAX
+          && ( book->size >> bits ) > POLYBOOK_BUCKET_SIZE ) {
+    bits++;
+  }
+  if ( bits == 0 ) {
+    return 0; /* small book, the binary search is enough */
+  }
+
+  nb = (size_t) 1 << bits;
+  book->index = (size_t *) malloc( ( nb + 1 ) * sizeof(size_t) );
+  if ( book->index == NULL ) {
+    return -1;
+  }
+  book->index[0] = 0;
+  for ( p = 1; p < nb; p++ ) {
+    book->index[p] = lower_bound( book, (uint64_t) p << ( 64 - bits ),
+                                  book->index[p-1], book->size );
+  }
+  book->index[nb] = book->size;
+  book->index_bits = bits;
+  return 0;
+}
+
+void polybook_clear( polybook_t *book )
+{
+  book->data = NULL;
+  book->size = 0;
+  book->map_size = 0;
+  book->flags = 0;
+  book->index_bits = 0;
+  book->index = NULL;
+}
+
+int polybook_open( polybook_t *book, const char file_name[], int flags )
+{
+  struct stat st;
+  int fd, err;
+  void *map;
+
+  polybook_close( book );
+
+  fd = open( file_name, ( flags & POLYBOOK_WRITE ) ? O_RDWR : O_RDONLY );
+  if ( fd == -1 ) {
+    return -1;
+  }
+  if ( fstat( fd, &st ) == -1 ) {
+    err = errno;
+    close( fd );
+    errno = err;
+    return -1;
+  }
+
+  book->flags = flags;
+  book->size = (size_t) st.st_size / POLYBOOK_ENTRY_SIZE;
+  book->map_size = book->size * POLYBOOK_ENTRY_SIZE;
+
+  if ( book->map_size != 0 ) {
+    map = mmap( NULL, book->map_size,
+                ( flags & POLYBOOK_WRITE ) ? PROT_READ | PROT_WRITE : PROT_READ,
+                MAP_SHARED, fd, 0 );
+    if ( map == MAP_FAILED ) {
+      err = errno;
+      close( fd );
+      polybook_clear( book );
+      errno = err;
+      return -1;
+    }
+    book->data = (unsigned char *) map;
+    /* Probes are scattered over the whole file, unless it is merged */
+    madvise( book->data, book->map_size,
+             ( flags & POLYBOOK_SEQUENTIAL ) ? MADV_SEQUENTIAL : MADV_RANDOM );
+  }
+
+  /* The mapping stays valid after the descriptor is closed */
+  close( fd );
+
+  if ( ( flags & POLYBOOK_INDEX ) && index_build( book ) == -1 ) {
+    err = errno;
+    polybook_close( book );
+    errno = err;
+    return -1;
+  }
+  return 0;
+}
+
+void polybook_close( polybook_t *book )
+{
+  if ( book->data != NULL ) {
+    munmap( book->data, book->map_size );
+  }
+  free( book->index );
+  polybook_clear( book );
+}
+
+size_t polybook_find( const polybook_t *book, uint64_t key )
+{
+  size_t left, right, pos;
+  uint64_t p;
+
+  if ( book->index_bits != 0 ) {
+    p = key >> ( 64 - book->index_bits );
+    left = book->index[p];
+    right = book->index[p+1];
+  } else {
+    left = 0;
+    right = book->size;
+  }
+
+  pos = lower_bound( book, key, left, right );
+  if ( pos < right && polybook_key( book, pos ) == key ) {
+    return pos;
+  }
+  return book->size;
+}
+
+uint64_t polybook_key( const polybook_t *book, size_t n )
+{
+  return decode( book->data + n * POLYBOOK_ENTRY_SIZE, 8 );
+}
+
+void polybook_read( const polybook_t *book, size_t n, polybook_entry_t *entry )
+{
+  const unsigned char *p = book->data + n * POLYBOOK_ENTRY_SIZE;
+
+  entry->key   = decode( p, 8 );
+  entry->move  = decode( p + 8, 2 );
+  entry->count = decode( p + 10, 2 );
+  entry->n     = decode( p + 12, 2 );
+  entry->sum   = decode( p + 14, 2 );
+}
+
+void polybook_write( polybook_t *book, size_t n, const polybook_entry_t *entry )
+{
+  unsigned char *p = book->data + n * POLYBOOK_ENTRY_SIZE;
+
+  encode( p, 8, entry->key );
+  encode( p + 8, 2, entry->move );
+  encode( p + 10, 2, entry->count );
+  encode( p + 12, 2, entry->n );
+  encode( p + 14, 2, entry->sum );
+}
+
+int polybook_flush( polybook_t *book )
+{
+  if ( book->data == NULL || !( book->flags & POLYBOOK_WRITE ) ) {
+    return 0;
+  }
+  return msync( book->data, book->map_size, MS_ASYNC );
+}
+
+int polybook_sync( polybook_t *book )
+{
+  if ( book->data == NULL || !( book->flags & POLYBOOK_WRITE ) ) {
+    return 0;
+  }
+  return msync( book->data, book->map_size, MS_SYNC );
+}
@@ -0,0 +1,95 @@
+/* GNU Chess 6 - polybook.h - Polyglot opening book reader
+
+   Copyright (c) 2001-2021 Free Software Foundation, Inc.
+
+   GNU Chess is based on the two research programs
+   Cobalt by Chua Kong-Sian and Gazebo by Stuart Cracraft.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   Contact Info:
+     bug-gnu-chess@gnu.org
+     cracraft@ai.mit.edu, cracraft@stanfordalumni.org, cracraft@earthlink.net
+*/
+
+#ifndef POLYBOOK_H
+#define POLYBOOK_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Polyglot book shared by the engine and the adapter.
+ *
+ * The file is mapped in memory and its 16-byte big-endian entries,
+ * sorted by key, are decoded in place. A lookup is a binary search over
+ * the mapped array; with POLYBOOK_INDEX, a table of the first entry of
+ * each key prefix narrows it down to a few pages of the file.
+ */
+
+/* Open flags */
+#define POLYBOOK_WRITE      1  /* entries can be updated (book learning) */
+#define POLYBOOK_INDEX      2  /* build the key-prefix index */
+#define POLYBOOK_SEQUENTIAL 4  /* entries are read in order (merging) */
+
+/* Size of a book entry in the file */
+#define POLYBOOK_ENTRY_SIZE 16
+
+typedef struct {
+  uint64_t key;
+  uint16_t move;
+  uint16_t count;
+  uint16_t n;
+  uint16_t sum;
+} polybook_entry_t;
+
+typedef struct {
+  unsigned char *data;   /* mapped file, NULL if none */
+  size_t size;           /* number of entries */
+  size_t map_size;       /* bytes mapped */
+  int flags;
+  int index_bits;        /* 0 if there is no index */
+  size_t *index;         /* first entry of each key prefix, 2^bits+1 items */
+} polybook_t;
+
+/* Makes 'book' an empty, closed book. */
+void polybook_clear( polybook_t *book );
+
+/* Maps the file, closing the book first if needed. Returns -1 with
+   errno set on failure. */
+int polybook_open( polybook_t *book, const char file_name[], int flags );
+
+/* Unmaps the file; the book is then empty. */
+void polybook_close( polybook_t *book );
+
+/* Returns the first entry for 'key', or the book size if none. */
+size_t polybook_find( const polybook_t *book, uint64_t key );
+
+/* Key of entry 'n', 0 <= n < size. */
+uint64_t polybook_key( const polybook_t *book, size_t n );
+
+/* Decodes entry 'n', 0 <= n < size. */
+void polybook_read( const polybook_t *book, size_t n, polybook_entry_t *entry );
+
+/* Encodes entry 'n' in place; the book must be open with POLYBOOK_WRITE. */
+void polybook_write( polybook_t *book, size_t n, const polybook_entry_t *entry );
+
+/* Schedules the updated entries to be written to the file. Returns -1
+   with errno set on failure. */
+int polybook_flush( polybook_t *book );
+
+/* Same as polybook_flush(), but waits until they are on disk. */
+int polybook_sync( polybook_t *book );
+
+#endif /* POLYBOOK_H */
@@ -0,0 +1,254 @@
+/* GNU Chess 6 - queue.cc - Message queues shared across modules
+
+   Copyright (c) 2001-2021 Free Software Foundation, Inc.
+
+   GNU Chess is based on the two research programs
+   Cobalt by Chua Kong-Sian and Gazebo by Stuart Cracraft.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   Contact Info:
+     bug-gnu-chess@gnu.org
+     cracraft@ai.mit.edu, cracraft@stanfordalumni.org, cracraft@earthlink.net
+*/
+
+#include <config.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+
+#include "queue.h"
+
+/*
+ * Memory ordering: the producer publishes 'tail' and then looks at
+ * 'head' to decide whether the consumer must be woken up; the consumer
+ * publishes 'head' and then looks at 'tail' before going to sleep. All
+ * four accesses are sequentially consistent, so at least one side always
+ * sees the other's update and no wakeup can be lost.
+ */
+
+static void wakeup_init( int fd[2] )
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  fd[0] = fd[1] = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+  if ( fd[0] == -1 ) {
+    printf( "Error while creating eventfd.\n" );
+    exit( 1 );
+  }
+#else
+  if ( pipe( fd ) != 0 ) {
+    printf( "Error while creating pipe.\n" );
+    exit( 1 );
+  }
+  fcntl( fd[0], F_SETFL, fcntl( fd[0], F_GETFL ) | O_NONBLOCK );
+  fcntl( fd[1], F_SETFL, fcntl( fd[1], F_GETFL ) | O_NONBLOCK );
+#endif
+}
+
+static void wakeup_signal( int fd[2] )
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  uint64_t one = 1;
+  ssize_t r = write( fd[1], &one, sizeof(one) );
+#else
+  char one = 1;
+  ssize_t r = write( fd[1], &one, 1 );
+#endif
+  /* EAGAIN means the descriptor is already readable */
+  (void) r;
+}
+
+static void wakeup_clear( int fd[2] )
+{
+  char junk[64];
+  while ( read( fd[0], junk, sizeof(junk) ) > 0 ) {
+    /* eventfd is emptied by one read, a pipe may need several */
+  }
+}
+
+static void wakeup_wait( int fd[2] )
+{
+  struct pollfd pfd[1];
+  pfd->fd = fd[0];
+  pfd->events = POLLIN;
+  pfd->revents = 0;
+  while ( poll( pfd, 1, -1 ) == -1 && errno == EINTR ) {
+  }
+}
+
+/*
+ * Returns 1 if data or EOF is pending. When the queue is found empty,
+ * the wakeup descriptor is reset, and set again if some data arrived
+ * in the meantime.
+ */
+static int queue_pending( queue_t *q )
+{
+  unsigned int head = q->head.load( std::memory_order_relaxed );
+
+  if ( q->tail.load() != head || q->closed.load() ) {
+    return 1;
+  }
+  wakeup_clear( q->data_fd );
+  if ( q->tail.load() != head || q->closed.load() ) {
+    wakeup_signal( q->data_fd );
+    return 1;
+  }
+  return 0;
+}
+
+/*
+ * Publishes the new read position and keeps both wakeup descriptors
+ * consistent with the queue contents.
+ */
+static void queue_consumed( queue_t *q, unsigned int head )
+{
+  q->head.store( head );
+  if ( q->writer_waiting.load() ) {
+    wakeup_signal( q->space_fd );
+  }
+  queue_pending( q );
+}
+
+void queue_init( queue_t *q )
+{
+  q->head.store( 0 );
+  q->tail.store( 0 );
+  q->closed.store( 0 );
+  q->writer_waiting.store( 0 );
+  q->line_len = 0;
+  wakeup_init( q->data_fd );
+  wakeup_init( q->space_fd );
+}
+
+int queue_fd( const queue_t *q )
+{
+  return q->data_fd[0];
+}
+
+void queue_write( queue_t *q, const char data[], int size )
+{
+  unsigned int head, tail, pos, space, n, chunk;
+
+  while ( size > 0 ) {
+    tail = q->tail.load( std::memory_order_relaxed );
+    head = q->head.load();
+    space = QUEUE_SIZE - ( tail - head );
+    if ( space == 0 ) {
+      /* Queue full: wait until the consumer frees some space */
+      wakeup_clear( q->space_fd );
+      q->writer_waiting.store( 1 );
+      if ( q->head.load() == head ) {
+        wakeup_wait( q->space_fd );
+      }
+      q->writer_waiting.store( 0 );
+      continue;
+    }
+    n = ( (unsigned int) size < space ? (unsigned int) size : space );
+    pos = tail & ( QUEUE_SIZE - 1 );
+    chunk = ( n < QUEUE_SIZE - pos ? n : QUEUE_SIZE - pos );
+    memcpy( &q->buf[pos], data, chunk );
+    memcpy( &q->buf[0], data + chunk, n - chunk );
+    q->tail.store( tail + n );
+    /* Wake up the consumer if it may have seen the queue empty */
+    if ( q->head.load() == tail ) {
+      wakeup_signal( q->data_fd );
+    }
+    data += n;
+    size -= n;
+  }
+}
+
+void queue_close( queue_t *q )
+{
+  q->closed.store( 1 );
+  wakeup_signal( q->data_fd );
+}
+
+int queue_ready( queue_t *q )
+{
+  return queue_pending( q );
+}
+
+int queue_read( queue_t *q, char data[], int size )
+{
+  unsigned int head, tail, pos, n, chunk;
+
+  while ( true ) {
+    head = q->head.load( std::memory_order_relaxed );
+    tail = q->tail.load();
+    if ( tail != head ) {
+      n = tail - head;
+      if ( n > (unsigned int) size ) n = size;
+      pos = head & ( QUEUE_SIZE - 1 );
+      chunk = ( n < QUEUE_SIZE - pos ? n : QUEUE_SIZE - pos );
+      memcpy( data, &q->buf[pos], chunk );
+      memcpy( data + chunk, &q->buf[0], n - chunk );
+      queue_consumed( q, head + n );
+      return n;
+    }
+    if ( q->closed.load() && q->tail.load() == head ) {
+      return 0;
+    }
+    if ( !queue_pending( q ) ) {
+      wakeup_wait( q->data_fd );
+    }
+  }
+}
+
+int queue_get_line( queue_t *q, char line[], int size )
+{
+  unsigned int head, tail;
+  int c, eol, len;
+
+  while ( true ) {
+    /* Move the available bytes of the current line to the consumer's
+       buffer, so that a partial line leaves the queue empty and the
+       producer wakes us up when the rest arrives. */
+    head = q->head.load( std::memory_order_relaxed );
+    tail = q->tail.load();
+    eol = 0;
+    while ( head != tail && q->line_len < QUEUE_SIZE ) {
+      c = q->buf[head++ & ( QUEUE_SIZE - 1 )];
+      if ( c == '\n' ) {
+        eol = 1;
+        break;
+      }
+      if ( c != '\r' ) q->line[q->line_len++] = c;
+    }
+    if ( head != q->head.load( std::memory_order_relaxed ) ) {
+      queue_consumed( q, head );
+    }
+    if ( !eol && q->line_len < QUEUE_SIZE ) {
+      if ( !q->closed.load() || q->tail.load() != head ) {
+        if ( !queue_pending( q ) ) wakeup_wait( q->data_fd );
+        continue;
+      }
+      if ( q->line_len == 0 ) return 0; /* EOF */
+    }
+    len = ( q->line_len < size ? q->line_len : size - 1 );
+    memcpy( line, q->line, len );
+    line[len] = '\0';
+    q->line_len = 0;
+    return 1;
+  }
+}
@@ -0,0 +1,80 @@
+/* GNU Chess 6 - queue.h - Message queues shared across modules
+
+   Copyright (c) 2001-2021 Free Software Foundation, Inc.
+
+   GNU Chess is based on the two research programs
+   Cobalt by Chua Kong-Sian and Gazebo by Stuart Cracraft.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   Contact Info:
+     bug-gnu-chess@gnu.org
+     cracraft@ai.mit.edu, cracraft@stanfordalumni.org, cracraft@earthlink.net
+*/
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <atomic>
+
+/*
+ * Single-producer/single-consumer byte queue carrying the text lines
+ * exchanged by the frontend, adapter and engine threads.
+ *
+ * The ring itself is lock-free. A wakeup descriptor (an eventfd, or a
+ * pipe where eventfd is not available) is readable whenever the queue
+ * may hold data or has been closed, so that consumers can keep waiting
+ * for several queues at once with select() or poll().
+ */
+
+/* Must be a power of two */
+#define QUEUE_SIZE 65536
+
+typedef struct {
+  std::atomic<unsigned int> head;     /* read position, owned by the consumer */
+  std::atomic<unsigned int> tail;     /* write position, owned by the producer */
+  std::atomic<int> closed;            /* no more data will be written */
+  std::atomic<int> writer_waiting;    /* the producer waits for free space */
+  int data_fd[2];                     /* wakeup for the consumer */
+  int space_fd[2];                    /* wakeup for the producer */
+  char buf[QUEUE_SIZE];
+  int line_len;                       /* queue_get_line() only */
+  char line[QUEUE_SIZE];
+} queue_t;
+
+/* Creates the queue and its wakeup descriptors, exits on failure. */
+void queue_init( queue_t *q );
+
+/* Descriptor that becomes readable when data or EOF may be pending. */
+int queue_fd( const queue_t *q );
+
+/* Appends 'size' bytes, blocking while the queue is full. */
+void queue_write( queue_t *q, const char data[], int size );
+
+/* Marks the end of the data and wakes up the consumer. */
+void queue_close( queue_t *q );
+
+/* Returns 1 if data or EOF is pending, without blocking. */
+int queue_ready( queue_t *q );
+
+/* Reads at most 'size' bytes, blocking until at least one is available.
+   Returns 0 at EOF. */
+int queue_read( queue_t *q, char data[], int size );
+
+/* Reads one line without its '\n', blocking until it is complete.
+   Returns 0 at EOF. A queue must be read either with queue_read() or
+   with queue_get_line(), not both. */
+int queue_get_line( queue_t *q, char line[], int size );
+
+#endif /* QUEUE_H */
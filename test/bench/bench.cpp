@@ -0,0 +1,568 @@
+/* bench.cpp
+
+   GNU Chess engine micro-benchmarks
+
+   Copyright (C) 2001-2021 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// bench.cpp
+
+// Times the engine hot kernels in isolation over the positions of one or
+// more EPD files and prints one machine-readable record per kernel.
+//
+// usage: bench [-csv | -json] [-iter N] [file.epd ...]
+
+// includes
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include "engine/attack.h"
+#include "engine/board.h"
+#include "engine/colour.h"
+#include "engine/eval.h"
+#include "engine/fen.h"
+#include "engine/hash.h"
+#include "engine/list.h"
+#include "engine/material.h"
+#include "engine/move.h"
+#include "engine/move_do.h"
+#include "engine/move_gen.h"
+#include "engine/option.h"
+#include "engine/pawn.h"
+#include "engine/piece.h"
+#include "engine/pst.h"
+#include "engine/random.h"
+#include "engine/see.h"
+#include "engine/square.h"
+#include "engine/trans.h"
+#include "engine/util.h"
+#include "engine/value.h"
+#include "engine/vector.h"
+
+using namespace engine;
+
+// constants
+
+static const int PositionMax = 4096;
+static const int FenSize = 256;
+
+static const char * const DefaultFile[] = {
+   "../BT2630.epd", "../iq6.epd", "../endgame.epd", NULL,
+};
+
+// types
+
+struct position_t {
+   char fen[FenSize];
+   board_t board[1];
+   bool check;
+};
+
+struct result_t {
+   const char * kernel;
+   sint64 calls;
+   double seconds;
+   uint64 checksum;
+};
+
+// variables
+
+static position_t * Position;
+static int PositionNb;
+
+static int Iterations = 100;
+static bool Json = false;
+
+static int ResultNb;
+
+// prototypes
+
+static void   bench_init     ();
+static void   load_epd       (const char file_name[]);
+
+static double now            ();
+
+static void   report_begin   ();
+static void   report         (const result_t * result);
+static void   report_end     ();
+
+static void   bench_fen      (result_t * result);
+static void   bench_gen_moves    (result_t * result);
+static void   bench_gen_captures (result_t * result);
+static void   bench_move_do  (result_t * result);
+static void   bench_eval     (result_t * result);
+static void   bench_see      (result_t * result);
+static void   bench_trans    (result_t * result);
+static void   bench_attack   (result_t * result);
+
+// functions
+
+// main()
+
+int main(int argc, char * argv[]) {
+
+   int file_nb;
+   int i;
+   result_t result[1];
+
+   Position = (position_t *) my_malloc(PositionMax*sizeof(position_t));
+   PositionNb = 0;
+
+   file_nb = 0;
+
+   for (i = 1; i < argc; i++) {
+
+      if (false) {
+
+      } else if (my_string_equal(argv[i],"-csv")) {
+
+         Json = false;
+
+      } else if (my_string_equal(argv[i],"-json")) {
+
+         Json = true;
+
+      } else if (my_string_equal(argv[i],"-iter")) {
+
+         i++;
+         if (argv[i] == NULL) my_fatal("bench: missing argument\n");
+         Iterations = atoi(argv[i]);
+         if (Iterations < 1) my_fatal("bench: bad iteration count\n");
+
+      } else if (argv[i][0] == '-') {
+
+         my_fatal("bench: unknown option \"%s\"\n",argv[i]);
+
+      } else {
+
+         load_epd(argv[i]);
+         file_nb++;
+      }
+   }
+
+   if (file_nb == 0) {
+      for (i = 0; DefaultFile[i] != NULL; i++) load_epd(DefaultFile[i]);
+   }
+
+   if (PositionNb == 0) my_fatal("bench: no positions\n");
+
+   bench_init();
+
+   for (i = 0; i < PositionNb; i++) {
+      board_from_fen(Position[i].board,Position[i].fen);
+      Position[i].check = board_is_check(Position[i].board);
+   }
+
+   report_begin();
+
+   bench_fen(result);
+   report(result);
+
+   bench_gen_moves(result);
+   report(result);
+
+   bench_gen_captures(result);
+   report(result);
+
+   bench_move_do(result);
+   report(result);
+
+   bench_eval(result);
+   report(result);
+
+   bench_see(result);
+   report(result);
+
+   bench_trans(result);
+   report(result);
+
+   bench_attack(result);
+   report(result);
+
+   report_end();
+
+   return EXIT_SUCCESS;
+}
+
+// bench_init()
+
+static void bench_init() {
+
+   // same order as main_engine() and init() in protocol.cpp
+
+   option_init();
+
+   square_init();
+   piece_init();
+   pawn_init_bit();
+   value_init();
+   vector_init();
+   attack_init();
+   move_do_init();
+
+   random_init();
+   hash_init();
+
+   trans_init(Trans);
+   trans_alloc(Trans);
+
+   pawn_init();
+   pawn_alloc();
+
+   material_init();
+   material_alloc();
+
+   pst_init();
+   eval_init();
+}
+
+// load_epd()
+
+static void load_epd(const char file_name[]) {
+
+   FILE * file;
+   char line[FenSize];
+   char * ptr;
+   int field;
+
+   ASSERT(file_name!=NULL);
+
+   file = fopen(file_name,"r");
+   if (file == NULL) my_fatal("bench: can't open file \"%s\"\n",file_name);
+
+   while (fgets(line,FenSize,file) != NULL) {
+
+      if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+
+      if (PositionNb >= PositionMax) my_fatal("bench: too many positions\n");
+
+      // keep the four FEN fields of the EPD record
+
+      field = 0;
+
+      for (ptr = line; *ptr != '\0'; ptr++) {
+         if (*ptr == ' ' && ++field == 4) break;
+      }
+
+      if (field != 4) continue;
+
+      *ptr = '\0';
+      strcpy(Position[PositionNb].fen,line);
+      PositionNb++;
+   }
+
+   fclose(file);
+}
+
+// now()
+
+static double now() {
+
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+
+   return double(ts.tv_sec) + double(ts.tv_nsec) * 1.0E-9;
+}
+
+// report_begin()
+
+static void report_begin() {
+
+   ResultNb = 0;
+
+   if (Json) {
+      printf("{\n \"positions\": %d,\n \"iterations\": %d,\n \"kernels\": [\n",PositionNb,Iterations);
+   } else {
+      printf("kernel,positions,iterations,calls,total_ms,ns_per_call,checksum\n");
+   }
+}
+
+// report()
+
+static void report(const result_t * result) {
+
+   double ns;
+
+   ASSERT(result!=NULL);
+
+   ns = (result->calls == 0) ? 0.0 : result->seconds * 1.0E9 / double(result->calls);
+
+   if (Json) {
+      printf("%s  {\"kernel\": \"%s\", \"calls\": " S64_FORMAT ", \"total_ms\": %.3f, \"ns_per_call\": %.2f, \"checksum\": \"%016llX\"}",
+             (ResultNb == 0) ? "" : ",\n",result->kernel,result->calls,result->seconds*1000.0,ns,(unsigned long long)result->checksum);
+   } else {
+      printf("%s,%d,%d," S64_FORMAT ",%.3f,%.2f,%016llX\n",
+             result->kernel,PositionNb,Iterations,result->calls,result->seconds*1000.0,ns,(unsigned long long)result->checksum);
+   }
+
+   ResultNb++;
+
+   fflush(stdout);
+}
+
+// report_end()
+
+static void report_end() {
+
+   if (Json) printf("\n ]\n}\n");
+}
+
+// bench_fen()
+
+static void bench_fen(result_t * result) {
+
+   board_t board[1];
+   int iter, pos;
+   double start;
+
+   result->kernel = "board_from_fen";
+   result->calls = 0;
+   result->checksum = 0;
+
+   start = now();
+
+   for (iter = 0; iter < Iterations; iter++) {
+      for (pos = 0; pos < PositionNb; pos++) {
+         board_from_fen(board,Position[pos].fen);
+         result->checksum += board->key;
+         result->calls++;
+      }
+   }
+
+   result->seconds = now() - start;
+}
+
+// bench_gen_moves()
+
+static void bench_gen_moves(result_t * result) {
+
+   list_t list[1];
+   int iter, pos;
+   double start;
+
+   result->kernel = "gen_moves";
+   result->calls = 0;
+   result->checksum = 0;
+
+   start = now();
+
+   for (iter = 0; iter < Iterations; iter++) {
+      for (pos = 0; pos < PositionNb; pos++) {
+         if (Position[pos].check) continue;
+         gen_moves(list,Position[pos].board);
+         result->checksum += LIST_SIZE(list);
+         result->calls++;
+      }
+   }
+
+   result->seconds = now() - start;
+}
+
+// bench_gen_captures()
+
+static void bench_gen_captures(result_t * result) {
+
+   list_t list[1];
+   int iter, pos;
+   double start;
+
+   result->kernel = "gen_captures";
+   result->calls = 0;
+   result->checksum = 0;
+
+   start = now();
+
+   for (iter = 0; iter < Iterations; iter++) {
+      for (pos = 0; pos < PositionNb; pos++) {
+         if (Position[pos].check) continue;
+         gen_captures(list,Position[pos].board);
+         result->checksum += LIST_SIZE(list);
+         result->calls++;
+      }
+   }
+
+   result->seconds = now() - start;
+}
+
+// bench_move_do()
+
+static void bench_move_do(result_t * result) {
+
+   list_t list[1];
+   undo_t undo[1];
+   board_t * board;
+   int iter, pos, i, move;
+   double start;
+
+   result->kernel = "move_do/move_undo";
+   result->calls = 0;
+   result->checksum = 0;
+   result->seconds = 0.0;
+
+   for (pos = 0; pos < PositionNb; pos++) {
+
+      board = Position[pos].board;
+      gen_legal_moves(list,board); // not timed
+
+      start = now();
+
+      for (iter = 0; iter < Iterations; iter++) {
+         for (i = 0; i < LIST_SIZE(list); i++) {
+            move = LIST_MOVE(list,i);
+            move_do(board,move,undo);
+            result->checksum += board->key;
+            move_undo(board,move,undo);
+            result->calls++;
+         }
+      }
+
+      result->seconds += now() - start;
+   }
+}
+
+// bench_eval()
+
+static void bench_eval(result_t * result) {
+
+   int iter, pos;
+   double start;
+
+   result->kernel = "eval";
+   result->calls = 0;
+   result->checksum = 0;
+
+   pawn_clear();
+   material_clear();
+
+   start = now();
+
+   for (iter = 0; iter < Iterations; iter++) {
+      for (pos = 0; pos < PositionNb; pos++) {
+         if (Position[pos].check) continue;
+         result->checksum += eval(Position[pos].board);
+         result->calls++;
+      }
+   }
+
+   result->seconds = now() - start;
+}
+
+// bench_see()
+
+static void bench_see(result_t * result) {
+
+   list_t list[1];
+   board_t * board;
+   int iter, pos, i;
+   double start;
+
+   result->kernel = "see_move";
+   result->calls = 0;
+   result->checksum = 0;
+   result->seconds = 0.0;
+
+   for (pos = 0; pos < PositionNb; pos++) {
+
+      if (Position[pos].check) continue;
+
+      board = Position[pos].board;
+      gen_captures(list,board); // not timed
+
+      start = now();
+
+      for (iter = 0; iter < Iterations; iter++) {
+         for (i = 0; i < LIST_SIZE(list); i++) {
+            result->checksum += see_move(LIST_MOVE(list,i),board);
+            result->calls++;
+         }
+      }
+
+      result->seconds += now() - start;
+   }
+}
+
+// bench_trans()
+
+static void bench_trans(result_t * result) {
+
+   int iter, pos;
+   int move, min_depth, max_depth, min_value, max_value;
+   uint64 key;
+   double start;
+
+   result->kernel = "trans_store/trans_retrieve";
+   result->calls = 0;
+   result->checksum = 0;
+
+   trans_clear(Trans);
+
+   start = now();
+
+   for (iter = 0; iter < Iterations; iter++) {
+
+      for (pos = 0; pos < PositionNb; pos++) {
+         key = Position[pos].board->key + uint64(iter);
+         trans_store(Trans,key,MoveNone,iter&15,-pos,+pos);
+         result->calls++;
+      }
+
+      for (pos = 0; pos < PositionNb; pos++) {
+         key = Position[pos].board->key + uint64(iter);
+         if (trans_retrieve(Trans,key,&move,&min_depth,&max_depth,&min_value,&max_value)) {
+            result->checksum += uint64(min_depth + max_value);
+         }
+         result->calls++;
+      }
+   }
+
+   result->seconds = now() - start;
+}
+
+// bench_attack()
+
+static void bench_attack(result_t * result) {
+
+   board_t * board;
+   int iter, pos, i, sq;
+   double start;
+
+   result->kernel = "is_attacked";
+   result->calls = 0;
+   result->checksum = 0;
+
+   start = now();
+
+   for (iter = 0; iter < Iterations; iter++) {
+      for (pos = 0; pos < PositionNb; pos++) {
+         board = Position[pos].board;
+         for (i = 0; i < 64; i++) {
+            sq = SQUARE_FROM_64(i);
+            if (is_attacked(board,sq,White)) result->checksum++;
+            if (is_attacked(board,sq,Black)) result->checksum += 2;
+            result->calls += 2;
+         }
+      }
+   }
+
+   result->seconds = now() - start;
+}
+
+// end of bench.cpp
@@ -0,0 +1,14 @@
+// components.cc
+
+#include "components.h"
+
+// The engine objects refer to the queues set up by the frontend; the
+// benchmark never starts the engine thread, so they are left unused.
+
+queue_t queue_i2f[1];
+
+queue_t queue_f2a[1];
+queue_t queue_a2f[1];
+
+queue_t queue_a2e[1];
+queue_t queue_e2a[1];
@@ -75,3 +75,51 @@ TEST_CASE("A game can be saved to a file in PGN format", "[PGNSaveToFile]") {
         remove(test_pgn_filename);
     }
 }
+
+TEST_CASE("A game of a PGN file can be found through its index", "[PGNFindGame]") {
+
+    // int PGNFindGame (const char *file, int n, off_t *start, off_t *end)
+
+    const char test_pgn_filename[] = ".tmp.pgn";
+    const char test_index_filename[] = ".tmp.pgn.pgi";
+    const char game1[] = "[Event \"a\"]\n[Result \"1-0\"]\n\n1. e4 {[not a tag]\n[Event \"b\"]} e5 1-0\n\n";
+    const char game2[] = "[Event \"c\"]\n\n; [comment\n1. d4 d5 *\n\n";
+    const char game3[] = "[Event \"d\"]\n\n1. c4 *\n";
+    off_t start, end;
+
+    remove(test_index_filename);
+    {
+        std::ofstream test_pgn_file(test_pgn_filename);
+        test_pgn_file << game1 << game2 << game3;
+    }
+
+    SECTION("The offsets of each game are returned") {
+        REQUIRE( PGNFindGame(test_pgn_filename, 2, &start, &end) == 1 );
+        REQUIRE( start == (off_t) strlen(game1) );
+        REQUIRE( end == (off_t) (strlen(game1) + strlen(game2)) );
+        REQUIRE( PGNFindGame(test_pgn_filename, 1, &start, &end) == 1 );
+        REQUIRE( start == 0 );
+        REQUIRE( PGNFindGame(test_pgn_filename, 3, &start, &end) == 1 );
+        REQUIRE( end == (off_t) (strlen(game1) + strlen(game2) + strlen(game3)) );
+    }
+
+    SECTION("Games out of range are not found") {
+        REQUIRE( PGNFindGame(test_pgn_filename, 0, &start, &end) == 0 );
+        REQUIRE( PGNFindGame(test_pgn_filename, 4, &start, &end) == 0 );
+    }
+
+    SECTION("The index is saved and rebuilt when the file changes") {
+        REQUIRE( PGNFindGame(test_pgn_filename, 1, &start, &end) == 1 );
+        FILE *f = fopen(test_index_filename, "r");
+        REQUIRE( f != NULL );
+        fclose(f);
+        {
+            std::ofstream test_pgn_file(test_pgn_filename, std::ios::app);
+            test_pgn_file << "\n" << game3;
+        }
+        REQUIRE( PGNFindGame(test_pgn_filename, 4, &start, &end) == 1 );
+    }
+
+    remove(test_pgn_filename);
+    remove(test_index_filename);
+}
@@ -0,0 +1,320 @@
+/* tracestat.cpp
+
+   GNU Chess search-trace summary
+
+   Copyright (C) 2001-2021 Free Software Foundation, Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// tracestat.cpp
+
+// Summarises a search-tree trace written by an engine built with
+// --enable-search-trace (UCI options "Trace File" and "Trace Size"):
+// per ply, the number of nodes, the share of quiescence nodes, the
+// branching factor, subtree sizes and how the nodes were cut off.
+//
+// usage: tracestat [-csv] file.trace
+
+// includes
+
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "engine/trace.h"
+#include "engine/util.h"
+
+using namespace engine;
+
+// constants
+
+static const int HeightMax = 256;
+static const int BucketNb = 40; // log2 of subtree sizes
+
+static const char * const ReasonName[TraceReasonNb] = {
+   "none", "beta", "trans", "null", "standpat", "draw", "mate", "height",
+};
+
+// types
+
+struct frame_t {
+   int height;
+   uint64 first_node;
+   uint64 child_nb;
+};
+
+struct ply_t {
+   uint64 node_nb;
+   uint64 qs_nb;
+   uint64 exit_nb;
+   uint64 interior_nb;
+   uint64 child_nb;
+   double subtree_sum;
+   uint64 subtree_max;
+   uint64 reason_nb[TraceReasonNb];
+};
+
+// variables
+
+static ply_t Ply[HeightMax];
+static uint64 Bucket[BucketNb];
+
+static frame_t Stack[HeightMax*2];
+static int StackSize;
+
+static uint64 NodeNb;
+static uint64 OrphanNb;
+static int SearchNb;
+
+// prototypes
+
+static void replay  (const trace_record_t * record);
+static void report  (bool csv);
+
+static int  log2_of (uint64 n);
+
+static void fatal   (const char format[], ...);
+
+// functions
+
+// main()
+
+int main(int argc, char * argv[]) {
+
+   const char * file_name;
+   bool csv;
+   int i, fd;
+   struct stat st;
+   void * map;
+   const trace_header_t * header;
+   const trace_record_t * record;
+   uint64 pos, n, mask;
+
+   file_name = NULL;
+   csv = false;
+
+   for (i = 1; i < argc; i++) {
+      if (strcmp(argv[i],"-csv") == 0) {
+         csv = true;
+      } else if (file_name == NULL) {
+         file_name = argv[i];
+      } else {
+         fatal("usage: tracestat [-csv] file\n");
+      }
+   }
+
+   if (file_name == NULL) fatal("usage: tracestat [-csv] file\n");
+
+   fd = open(file_name,O_RDONLY);
+   if (fd < 0 || fstat(fd,&st) != 0) fatal("tracestat: can't open file \"%s\": %s\n",file_name,strerror(errno));
+
+   if (st.st_size < sint64(sizeof(trace_header_t))) fatal("tracestat: \"%s\" is not a trace file\n",file_name);
+
+   map = mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+   if (map == MAP_FAILED) fatal("tracestat: mmap(): %s\n",strerror(errno));
+
+   header = (const trace_header_t *) map;
+   record = (const trace_record_t *) (header + 1);
+
+   if (memcmp(header->magic,TraceMagic,sizeof(TraceMagic)) != 0
+    || header->record_size != sizeof(trace_record_t)
+    || sizeof(trace_header_t) + uint64(header->record_nb) * sizeof(trace_record_t) > uint64(st.st_size)) {
+      fatal("tracestat: \"%s\" is not a trace file\n",file_name);
+   }
+
+   // the ring holds the last record_nb records
+
+   pos = header->pos;
+   mask = header->record_nb - 1;
+   n = (pos < header->record_nb) ? pos : header->record_nb;
+
+   StackSize = 0;
+
+   for (uint64 p = pos - n; p < pos; p++) replay(&record[p&mask]);
+
+   if (!csv) {
+      printf("%s: " S64_FORMAT " records (" S64_FORMAT " kept), %d searches, " S64_FORMAT " orphan exits\n\n",
+             file_name,sint64(pos),sint64(n),SearchNb,sint64(OrphanNb));
+   }
+
+   report(csv);
+
+   munmap(map,st.st_size);
+   close(fd);
+
+   return EXIT_SUCCESS;
+}
+
+// replay()
+
+static void replay(const trace_record_t * record) {
+
+   frame_t * frame;
+   ply_t * ply;
+   uint64 size;
+   int height;
+
+   switch (record->type) {
+
+   case TraceSearch:
+   case TraceIteration:
+
+      // a stopped search leaves its nodes open
+
+      if (record->type == TraceSearch) SearchNb++;
+      StackSize = 0;
+      break;
+
+   case TraceEnter:
+   case TraceEnterQS:
+
+      height = record->height;
+      ply = &Ply[height];
+
+      ply->node_nb++;
+      if (record->type == TraceEnterQS) ply->qs_nb++;
+
+      if (StackSize > 0) Stack[StackSize-1].child_nb++;
+
+      if (StackSize < HeightMax*2) {
+         frame = &Stack[StackSize++];
+         frame->height = height;
+         frame->first_node = NodeNb;
+         frame->child_nb = 0;
+      }
+
+      NodeNb++;
+      break;
+
+   case TraceExit:
+
+      if (StackSize == 0 || Stack[StackSize-1].height != record->height) {
+         OrphanNb++;
+         StackSize = 0;
+         break;
+      }
+
+      frame = &Stack[--StackSize];
+      ply = &Ply[frame->height];
+
+      size = NodeNb - frame->first_node;
+
+      ply->exit_nb++;
+      ply->subtree_sum += double(size);
+      if (size > ply->subtree_max) ply->subtree_max = size;
+
+      if (frame->child_nb != 0) {
+         ply->interior_nb++;
+         ply->child_nb += frame->child_nb;
+      }
+
+      if (record->reason < TraceReasonNb) ply->reason_nb[record->reason]++;
+
+      Bucket[log2_of(size)]++;
+      break;
+   }
+}
+
+// report()
+
+static void report(bool csv) {
+
+   int height, reason, i;
+   const ply_t * ply;
+   double qs, bf, ebf, avg;
+
+   if (csv) {
+      printf("ply,nodes,qs_pct,interior,branching,effective_branching,avg_subtree,max_subtree");
+      for (reason = 0; reason < TraceReasonNb; reason++) printf(",%s",ReasonName[reason]);
+      printf("\n");
+   } else {
+      printf("ply        nodes    qs%%  interior  branch  eff.bf  avg.subtree  max.subtree  cutoffs\n");
+   }
+
+   for (height = 0; height < HeightMax; height++) {
+
+      ply = &Ply[height];
+      if (ply->node_nb == 0) continue;
+
+      qs = double(ply->qs_nb) * 100.0 / double(ply->node_nb);
+      bf = (ply->interior_nb != 0) ? double(ply->child_nb) / double(ply->interior_nb) : 0.0;
+      ebf = (height+1 < HeightMax) ? double(Ply[height+1].node_nb) / double(ply->node_nb) : 0.0;
+      avg = (ply->exit_nb != 0) ? ply->subtree_sum / double(ply->exit_nb) : 0.0;
+
+      if (csv) {
+
+         printf("%d," S64_FORMAT ",%.1f," S64_FORMAT ",%.2f,%.2f,%.1f," S64_FORMAT,
+                height,sint64(ply->node_nb),qs,sint64(ply->interior_nb),bf,ebf,avg,sint64(ply->subtree_max));
+         for (reason = 0; reason < TraceReasonNb; reason++) printf("," S64_FORMAT,sint64(ply->reason_nb[reason]));
+         printf("\n");
+
+      } else {
+
+         printf("%3d %12lld %6.1f %9lld %7.2f %7.2f %12.1f %12lld ",
+                height,(long long)ply->node_nb,qs,(long long)ply->interior_nb,bf,ebf,avg,(long long)ply->subtree_max);
+
+         for (reason = 0; reason < TraceReasonNb; reason++) {
+            if (ply->reason_nb[reason] != 0 && ply->exit_nb != 0) {
+               printf(" %s %.0f%%",ReasonName[reason],double(ply->reason_nb[reason])*100.0/double(ply->exit_nb));
+            }
+         }
+
+         printf("\n");
+      }
+   }
+
+   if (!csv) {
+
+      printf("\nsubtree sizes\n");
+
+      for (i = 0; i < BucketNb; i++) {
+         if (Bucket[i] != 0) printf("  < %-12lld %12lld\n",1LL<<(i+1),(long long)Bucket[i]);
+      }
+   }
+}
+
+// log2_of()
+
+static int log2_of(uint64 n) {
+
+   int i;
+
+   for (i = 0; n > 1 && i < BucketNb-1; i++) n >>= 1;
+
+   return i;
+}
+
+// fatal()
+
+static void fatal(const char format[], ...) {
+
+   va_list ap;
+
+   va_start(ap,format);
+   vfprintf(stderr,format,ap);
+   va_end(ap);
+
+   exit(EXIT_FAILURE);
+}
+
+// end of tracestat.cpp